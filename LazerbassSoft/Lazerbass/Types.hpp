@@ -1,7 +1,11 @@
 #pragma once
 #include <cstdint>
 
-struct StereoSample {
-    int16_t left;
-    int16_t right;
+template<class T>
+struct BasicStereoSample {
+    T left;
+    T right;
 };
+
+using StereoSample16 = BasicStereoSample<int16_t>;
+using StereoSample32 = BasicStereoSample<int32_t>; // 24bit(左对齐)和32bit帧
@@ -14,22 +14,54 @@ namespace bsp {
 static I2S_HandleTypeDef hi2s_;
 static DMA_HandleTypeDef hdma_;
 
-_DMA_SRAMD1 static StereoSample dmaBuffer_[PCM5102::kBufferSize];
+_DMA_SRAMD1 static PCM5102::Sample dmaBuffer_[PCM5102::kBufferSize];
 static volatile uint32_t offset_ = 0;
 static SemaphoreHandle_t dmaSemHandle_ = NULL;
 static StaticSemaphore_t dmaSem_;
 constexpr auto kGenSize = PCM5102::kBlockSize;
 
+/* DMA每次搬运一个声道 */
+using DmaWord = decltype(PCM5102::Sample::left);
+constexpr uint32_t kDmaDataAlign = sizeof(DmaWord) == 2 ? DMA_PDATAALIGN_HALFWORD : DMA_PDATAALIGN_WORD;
+constexpr uint32_t kDmaMemAlign = sizeof(DmaWord) == 2 ? DMA_MDATAALIGN_HALFWORD : DMA_MDATAALIGN_WORD;
+constexpr uint32_t kI2SDataFormat = PCM5102::kBitDepth == 16 ? I2S_DATAFORMAT_16B
+                                  : PCM5102::kBitDepth == 24 ? I2S_DATAFORMAT_24B
+                                  : I2S_DATAFORMAT_32B;
+
+/* PLL2P作为SPI123时钟, HSE 25MHz / 5 = 5MHz
+ * 48k/32k: 5MHz * (78 + 5269/8192) / 8 = 49.152MHz = 256 * 48000 * 4 = 256 * 32000 * 6
+ * 44.1k:   5MHz * (72 + 2076/8192) / 8 = 45.158MHz = 256 * 44100 * 4
+ * 直接用PLL1Q(400MHz)时48k和44.1k会偏差1%以上
+ */
+constexpr uint32_t kPll2N = PCM5102::kSampleRate == 44100 ? 72 : 78;
+constexpr uint32_t kPll2FracN = PCM5102::kSampleRate == 44100 ? 2076 : 5269;
+
 // --------------------------------------------------------------------------------
 // public
 // --------------------------------------------------------------------------------
 void PCM5102::Init() {
+    // i2s clock
+    RCC_PeriphCLKInitTypeDef periphClkInit{};
+    periphClkInit.PeriphClockSelection = RCC_PERIPHCLK_SPI123;
+    periphClkInit.Spi123ClockSelection = RCC_SPI123CLKSOURCE_PLL2;
+    periphClkInit.PLL2.PLL2M = 5;
+    periphClkInit.PLL2.PLL2N = kPll2N;
+    periphClkInit.PLL2.PLL2P = 8;
+    periphClkInit.PLL2.PLL2Q = 8;
+    periphClkInit.PLL2.PLL2R = 8;
+    periphClkInit.PLL2.PLL2RGE = RCC_PLL2VCIRANGE_2;
+    periphClkInit.PLL2.PLL2VCOSEL = RCC_PLL2VCOWIDE;
+    periphClkInit.PLL2.PLL2FRACN = kPll2FracN;
+    if (HAL_RCCEx_PeriphCLKConfig(&periphClkInit) != HAL_OK) {
+        DEVICE_ERROR("AudioOut", "HAL_RCCEx_PeriphCLKConfig");
+    }
+
     // i2s init
     __HAL_RCC_SPI1_CLK_ENABLE();
     hi2s_.Instance = SPI1;
     hi2s_.Init.Mode = I2S_MODE_MASTER_TX;
     hi2s_.Init.Standard = I2S_STANDARD_PHILIPS;
-    hi2s_.Init.DataFormat = I2S_DATAFORMAT_16B;
+    hi2s_.Init.DataFormat = kI2SDataFormat;
     hi2s_.Init.MCLKOutput = I2S_MCLKOUTPUT_ENABLE;
     hi2s_.Init.AudioFreq = kSampleRate;
     hi2s_.Init.CPOL = I2S_CPOL_LOW;
@@ -46,8 +78,8 @@ void PCM5102::Init() {
     hdma_.Init.Direction = DMA_MEMORY_TO_PERIPH;
     hdma_.Init.PeriphInc = DMA_PINC_DISABLE;
     hdma_.Init.MemInc = DMA_MINC_ENABLE;
-    hdma_.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
-    hdma_.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_.Init.PeriphDataAlignment = kDmaDataAlign;
+    hdma_.Init.MemDataAlignment = kDmaMemAlign;
     hdma_.Init.Mode = DMA_CIRCULAR;
     hdma_.Init.Priority = DMA_PRIORITY_VERY_HIGH;
     hdma_.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
@@ -88,7 +120,7 @@ void PCM5102::Init() {
 }
 
 void PCM5102::Start() {
-    HAL_I2S_Transmit_DMA(&hi2s_, (uint16_t*)dmaBuffer_, sizeof(dmaBuffer_) / sizeof(uint16_t));
+    HAL_I2S_Transmit_DMA(&hi2s_, (uint16_t*)dmaBuffer_, sizeof(dmaBuffer_) / sizeof(DmaWord));
 }
 
 void PCM5102::Stop() {
@@ -101,9 +133,9 @@ void PCM5102::DeInit() {
     dmaSemHandle_ = NULL;
 }
 
-std::span<StereoSample> PCM5102::GetNextBlock() {
+std::span<PCM5102::Sample> PCM5102::GetNextBlock() {
     xSemaphoreTake(dmaSemHandle_, portMAX_DELAY);
-    return std::span<StereoSample>(dmaBuffer_ + offset_, kGenSize);
+    return std::span<Sample>(dmaBuffer_ + offset_, kGenSize);
 }
 
 // --------------------------------------------------------------------------------
@@ -1,22 +1,29 @@
 #pragma once
 #include <span>
 #include <cstdint>
+#include <type_traits>
 #include "Types.hpp"
 
 namespace bsp {
 
 class PCM5102 {
 public:
-    static constexpr uint32_t kSampleRate = 32000;
+    /* 修改后重新编译, kSampleRate: 32000/44100/48000, kBitDepth: 16/24/32 */
+    static constexpr uint32_t kSampleRate = 48000;
+    static constexpr uint32_t kBitDepth = 24;
     static constexpr uint32_t kBufferSize = 1024;
     static constexpr uint32_t kBlockSize = PCM5102::kBufferSize / 2;
 
+    static_assert(kSampleRate == 32000 || kSampleRate == 44100 || kSampleRate == 48000);
+    static_assert(kBitDepth == 16 || kBitDepth == 24 || kBitDepth == 32);
+    using Sample = std::conditional_t<kBitDepth == 16, StereoSample16, StereoSample32>;
+
     static void Init();
     static void Start();
     static void Stop();
     static void DeInit();
 
-    static std::span<StereoSample> GetNextBlock();
+    static std::span<Sample> GetNextBlock();
 };
 
 }
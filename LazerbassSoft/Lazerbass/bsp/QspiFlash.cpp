@@ -0,0 +1,209 @@
+#include "QspiFlash.hpp"
+#include "stm32h7xx_hal.h"
+
+#include "SystemHook.hpp"
+
+#include <algorithm>
+
+namespace bsp {
+
+enum : uint8_t {
+    kCmdWriteEnable = 0x06,
+    kCmdReadStatus1 = 0x05,
+    kCmdReadStatus2 = 0x35,
+    kCmdWriteStatus2 = 0x31,
+    kCmdQuadPageProgram = 0x32,
+    kCmdBlockErase64K = 0xd8,
+    kCmdFastReadQuadOutput = 0x6b,
+    kCmdEnableReset = 0x66,
+    kCmdReset = 0x99,
+};
+
+static constexpr uint8_t kStatus1Busy = 0x01;
+static constexpr uint8_t kStatus1WriteEnabled = 0x02;
+static constexpr uint8_t kStatus2QuadEnable = 0x02;
+
+static constexpr uint32_t kCommandTimeout = 100;    // ms
+static constexpr uint32_t kProgramTimeout = 10;     // ms, 页编程最多3ms
+static constexpr uint32_t kEraseTimeout = 3000;     // ms, 64K块擦除最多2s
+
+static QSPI_HandleTypeDef hqspi_;
+
+// 1线指令, 没有地址和数据
+static QSPI_CommandTypeDef MakeCommand(uint8_t instruction) {
+    QSPI_CommandTypeDef cmd{};
+    cmd.InstructionMode = QSPI_INSTRUCTION_1_LINE;
+    cmd.Instruction = instruction;
+    cmd.AddressMode = QSPI_ADDRESS_NONE;
+    cmd.AddressSize = QSPI_ADDRESS_24_BITS;
+    cmd.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+    cmd.DataMode = QSPI_DATA_NONE;
+    cmd.DummyCycles = 0;
+    cmd.DdrMode = QSPI_DDR_MODE_DISABLE;
+    cmd.DdrHoldHalfCycle = QSPI_DDR_HHC_ANALOG_DELAY;
+    cmd.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;
+    return cmd;
+}
+
+static bool SendCommand(uint8_t instruction) {
+    auto cmd = MakeCommand(instruction);
+    return HAL_QSPI_Command(&hqspi_, &cmd, kCommandTimeout) == HAL_OK;
+}
+
+/* 轮询状态寄存器1直到(status & mask) == match */
+static bool WaitStatus(uint8_t mask, uint8_t match, uint32_t timeout) {
+    auto cmd = MakeCommand(kCmdReadStatus1);
+    cmd.DataMode = QSPI_DATA_1_LINE;
+    cmd.NbData = 1;
+
+    QSPI_AutoPollingTypeDef polling{};
+    polling.Match = match;
+    polling.Mask = mask;
+    polling.MatchMode = QSPI_MATCH_MODE_AND;
+    polling.StatusBytesSize = 1;
+    polling.Interval = 0x10;
+    polling.AutomaticStop = QSPI_AUTOMATIC_STOP_ENABLE;
+    return HAL_QSPI_AutoPolling(&hqspi_, &cmd, &polling, timeout) == HAL_OK;
+}
+
+static bool WriteEnable() {
+    return SendCommand(kCmdWriteEnable)
+        && WaitStatus(kStatus1WriteEnabled, kStatus1WriteEnabled, kCommandTimeout);
+}
+
+static bool EnableQuad() {
+    auto cmd = MakeCommand(kCmdReadStatus2);
+    cmd.DataMode = QSPI_DATA_1_LINE;
+    cmd.NbData = 1;
+    uint8_t status2 = 0;
+    if (HAL_QSPI_Command(&hqspi_, &cmd, kCommandTimeout) != HAL_OK
+        || HAL_QSPI_Receive(&hqspi_, &status2, kCommandTimeout) != HAL_OK) {
+        return false;
+    }
+    if (status2 & kStatus2QuadEnable) {
+        return true;
+    }
+
+    status2 |= kStatus2QuadEnable;
+    cmd.Instruction = kCmdWriteStatus2;
+    return WriteEnable()
+        && HAL_QSPI_Command(&hqspi_, &cmd, kCommandTimeout) == HAL_OK
+        && HAL_QSPI_Transmit(&hqspi_, &status2, kCommandTimeout) == HAL_OK
+        && WaitStatus(kStatus1Busy, 0, kCommandTimeout);
+}
+
+static bool EnterMemoryMapped() {
+    auto cmd = MakeCommand(kCmdFastReadQuadOutput);
+    cmd.AddressMode = QSPI_ADDRESS_1_LINE;
+    cmd.DataMode = QSPI_DATA_4_LINES;
+    cmd.DummyCycles = 8;
+
+    QSPI_MemoryMappedTypeDef mapped{};
+    mapped.TimeOutActivation = QSPI_TIMEOUT_COUNTER_DISABLE;
+    return HAL_QSPI_MemoryMapped(&hqspi_, &cmd, &mapped) == HAL_OK;
+}
+
+/* 内存映射模式下不能发送其他指令 */
+static bool LeaveMemoryMapped() {
+    return HAL_QSPI_Abort(&hqspi_) == HAL_OK;
+}
+
+bool QspiFlash::Init() {
+    // gpio init
+    // PF10 -> CLK
+    // PG6 -> NCS
+    // PF8 -> IO0, PF9 -> IO1, PF7 -> IO2, PF6 -> IO3
+    __HAL_RCC_GPIOF_CLK_ENABLE();
+    __HAL_RCC_GPIOG_CLK_ENABLE();
+    GPIO_InitTypeDef gpioInit{};
+    gpioInit.Mode = GPIO_MODE_AF_PP;
+    gpioInit.Pull = GPIO_NOPULL;
+    gpioInit.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+
+    gpioInit.Alternate = GPIO_AF9_QUADSPI;
+    gpioInit.Pin = GPIO_PIN_10 | GPIO_PIN_7 | GPIO_PIN_6;
+    HAL_GPIO_Init(GPIOF, &gpioInit);
+    gpioInit.Alternate = GPIO_AF10_QUADSPI;
+    gpioInit.Pin = GPIO_PIN_8 | GPIO_PIN_9;
+    HAL_GPIO_Init(GPIOF, &gpioInit);
+    gpioInit.Pull = GPIO_PULLUP;
+    gpioInit.Pin = GPIO_PIN_6;
+    HAL_GPIO_Init(GPIOG, &gpioInit);
+
+    // qspi init, 内核时钟hclk3 200MHz / 3
+    __HAL_RCC_QSPI_CLK_ENABLE();
+    __HAL_RCC_QSPI_FORCE_RESET();
+    __HAL_RCC_QSPI_RELEASE_RESET();
+    hqspi_.Instance = QUADSPI;
+    hqspi_.Init.ClockPrescaler = 2;
+    hqspi_.Init.FifoThreshold = 4;
+    hqspi_.Init.SampleShifting = QSPI_SAMPLE_SHIFTING_HALFCYCLE;
+    hqspi_.Init.FlashSize = POSITION_VAL(kChipSize) - 1;
+    hqspi_.Init.ChipSelectHighTime = QSPI_CS_HIGH_TIME_4_CYCLE;
+    hqspi_.Init.ClockMode = QSPI_CLOCK_MODE_0;
+    hqspi_.Init.FlashID = QSPI_FLASH_ID_1;
+    hqspi_.Init.DualFlash = QSPI_DUALFLASH_DISABLE;
+    if (auto res = HAL_QSPI_Init(&hqspi_);
+        res != HAL_OK) {
+        DEVICE_ERROR_CODE("QspiFlash", "HAL_QSPI_Init failed", res);
+        return false;
+    }
+
+    // 芯片复位, 打开四线模式
+    ready_ = SendCommand(kCmdEnableReset)
+          && SendCommand(kCmdReset)
+          && WaitStatus(kStatus1Busy, 0, kCommandTimeout)
+          && EnableQuad()
+          && EnterMemoryMapped();
+    if (!ready_) {
+        DEVICE_ERROR_CODE("QspiFlash", "flash init failed", hqspi_.ErrorCode);
+    }
+    return ready_;
+}
+
+/* 按页写入, 调用者保证offset按kProgramUnit对齐, 一个kProgramUnit不会跨页 */
+bool QspiFlash::Program(uint32_t offset, std::span<const uint8_t> data) {
+    if (!ready_ || !LeaveMemoryMapped()) {
+        return false;
+    }
+
+    bool ok = true;
+    uint32_t pos = 0;
+    while (pos < data.size() && ok) {
+        const uint32_t address = offset + pos;
+        const uint32_t size = std::min<uint32_t>(kPageSize - address % kPageSize, data.size() - pos);
+
+        auto cmd = MakeCommand(kCmdQuadPageProgram);
+        cmd.AddressMode = QSPI_ADDRESS_1_LINE;
+        cmd.Address = address;
+        cmd.DataMode = QSPI_DATA_4_LINES;
+        cmd.NbData = size;
+        ok = WriteEnable()
+          && HAL_QSPI_Command(&hqspi_, &cmd, kCommandTimeout) == HAL_OK
+          && HAL_QSPI_Transmit(&hqspi_, const_cast<uint8_t*>(data.data() + pos), kCommandTimeout) == HAL_OK
+          && WaitStatus(kStatus1Busy, 0, kProgramTimeout);
+        pos += size;
+    }
+
+    return EnterMemoryMapped() && ok;
+}
+
+bool QspiFlash::EraseSector(uint32_t sector) {
+    if (!ready_ || sector >= kNumSectors || !LeaveMemoryMapped()) {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t block = 0; block < kSectorSize / kBlockSize && ok; ++block) {
+        auto cmd = MakeCommand(kCmdBlockErase64K);
+        cmd.AddressMode = QSPI_ADDRESS_1_LINE;
+        cmd.Address = sector * kSectorSize + block * kBlockSize;
+        ok = WriteEnable()
+          && HAL_QSPI_Command(&hqspi_, &cmd, kCommandTimeout) == HAL_OK
+          && WaitStatus(kStatus1Busy, 0, kEraseTimeout);
+    }
+
+    return EnterMemoryMapped() && ok;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "preset/FlashDevice.hpp"
+
+namespace bsp {
+
+/**
+ * @brief QSPI上的W25Q64 NOR flash, 平时处于内存映射模式, 从0x90000000直接读取
+ *        擦写时退出内存映射模式, 完成后再进入; 只有GUI任务等待, 音频任务不访问这段地址
+ *        预设区在芯片开头, 128K一个扇区(两个64K块)
+ */
+class QspiFlash : public preset::FlashDevice {
+public:
+    static constexpr uint32_t kBaseAddress = 0x90000000;
+    static constexpr uint32_t kChipSize = 8 * 1024 * 1024;
+    static constexpr uint32_t kBlockSize = 64 * 1024;   // 芯片的擦除单位
+    static constexpr uint32_t kPageSize = 256;          // 芯片的编程单位
+    static constexpr uint32_t kSectorSize = 128 * 1024;
+    static constexpr uint32_t kNumSectors = 4;
+
+    /**
+     * @brief 初始化QSPI和芯片并进入内存映射模式, 失败时返回false, 之后的擦写都失败
+     */
+    bool Init();
+
+    const uint8_t* GetBase() const override { return reinterpret_cast<const uint8_t*>(kBaseAddress); }
+    uint32_t GetSectorSize() const override { return kSectorSize; }
+    uint32_t GetNumSectors() const override { return ready_ ? kNumSectors : 0; }
+    bool Program(uint32_t offset, std::span<const uint8_t> data) override;
+    bool EraseSector(uint32_t sector) override;
+
+private:
+    bool ready_{};
+};
+
+}
@@ -17,6 +17,12 @@ void Time::Init() {
     htim_.Init.RepetitionCounter = 0;
     HAL_TIM_Base_Init(&htim_);
     HAL_TIM_Base_Start(&htim_);
+
+    // cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 uint32_t Time::GetTick() {
@@ -27,4 +33,12 @@ void Time::ClearCounter() {
     __HAL_TIM_SET_COUNTER(&htim_, 0);
 }
 
+uint32_t Time::GetCycles() {
+    return DWT->CYCCNT;
+}
+
+uint32_t Time::GetCpuClock() {
+    return SystemCoreClock;
+}
+
 }
\ No newline at end of file
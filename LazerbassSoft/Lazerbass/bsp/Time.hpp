@@ -11,6 +11,10 @@ public:
     static uint32_t GetTick();
     static void ClearCounter();
 
+    /* DWT周期计数器, 用于测量dsp代码的开销和MIDI消息的到达时间 */
+    static uint32_t GetCycles();
+    static uint32_t GetCpuClock();
+
     static constexpr uint32_t Tick2Ms(uint32_t tick) {
         return tick * kUsPerTick / 1000;
     }
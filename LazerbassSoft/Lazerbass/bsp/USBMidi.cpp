@@ -7,6 +7,7 @@
 #include "usbd_midi.h"
 
 #include "SystemHook.hpp"
+#include "Time.hpp"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -66,10 +67,13 @@ MidiEvent* USBMidi::GetNextEvent() {
 // IRQ
 // --------------------------------------------------------------------------------
 extern "C" void USBD_MIDI_DataInHandler(uint8_t* usb_rx_buffer, uint8_t usb_rx_buffer_length) {
+    // 一个USB包里的消息同时到达, 在中断里取时间, 不受UsbTask调度延迟的影响
+    const uint32_t cycles = Time::GetCycles();
     while (usb_rx_buffer_length && *usb_rx_buffer != 0x00)
     {
         uint32_t v = (usb_rx_buffer[3] << 24) | (usb_rx_buffer[2] << 16) | (usb_rx_buffer[1] << 8) | usb_rx_buffer[0];
-        memcpy(&midiRxBuffer_[wpos_++], &v, 4);
+        memcpy(&midiRxBuffer_[wpos_], &v, 4);
+        midiRxBuffer_[wpos_++].cycles = cycles;
 
         usb_rx_buffer += 4;
         usb_rx_buffer_length -= 4;
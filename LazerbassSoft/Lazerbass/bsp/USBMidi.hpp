@@ -10,6 +10,7 @@ struct MidiEvent {
     uint8_t data1;
     uint8_t data2;
     uint8_t data3;
+    uint32_t cycles; // 收到的时间, 在USB中断里取DWT周期计数
 
     bool IsNoteOn() const { return codeIndexNumber == 9; }
     bool IsNoteOff() const { return codeIndexNumber == 8; }
@@ -17,8 +18,23 @@ struct MidiEvent {
     uint32_t GetChannel() const { return data1 & 0xf; }
     uint32_t GetVelocity() const { return data3; }
 
+    bool IsControlChange() const { return codeIndexNumber == 0xb; }
+    uint32_t GetController() const { return data2; }
+    uint32_t GetControllerValue() const { return data3; }
+
+    bool IsPolyPressure() const { return codeIndexNumber == 0xa; }
+    uint32_t GetPolyPressure() const { return data3; }
+    bool IsChannelPressure() const { return codeIndexNumber == 0xd; }
+    uint32_t GetChannelPressure() const { return data2; }
+
+    // 时钟, start, continue, stop是单字节的实时消息, song position是3字节的系统消息
+    bool IsRealtime() const { return codeIndexNumber == 0xf && data1 >= 0xf8; }
+    uint32_t GetStatus() const { return data1; }
+    bool IsSongPosition() const { return codeIndexNumber == 0x3 && data1 == 0xf2; }
+    uint32_t GetSongPosition() const { return (data2 & 0x7f) + ((data3 & 0x7f) << 7); } // 16分音符
+
     bool IsPitchBend() const { return codeIndexNumber == 0xe; }
-    uint32_t GetPitchBend() const { return (data2 & 0x7f) + ((data1 & 0x7f) << 7); }
+    uint32_t GetPitchBend() const { return (data2 & 0x7f) + ((data3 & 0x7f) << 7); } // 0~16383, 中间8192
 };
 
 class USBMidi {
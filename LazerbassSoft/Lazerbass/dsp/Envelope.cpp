@@ -1,75 +1,259 @@
 #include "Envelope.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace dsp {
 
+/* curve 0~1 对应目标越过终点的比例 1000~0.001, attack最多弯到RC充电的程度 */
+static constexpr float kLog2MaxRatio = 9.9657842847f; // log2(1000)
+static constexpr float kLog2RatioRange = 19.931568569f; // log2(1e6)
+static constexpr float kMinAttackRatio = 0.3f;
+
 void Envelope::Init(uint32_t sampleRate, uint32_t updateRate) {
-    invUpdateRate_ = static_cast<float>(updateRate) / sampleRate;
+    SetUpdateRate(sampleRate, updateRate);
+}
+
+void Envelope::SetUpdateRate(uint32_t sampleRate, uint32_t updateRate) {
+    // 跳过的Tick按原来的步长补上
+    if (skippedTicks_ > 0) {
+        UpdateCoefs();
+        CatchUp();
+    }
+    sampleRate_ = static_cast<float>(sampleRate);
+    tickTime_ = 1.0f / updateRate; // 一个Tick的秒数
+    SetStepTime(perSample_ ? 1.0f / sampleRate_ : tickTime_);
+}
+
+void Envelope::SetPerSample(bool perSample) {
+    if (perSample == perSample_) {
+        return;
+    }
+    if (skippedTicks_ > 0) {
+        UpdateCoefs();
+        CatchUp();
+    }
+    perSample_ = perSample;
+    SetStepTime(perSample ? 1.0f / sampleRate_ : tickTime_);
+}
+
+/* hold剩下的步数和总步数一起换算, UpdateCoefs只把参数的变化加到holdRemain_上 */
+void Envelope::SetStepTime(float stepTime) {
+    if (stepTime_ > 0.0f) {
+        float scale = stepTime_ / stepTime;
+        holdRemain_ *= scale;
+        holdSteps_ *= scale;
+    }
+    stepTime_ = stepTime;
+    coefValid_ = false;
 }
 
 void Envelope::Tick() {
+    UpdateCoefs();
+    if (skippedTicks_ > 0) {
+        CatchUp();
+    }
+    output_ = Step();
+}
+
+void Envelope::Render(float* gains, uint32_t numSamples) {
+    UpdateCoefs();
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        gains[i] = Step();
+    }
+    output_ = GetOutput();
+}
+
+/* 一步一次乘加, 到达终点时切换到下一段 */
+float Envelope::Step() {
     using enum State;
 
     switch (state_) {
     case kInit:
-        output_ = 0.0f;
         break;
-    case kAttack: {
-        float time = SynthParams::EnvVal01ToTime(envParams_.attack.Get());
-        if (time > envParams_.kMinTime) {
-            float inc = 1.0f / time * invUpdateRate_;
-            phase_ += inc;
-
-            if (phase_ > 1.0f) {
-                phase_ = 0.0f;
-                state_ = kRelease;
-            }
-            output_ = phase_ * envParams_.peak.Get();
+    case kHold:
+        holdRemain_ -= 1.0f;
+        if (holdRemain_ <= 0.0f) {
+            NextState();
         }
-        else {
-            state_ = kRelease;
-            phase_ = 0.0f;
+        break;
+    case kSustain: {
+        // sustain改变时平滑地跟过去
+        const auto& s = segments_[static_cast<uint32_t>(kSustain)];
+        level_ += (s.target - level_) * s.k;
+        break;
+    }
+    default: {
+        const auto& s = segments_[static_cast<uint32_t>(state_)];
+        level_ += (s.target - level_) * s.k;
+        bool done = state_ == kAttack ? level_ >= s.end : level_ <= s.end;
+        if (done) {
+            level_ = s.end;
+            NextState();
         }
+        break;
+    }
+    }
+    return GetOutput();
+}
+
+void Envelope::NextState() {
+    using enum State;
 
-        if (state_ == kAttack) {
+    switch (state_) {
+    case kAttack:
+        switch (envParams_.mode.Get()) {
+        case EnvelopeMode::kADSR:
+            state_ = kDecay;
+            break;
+        case EnvelopeMode::kAHDSR:
+            state_ = kHold;
+            holdRemain_ = holdSteps_;
+            break;
+        default:
+            state_ = kRelease;
             break;
         }
+        break;
+    case kHold:
+        state_ = kDecay;
+        break;
+    case kDecay:
+        state_ = kSustain;
+        break;
+    case kRelease:
+        state_ = kInit;
+        level_ = 0.0f;
+        break;
+    default:
+        break;
     }
-    [[fallthrough]];
-    case kRelease: {
-        float time = SynthParams::EnvVal01ToTime(envParams_.release.Get());
-        if (time > envParams_.kMinTime) {
-            float inc = 1.0f / time * invUpdateRate_;
-            phase_ += inc;
-
-            if (phase_ > 1.0f) {
-                phase_ = 1.0f;
-                state_ = kInit;
-                output_ = 0.0f;
-            }
-            else {
-                output_ = (1.0f - phase_) * envParams_.peak.Get();
+}
+
+/* 参数变化时重新计算各段的系数
+ * 从start到target的指数逼近在n步后剩下 (1-k)^n, 走完整个范围时剩下 ratio / (1 + ratio)
+ * k = 1 - exp(-log(1 + 1 / ratio) / n)
+ */
+void Envelope::UpdateCoefs() {
+    using enum State;
+
+    CoefKey key{
+        .attack = envParams_.attack.Get(),
+        .hold = envParams_.hold.Get(),
+        .decay = envParams_.decay.Get(),
+        .sustain = envParams_.sustain.Get(),
+        .peak = envParams_.peak.Get(),
+        .release = envParams_.release.Get(),
+        .curve = envParams_.curve.Get(),
+        .mode = envParams_.mode.Get(),
+    };
+    if (coefValid_ && key == coefKey_) {
+        return;
+    }
+    coefKey_ = key;
+    coefValid_ = true;
+
+    const float invStepTime = 1.0f / stepTime_;
+    auto getK = [invStepTime](float val01, float ratio) {
+        float time = SynthParams::EnvVal01ToTime(val01);
+        if (time <= SynthParams::EnvParamDesc::kMinTime) {
+            return 1.0f;
+        }
+        float steps = time * invStepTime;
+        return std::min(1.0f, -std::expm1(-std::log1p(1.0f / ratio) / steps));
+    };
+
+    const float ratio = std::exp2(kLog2MaxRatio - key.curve * kLog2RatioRange);
+    const float attackRatio = std::max(ratio, kMinAttackRatio);
+    const float sustainLevel = key.sustain * key.peak;
+
+    auto& attack = segments_[static_cast<uint32_t>(kAttack)];
+    attack.target = key.peak * (1.0f + attackRatio);
+    attack.k = getK(key.attack, attackRatio);
+    attack.end = key.peak;
+
+    auto& decay = segments_[static_cast<uint32_t>(kDecay)];
+    decay.target = sustainLevel - key.peak * ratio;
+    decay.k = getK(key.decay, ratio);
+    decay.end = sustainLevel;
+
+    auto& sustain = segments_[static_cast<uint32_t>(kSustain)];
+    sustain.target = sustainLevel;
+    sustain.k = decay.k;
+    sustain.end = sustainLevel;
+
+    auto& release = segments_[static_cast<uint32_t>(kRelease)];
+    release.target = -key.peak * ratio;
+    release.k = getK(key.release, ratio);
+    release.end = 0.0f;
+
+    float holdTime = SynthParams::EnvVal01ToTime(key.hold);
+    float holdSteps = holdTime > SynthParams::EnvParamDesc::kMinTime ? holdTime * invStepTime : 0.0f;
+    holdRemain_ += holdSteps - holdSteps_;
+    holdSteps_ = holdSteps;
+}
+
+/* 按现在的参数补上跳过的Tick, 一段走完时剩下的Tick留给下一段
+ * n步之后 level = target + (level - target) * (1-k)^n
+ */
+void Envelope::CatchUp() {
+    using enum State;
+
+    float ticks = static_cast<float>(skippedTicks_);
+    skippedTicks_ = 0;
+
+    while (ticks > 0.0f && state_ != kInit) {
+        if (state_ == kHold) {
+            if (ticks < holdRemain_) {
+                holdRemain_ -= ticks;
+                return;
             }
+            ticks -= std::max(std::ceil(holdRemain_), 1.0f);
+            NextState();
+            continue;
         }
-        else {
-            state_ = kInit;
-            output_ = 0.0f;
+
+        const auto& s = segments_[static_cast<uint32_t>(state_)];
+        if (s.k >= 1.0f) {
+            level_ = s.end;
+            if (state_ == kSustain) {
+                return;
+            }
+            ticks -= 1.0f;
+            NextState();
+            continue;
         }
-    }
-    }
 
-    if (envParams_.invert.Get()) {
-        output_ = 1.0f - output_;
+        float d = level_ - s.target;
+        float logMul = std::log1p(-s.k);
+        if (state_ != kSustain) {
+            float remain = std::max(std::ceil(std::log((s.end - s.target) / d) / logMul), 1.0f);
+            if (remain <= ticks) {
+                level_ = s.end;
+                ticks -= remain;
+                NextState();
+                continue;
+            }
+        }
+        level_ = s.target + d * std::exp(logMul * ticks);
+        return;
     }
 }
 
+/* 从现在的电平开始, 重新触发时不会跳到0 */
 void Envelope::GotoAttackState() {
+    if (skippedTicks_ > 0) {
+        UpdateCoefs();
+        CatchUp();
+    }
     state_ = State::kAttack;
-    phase_ = 0.0f;
 }
 
 void Envelope::GotoReleaseState() {
+    if (skippedTicks_ > 0) {
+        UpdateCoefs();
+        CatchUp();
+    }
     state_ = State::kRelease;
-    phase_ = 0.0f;
 }
 
 ModulatorDesc Envelope::GetModulatorDesc() {
@@ -79,4 +263,4 @@ ModulatorDesc Envelope::GetModulatorDesc() {
     return desc;
 }
 
-}
\ No newline at end of file
+}
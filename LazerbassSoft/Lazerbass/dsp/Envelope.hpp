@@ -4,32 +4,95 @@
 
 namespace dsp {
 
+/**
+ * @brief AR/ADSR/AHDSR包络
+ *        每一段都是朝着目标的指数逼近 level += (target - level) * k, 目标越过终点一点, 到达终点时进入下一段
+ *        curve为0时目标很远, 接近直线, 段的时间是从0走到peak(或者从peak走到0)的时间
+ *        系数只在参数改变时重新计算, 可以按Tick或者逐采样(ampEnv的vca)运行
+ */
 class Envelope {
 public:
     Envelope(SynthParams::EnvParamDesc& desc, SynthParams& params)
         : envParams_(desc), params_(params) {}
 
     void Init(uint32_t sampleRate, uint32_t updateRate);
+    void SetUpdateRate(uint32_t sampleRate, uint32_t updateRate);
     void Tick();
+    /**
+     * @brief 没有人使用输出时代替Tick, 下次Tick时一次补上跳过的时间
+     */
+    void Skip() { ++skippedTicks_; }
+
+    /**
+     * @brief 逐采样运行, 代替Tick, 输出增益(已经处理invert)
+     */
+    void Render(float* gains, uint32_t numSamples);
+    /**
+     * @brief 切换Tick和逐采样运行, 系数按新的步长重新计算
+     */
+    void SetPerSample(bool perSample);
 
     void GotoAttackState();
     void GotoReleaseState();
+    bool IsIdle() const { return state_ == State::kInit; }
 
     float* GetOutputReg() { return &output_; }
     ModulatorDesc GetModulatorDesc();
 
 private:
+    enum class State {
+        kInit,
+        kAttack,
+        kHold,
+        kDecay,
+        kSustain,
+        kRelease,
+        kCount
+    };
+    /* level += (target - level) * k, 越过end时结束 */
+    struct Segment {
+        float target;
+        float k;
+        float end;
+    };
+    /* 影响系数的参数 */
+    struct CoefKey {
+        float attack;
+        float hold;
+        float decay;
+        float sustain;
+        float peak;
+        float release;
+        float curve;
+        EnvelopeMode mode;
+
+        bool operator==(const CoefKey&) const = default;
+    };
+
+    void CatchUp();
+    void SetStepTime(float stepTime);
+    void UpdateCoefs();
+    void NextState();
+    float Step();
+    float GetOutput() const { return envParams_.invert.Get() ? 1.0f - level_ : level_; }
+
     SynthParams::EnvParamDesc& envParams_;
     SynthParams& params_;
     float output_{};
 
-    float invUpdateRate_{};
-    enum class State {
-        kInit,
-        kAttack,
-        kRelease
-    } state_;
-    float phase_{};
+    float sampleRate_{};
+    float tickTime_{};
+    float stepTime_{}; // 每一步的秒数
+    bool perSample_{};
+
+    State state_{};
+    float level_{};
+    float holdSteps_{};
+    float holdRemain_{};
+    Segment segments_[static_cast<uint32_t>(State::kCount)]{};
+    CoefKey coefKey_{};
+    bool coefValid_{};
+    uint32_t skippedTicks_{};
 };
 
 }
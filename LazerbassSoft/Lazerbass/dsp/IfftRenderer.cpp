@@ -0,0 +1,291 @@
+#include "IfftRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numbers>
+
+#include "mcu/Memory.hpp"
+
+namespace dsp {
+
+/* 4项blackman-harris, 旁瓣-92dB, 主瓣宽度±4个bin */
+static constexpr double kWindowCoefs[] = { 0.35875, 0.48829, 0.14128, 0.01168 };
+
+static constexpr float kTwoPi = std::numbers::pi_v<float> * 2.0f;
+
+/* 象限折叠到±pi/4后用泰勒展开, 误差小于1e-6 */
+static inline void FastSinCos(float x, float& s, float& c) {
+    constexpr float kInvHalfPi = 2.0f / std::numbers::pi_v<float>;
+    constexpr float kHalfPi = std::numbers::pi_v<float> / 2.0f;
+    float quadrant = std::round(x * kInvHalfPi);
+    float r = x - quadrant * kHalfPi;
+    float r2 = r * r;
+    float sr = r * (1.0f + r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f))));
+    float cr = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+    switch (static_cast<int32_t>(quadrant) & 3) {
+    case 0:
+        s = sr;
+        c = cr;
+        break;
+    case 1:
+        s = cr;
+        c = -sr;
+        break;
+    case 2:
+        s = -sr;
+        c = -cr;
+        break;
+    default:
+        s = -cr;
+        c = sr;
+        break;
+    }
+}
+
+/* 中心对称的长度N的矩形窗在d个bin处的频谱(实部) */
+static double RectSpectrum(double d) {
+    constexpr double kN = IfftRenderer::kFftSize;
+    double alpha = 2.0 * std::numbers::pi * d / kN;
+    if (std::abs(alpha) < 1e-9) {
+        return kN;
+    }
+    double m = kN / 2.0;
+    return std::sin((m + 0.5) * alpha) / std::sin(alpha / 2.0) - std::cos(m * alpha);
+}
+
+void IfftRenderer::Init(float maxFreq) {
+    constexpr uint32_t kHalfSize = kFftSize / 2;
+
+    maxFreq_ = std::min(maxFreq, GetMaxFreq());
+
+    for (uint32_t i = 0; i < kHalfSize; ++i) {
+        double phase = 2.0 * std::numbers::pi * i / kFftSize;
+        twiddleCos_[i] = static_cast<float>(std::cos(phase));
+        twiddleSin_[i] = static_cast<float>(std::sin(phase));
+    }
+
+    uint32_t numBits = 0;
+    while ((1u << numBits) < kHalfSize) {
+        ++numBits;
+    }
+    for (uint32_t i = 0; i < kHalfSize; ++i) {
+        uint32_t rev = 0;
+        for (uint32_t b = 0; b < numBits; ++b) {
+            rev |= ((i >> b) & 1) << (numBits - 1 - b);
+        }
+        bitReverse_[i] = static_cast<uint16_t>(rev);
+    }
+
+    /* 主瓣, 包含cos的1/2, 反变换的1/N, 实数拆分省掉的1/2和半长FFT的N/2, 合起来是1/(2N) */
+    for (uint32_t i = 0; i < std::size(lobe_); ++i) {
+        double d = static_cast<double>(i) / kLobeResolution;
+        double w = kWindowCoefs[0] * RectSpectrum(d);
+        for (uint32_t j = 1; j < std::size(kWindowCoefs); ++j) {
+            w += kWindowCoefs[j] * 0.5 * (RectSpectrum(d - j) + RectSpectrum(d + j));
+        }
+        lobe_[i] = static_cast<float>(w / (2.0 * kFftSize));
+    }
+
+    /* 去掉合成窗再乘三角窗, 中间2*hop个采样处窗函数最小约0.22 */
+    for (uint32_t i = 0; i < 2 * kHopSize; ++i) {
+        double n = static_cast<double>(kFftSize / 2 - kHopSize + i);
+        double phase = 2.0 * std::numbers::pi * n / kFftSize;
+        double window = kWindowCoefs[0] - kWindowCoefs[1] * std::cos(phase)
+                      + kWindowCoefs[2] * std::cos(2.0 * phase) - kWindowCoefs[3] * std::cos(3.0 * phase);
+        double triangle = 1.0 - std::abs(static_cast<double>(i) - kHopSize) / kHopSize;
+        synthWindow_[i] = static_cast<float>(triangle / window);
+    }
+
+    std::fill_n(olaLeft_, std::size(olaLeft_), 0.0f);
+    std::fill_n(olaRight_, std::size(olaRight_), 0.0f);
+    hopPos_ = kHopSize;
+}
+
+float IfftRenderer::Lobe(float absBin) const {
+    float pos = absBin * kLobeResolution;
+    auto idx = static_cast<uint32_t>(pos);
+    float frac = pos - idx;
+    return lobe_[idx] + (lobe_[idx + 1] - lobe_[idx]) * frac;
+}
+
+void IfftRenderer::Start(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+                         uint32_t numPartials, bool stereo) {
+    /* 把以当前采样为中心的一帧放进叠加缓冲, 之后第一个hop就是完整的两帧叠加, 不会淡入 */
+    std::fill_n(olaLeft_, std::size(olaLeft_), 0.0f);
+    std::fill_n(olaRight_, std::size(olaRight_), 0.0f);
+    SynthFrame(freqs, gains, panLefts, panRights, numPartials, stereo);
+    hopPos_ = kHopSize;
+}
+
+void IfftRenderer::Render(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+                          uint32_t numPartials, bool stereo, float* left, float* right, uint32_t numSamples) {
+    uint32_t pos = 0;
+    while (pos < numSamples) {
+        if (hopPos_ == kHopSize) {
+            std::copy_n(olaLeft_ + kHopSize, kHopSize, olaLeft_);
+            std::fill_n(olaLeft_ + kHopSize, kHopSize, 0.0f);
+            std::copy_n(olaRight_ + kHopSize, kHopSize, olaRight_);
+            std::fill_n(olaRight_ + kHopSize, kHopSize, 0.0f);
+            SynthFrame(freqs, gains, panLefts, panRights, numPartials, stereo);
+            hopPos_ = 0;
+        }
+
+        uint32_t n = std::min(kHopSize - hopPos_, numSamples - pos);
+        std::copy_n(olaLeft_ + hopPos_, n, left + pos);
+        if (stereo) {
+            std::copy_n(olaRight_ + hopPos_, n, right + pos);
+        }
+        hopPos_ += n;
+        pos += n;
+    }
+}
+
+_CODE_ITCM void IfftRenderer::SynthFrame(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+                                         uint32_t numPartials, bool stereo) {
+    constexpr float kBinsPerRadian = kFftSize / kTwoPi;
+    constexpr float kHop = static_cast<float>(kHopSize);
+    constexpr float kInvTwoPi = 1.0f / kTwoPi;
+
+    std::fill_n(leftRe_, kNumBins, 0.0f);
+    std::fill_n(leftIm_, kNumBins, 0.0f);
+    if (stereo) {
+        std::fill_n(rightRe_, kNumBins, 0.0f);
+        std::fill_n(rightIm_, kNumBins, 0.0f);
+    }
+
+    for (uint32_t i = 0; i < numPartials; ++i) {
+        float w = freqs[i];
+        float theta = phases_[i];
+
+        // 下一帧的相位
+        float next = theta + w * kHop;
+        phases_[i] = next - kTwoPi * std::floor(next * kInvTwoPi);
+
+        float g = gains[i];
+        if (g == 0.0f || w < 0.0f || w > maxFreq_) {
+            continue;
+        }
+
+        /* X[k] = (-1)^k * g/2 * e^(j(theta - pi/2)) * W(k - f), 窗以帧中心对称所以有(-1)^k
+         * 负频率的部分落在k<0, 共轭后折叠到-k
+         */
+        float s;
+        float c;
+        FastSinCos(theta, s, c);
+        float f = w * kBinsPerRadian;
+        auto k = static_cast<int32_t>(f) - static_cast<int32_t>(kLobeBins / 2 - 1);
+        float d = k - f;
+        float sign = (k & 1) ? -1.0f : 1.0f;
+        float ar = g * s * sign;
+        float ai = -g * c * sign;
+
+        if (stereo) {
+            float pl = panLefts[i];
+            float pr = panRights[i];
+            for (uint32_t j = 0; j < kLobeBins; ++j, ++k, d += 1.0f) {
+                float lobe = Lobe(std::abs(d));
+                float re = ar * lobe;
+                float im = ai * lobe;
+                if (k > 0) {
+                    leftRe_[k] += re * pl;
+                    leftIm_[k] += im * pl;
+                    rightRe_[k] += re * pr;
+                    rightIm_[k] += im * pr;
+                }
+                else if (k < 0) {
+                    leftRe_[-k] += re * pl;
+                    leftIm_[-k] -= im * pl;
+                    rightRe_[-k] += re * pr;
+                    rightIm_[-k] -= im * pr;
+                }
+                else {
+                    leftRe_[0] += 2.0f * re * pl;
+                    rightRe_[0] += 2.0f * re * pr;
+                }
+                ar = -ar;
+                ai = -ai;
+            }
+        }
+        else {
+            for (uint32_t j = 0; j < kLobeBins; ++j, ++k, d += 1.0f) {
+                float lobe = Lobe(std::abs(d));
+                if (k > 0) {
+                    leftRe_[k] += ar * lobe;
+                    leftIm_[k] += ai * lobe;
+                }
+                else if (k < 0) {
+                    leftRe_[-k] += ar * lobe;
+                    leftIm_[-k] -= ai * lobe;
+                }
+                else {
+                    leftRe_[0] += 2.0f * ar * lobe;
+                }
+                ar = -ar;
+                ai = -ai;
+            }
+        }
+    }
+
+    InverseFft(leftRe_, leftIm_, frame_);
+    for (uint32_t i = 0; i < 2 * kHopSize; ++i) {
+        olaLeft_[i] += frame_[kFftSize / 2 - kHopSize + i] * synthWindow_[i];
+    }
+    if (stereo) {
+        InverseFft(rightRe_, rightIm_, frame_);
+        for (uint32_t i = 0; i < 2 * kHopSize; ++i) {
+            olaRight_[i] += frame_[kFftSize / 2 - kHopSize + i] * synthWindow_[i];
+        }
+    }
+    else if (stereo_) {
+        // 从立体声切到单声道时右声道剩下的一半帧不再输出
+        std::fill_n(olaRight_, std::size(olaRight_), 0.0f);
+    }
+    stereo_ = stereo;
+}
+
+/* 实数反变换: N/2点复数反FFT, x[2n] + j*x[2n+1] */
+_CODE_ITCM void IfftRenderer::InverseFft(const float* re, const float* im, float* out) {
+    constexpr uint32_t kHalfSize = kFftSize / 2;
+
+    for (uint32_t k = 0; k < kHalfSize; ++k) {
+        float ar = re[k];
+        float ai = k == 0 ? 0.0f : im[k];
+        float br = re[kHalfSize - k];
+        float bi = (k == 0) ? 0.0f : -im[kHalfSize - k];
+        float er = ar + br;
+        float ei = ai + bi;
+        float dr = ar - br;
+        float di = ai - bi;
+        float orr = dr * twiddleCos_[k] - di * twiddleSin_[k];
+        float oi = dr * twiddleSin_[k] + di * twiddleCos_[k];
+        uint32_t dst = bitReverse_[k];
+        workRe_[dst] = er - oi;
+        workIm_[dst] = ei + orr;
+    }
+
+    for (uint32_t len = 2; len <= kHalfSize; len <<= 1) {
+        uint32_t half = len / 2;
+        uint32_t step = kFftSize / len;
+        for (uint32_t i = 0; i < kHalfSize; i += len) {
+            for (uint32_t k = 0; k < half; ++k) {
+                float wr = twiddleCos_[k * step];
+                float wi = twiddleSin_[k * step];
+                float* pr = workRe_ + i + k;
+                float* pi = workIm_ + i + k;
+                float br = pr[half] * wr - pi[half] * wi;
+                float bi = pr[half] * wi + pi[half] * wr;
+                pr[half] = pr[0] - br;
+                pi[half] = pi[0] - bi;
+                pr[0] += br;
+                pi[0] += bi;
+            }
+        }
+    }
+
+    for (uint32_t n = 0; n < kHalfSize; ++n) {
+        out[2 * n] = workRe_[n];
+        out[2 * n + 1] = workIm_[n];
+    }
+}
+
+}
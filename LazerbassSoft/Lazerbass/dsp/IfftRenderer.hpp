@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+
+namespace dsp {
+
+/**
+ * @brief 反FFT叠加合成(FFT-1)
+ *        每一帧把每个分音的blackman-harris窗主瓣(8个bin)叠加到频谱上, 做一次N点实数反变换,
+ *        中间2*hop个采样除掉窗函数再乘三角窗, 以hop为间隔叠加输出
+ *        开销是每个分音每帧8次复数乘加加上一次FFT, 比MCF每个分音每个采样的开销低得多
+ */
+class IfftRenderer {
+public:
+    static constexpr uint32_t kMaxNumPartials = 1024;
+    static constexpr uint32_t kFftSize = 512;
+    static constexpr uint32_t kHopSize = 128;
+    static constexpr uint32_t kNumBins = kFftSize / 2 + 1;
+    static constexpr uint32_t kLobeBins = 8;
+    static constexpr uint32_t kLobeResolution = 64;
+
+    /**
+     * @param maxFreq 和MCF一致, 超过这个频率(rad/sample)的分音不合成
+     */
+    void Init(float maxFreq);
+
+    /**
+     * @brief 从当前采样开始合成, 调用前在GetPhases()里写入每个分音当前采样的相位
+     */
+    void Start(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+               uint32_t numPartials, bool stereo);
+
+    /**
+     * @brief 渲染numSamples个采样到left(和right), 每hop个采样用当前的分音表合成一帧
+     */
+    void Render(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+                uint32_t numPartials, bool stereo, float* left, float* right, uint32_t numSamples);
+
+    float* GetPhases() { return phases_; }
+
+    /**
+     * @brief 分音在当前采样的相位, 用于切换回MCF
+     */
+    float GetPhase(uint32_t idx, float freq) const {
+        return phases_[idx] - freq * (2 * kHopSize - hopPos_);
+    }
+
+    /**
+     * @brief 超出这个频率(rad/sample)的分音主瓣会碰到奈奎斯特bin, 不合成
+     */
+    static constexpr float GetMaxFreq() {
+        return (kFftSize / 2 - kLobeBins / 2 - 1) * 6.283185307179586f / kFftSize;
+    }
+private:
+    void SynthFrame(const float* freqs, const float* gains, const float* panLefts, const float* panRights,
+                    uint32_t numPartials, bool stereo);
+    void InverseFft(const float* re, const float* im, float* out);
+    float Lobe(float absBin) const;
+
+    // 相位为下一帧中心处的相位
+    float phases_[kMaxNumPartials]{};
+
+    // 频谱
+    float leftRe_[kNumBins]{};
+    float leftIm_[kNumBins]{};
+    float rightRe_[kNumBins]{};
+    float rightIm_[kNumBins]{};
+
+    // 反变换
+    float workRe_[kFftSize / 2]{};
+    float workIm_[kFftSize / 2]{};
+    float frame_[kFftSize]{};
+    float twiddleCos_[kFftSize / 2]{};
+    float twiddleSin_[kFftSize / 2]{};
+    uint16_t bitReverse_[kFftSize / 2]{};
+
+    // 窗
+    float lobe_[kLobeBins / 2 * kLobeResolution + 2]{};
+    float synthWindow_[2 * kHopSize]{};
+
+    // 叠加, 表示从当前hop开始的2*hop个采样
+    float olaLeft_[2 * kHopSize]{};
+    float olaRight_[2 * kHopSize]{};
+    float maxFreq_{};
+    uint32_t hopPos_{ kHopSize };
+    bool stereo_{};
+};
+
+}
@@ -1,15 +1,40 @@
 #include "LFO.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace dsp {
 
 void LFO::Init(uint32_t sampleRate, uint32_t updateRate) {
-    invUpdateRate_ = static_cast<float>(updateRate) / sampleRate;
+    SetUpdateRate(sampleRate, updateRate);
     lastRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
     nowRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
 }
 
+/* 每个Tick前进rate / updateRate个周期, 改变控制频率不改变LFO的速度 */
+void LFO::SetUpdateRate(uint32_t /*sampleRate*/, uint32_t updateRate) {
+    invUpdateRate_ = 1.0f / updateRate;
+}
+
 void LFO::Tick() {
-    float lfoRate = SynthParams::GetLfoFrequency(params_.bpm, desc_, desc_.rate.GetWithModulation());
+    UpdateRate();
+    if (beatLocked_ && rateKey_.bpmSync && desc_.rate.modulationValue == 0.0f) {
+        // 相位 = 拍数 * 每拍的周期数, 不积分, 跟随MIDI时钟时整场演出不漂移
+        skippedTicks_ = 0;
+        const double cycles = beats_ * rate_;
+        const auto phase = static_cast<float>(cycles - std::floor(cycles));
+        if (phase < phase_) {
+            lastRandom_ = nowRandom_;
+            nowRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        }
+        phase_ = phase;
+        output_ = GetOutput(phase_);
+        return;
+    }
+    if (skippedTicks_ > 0) {
+        CatchUp();
+    }
+
+    float lfoRate = GetModulatedRate();
     phase_ += lfoRate * invUpdateRate_;
     if (phase_ > 1.0f) {
         phase_ -= 1.0f;
@@ -18,40 +43,115 @@ void LFO::Tick() {
         nowRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
     }
 
+    output_ = GetOutput(phase_);
+}
+
+/* 随机数只在Tick里换新的, 跨过周期时s&h和noise停在周期的末尾 */
+float LFO::Peek(float ticks) const {
+    float phase = phase_ + GetModulatedRate() * invUpdateRate_ * ticks;
+    if (phase > 1.0f) {
+        phase = desc_.type.Get() == LFOType::kSawTri ? phase - 1.0f : 1.0f;
+    }
+    return GetOutput(phase);
+}
+
+float LFO::GetOutput(float phase) const {
     switch (desc_.type.Get()) {
     case LFOType::kSawTri: {
         float shape = desc_.shape.GetWithModulation();
         if (shape == 0.0f) {
-            output_ = 1.0f - phase_;
+            return 1.0f - phase;
         }
         else if (shape == 1.0f) {
-            output_ = phase_;
+            return phase;
+        }
+        else if (phase < shape) {
+            return phase / shape;
         }
         else {
-            if (phase_ < shape) {
-                output_ = phase_ / shape;
-            }
-            else {
-                output_ = (1.0f - phase_) / (1.0f - shape);
-            }
+            return (1.0f - phase) / (1.0f - shape);
         }
-        break;
     }
     case LFOType::kSampleAndHode:
-        output_ = nowRandom_;
-        break;
+        return nowRandom_;
     case LFOType::kNoise:
-        output_ = dsp::LerpUncheck(lastRandom_, nowRandom_, phase_);
-        break;
+        return dsp::LerpUncheck(lastRandom_, nowRandom_, phase);
     default:
-        output_ = 0.0f;
-        break;
+        return 0.0f;
+    }
+}
+
+/* 按现在的频率补上跳过的Tick, 跨过周期时随机数也要换新的 */
+void LFO::CatchUp() {
+    float lfoRate = GetModulatedRate();
+    phase_ += lfoRate * invUpdateRate_ * skippedTicks_;
+    skippedTicks_ = 0;
+    if (phase_ > 1.0f) {
+        phase_ -= std::floor(phase_);
+        lastRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        nowRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    }
+}
+
+LFO::RateKey LFO::MakeRateKey() const {
+    return RateKey{
+        .rate = desc_.rate.value,
+        .times = desc_.times.Get(),
+        .dotTrip = desc_.dotTrip.Get(),
+        .bpmSync = desc_.bpm.Get(),
+        .snap = desc_.snap.Get(),
+    };
+}
+
+/* 参数变化时重新计算频率和调制用的频率表, 其余时候只比较参数 */
+void LFO::UpdateRate() {
+    rateScale_ = desc_.bpm.Get() ? params_.tempo / 60.0f : 1.0f;
+    RateKey key = MakeRateKey();
+    if (rateValid_ && key == rateKey_) {
+        return;
+    }
+    rateKey_ = key;
+    rateValid_ = true;
+
+    // bpm = 60时的频率就是每拍的周期数
+    rate_ = SynthParams::GetLfoFrequency(60.0f, desc_, desc_.rate.Get());
+    for (uint32_t i = 0; i <= kRateTableSize; ++i) {
+        rateTable_[i] = SynthParams::GetLfoFrequency(60.0f, desc_, static_cast<float>(i) / kRateTableSize);
+    }
+}
+
+/* 跳过Tick的LFO的缓存可能是旧的, 这时直接计算, 不写缓存, GUI任务不和音频任务抢着更新 */
+float LFO::GetRate() const {
+    float scale = desc_.bpm.Get() ? params_.tempo / 60.0f : 1.0f;
+    if (rateValid_ && MakeRateKey() == rateKey_) {
+        return rate_ * scale;
+    }
+    return SynthParams::GetLfoFrequency(60.0f, desc_, desc_.rate.Get()) * scale;
+}
+
+/* 没有调制时就是缓存的频率, 有调制时在表里线性插值
+ * bpm同步误差小于0.1%, 自由频率的误差和0.01hz的取整差不多, snap只取2的整数次幂, 直接取表上的点
+ */
+float LFO::GetModulatedRate() const {
+    if (desc_.rate.modulationValue == 0.0f) {
+        return rate_ * rateScale_;
+    }
+
+    constexpr uint32_t kSnapStep = kRateTableSize / 4;
+    float pos = desc_.rate.GetWithModulation() * kRateTableSize;
+    if (rateKey_.bpmSync && rateKey_.snap) {
+        auto idx = static_cast<uint32_t>(pos / kSnapStep + 0.5f) * kSnapStep;
+        return rateTable_[idx] * rateScale_;
     }
 
+    auto idx = std::min(static_cast<uint32_t>(pos), kRateTableSize - 1);
+    float frac = pos - idx;
+    return (rateTable_[idx] + (rateTable_[idx + 1] - rateTable_[idx]) * frac) * rateScale_;
 }
 
 void LFO::ResetPhase() {
     if (desc_.restart.Get()) {
+        skippedTicks_ = 0;
         phase_ = 0.0f;
         lastRandom_ = nowRandom_;
         nowRandom_ = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
@@ -10,13 +10,54 @@ public:
         : desc_(desc), params_(params) {}
 
     void Init(uint32_t sampleRate, uint32_t updateRate);
+    void SetUpdateRate(uint32_t sampleRate, uint32_t updateRate);
     void Tick();
+    /**
+     * @brief 没有人使用输出时代替Tick, 下次Tick时一次补上跳过的相位, 频率的缓存也在那时更新
+     */
+    void Skip() { ++skippedTicks_; }
     void ResetPhase();
+    /**
+     * @brief 跟随MIDI时钟时在Tick之前调用, bpm同步并且rate没有调制时相位锁定在拍上
+     * @param beats 现在的位置(拍)
+     */
+    void SetBeatPosition(bool locked, double beats) {
+        beatLocked_ = locked;
+        beats_ = beats;
+    }
+    /**
+     * @brief Tick之后再过ticks个Tick(0~1)时的输出, 不改变状态, 音频速率的调制用
+     */
+    float Peek(float ticks) const;
 
     float* GetOutputReg() { return &output_; }
     ModulatorDesc GetModulatorDesc();
 
+    /**
+     * @brief 不带调制的频率(hz), GUI显示用
+     */
+    float GetRate() const;
+
 private:
+    /* 影响频率的参数, 变化时才重新计算, bpm同步时缓存每拍的周期数, 速度只是一个乘数 */
+    struct RateKey {
+        int32_t rate;
+        int32_t times;
+        int32_t dotTrip;
+        bool bpmSync;
+        bool snap;
+
+        bool operator==(const RateKey&) const = default;
+    };
+    // rate参数0~1分成kRateTableSize段, bpm的snap正好落在表上
+    static constexpr uint32_t kRateTableSize = 32;
+
+    void CatchUp();
+    RateKey MakeRateKey() const;
+    void UpdateRate();
+    float GetModulatedRate() const;
+    float GetOutput(float phase) const;
+
     SynthParams::LfoParamDesc& desc_;
     SynthParams& params_;
     float output_{};
@@ -25,6 +66,16 @@ private:
     float invUpdateRate_{};
     float lastRandom_{};
     float nowRandom_{};
+    uint32_t skippedTicks_{};
+
+    double beats_{};
+    bool beatLocked_{};
+
+    RateKey rateKey_{};
+    bool rateValid_{};
+    float rate_{};
+    float rateScale_{ 1.0f };  // bpm同步时是tempo / 60
+    float rateTable_[kRateTableSize + 1]{};
 };
 
 }
\ No newline at end of file
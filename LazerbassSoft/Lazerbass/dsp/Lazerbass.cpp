@@ -2,8 +2,12 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <utility>
 
+#include "dsp/OscillatorTables.hpp"
 #include "bsp/DebugIO.hpp"
+#include "bsp/Time.hpp"
+#include "mcu/Memory.hpp"
 
 namespace dsp {
 
@@ -55,31 +59,80 @@ static constexpr float Semitone2Ratio(float deltaSemitone) {
     return std::exp2(deltaSemitone / 12.0f);
 }
 
+/* PeriodFilter中和分音无关的量, 一个分音的增益只取决于它的相位 */
+struct PeriodFilterShape {
+    float magFloor;
+    float lerpVal0;
+    float val1;
+    float val2;
+    bool blocks;
+};
+
+static PeriodFilterShape MakePeriodFilterShape(float argPeak, float argApply, bool argBlocks) {
+
+    PeriodFilterShape shape;
+    shape.magFloor = LerpUncheck(24.0f, 300.0f, argPeak);
+    shape.lerpVal0 = YUpBp1(argPeak, 0.5f);
+    const float val0 = 1.0f + argApply * 0.3f
+                    + argPeak * 1.2f * (1.0f - argBlocks);
+    shape.val1 = val0 * argApply;
+    shape.val2 = 1.0f - argApply;
+    shape.blocks = argBlocks;
+    return shape;
+}
+
+static float PeriodFilterLevel(float phase0, const PeriodFilterShape& shape) {
+    float phaseRound = phase0 - static_cast<int32_t>(phase0);
+    float waveVal = phaseRound > 0.5f ? 1.0f : 0.0f;
+    if (!shape.blocks) {
+        waveVal = std::cos(phaseRound * std::numbers::pi_v<float> * 2.0f);
+        waveVal = (waveVal + 1.0f) * 0.5f;
+    }
+
+    float mag = (waveVal - 1.0f) * shape.magFloor;
+    float level = Db2Gain(mag);
+    float level0 = LerpUncheck(waveVal, level, shape.lerpVal0);
+    return level0 * shape.val1 + shape.val2;
+}
+
 // --------------------------------------------------------------------------------
 // Lazerbass
 // --------------------------------------------------------------------------------
-Lazerbass::Lazerbass()
+Lazerbass::Lazerbass(std::span<PartialTable, kNumPartialTables> tables,
+                     std::span<float, EffectChain::kArenaSize> effectMemory)
     : lfo1_(params_.lfo1, params_)
     , lfo2_(params_.lfo2, params_)
     , lfo3_(params_.lfo3, params_)
     , lfo4_(params_.lfo4, params_)
     , ampEnv_(params_.ampEnv, params_)
     , env1_(params_.env1, params_)
-    , env2_(params_.env2, params_) {
+    , env2_(params_.env2, params_)
+    , sequencer_(clock_)
+    , effects_(params_, effectMemory) {
+    front_ = &tables[0];
+    back_ = &tables[1];
+    pipeline_ = &tables[2];
 }
 
 void Lazerbass::Init(uint32_t sampleRate, uint32_t updateRate) {
     sampleRate_ = sampleRate;
     tickPos_ = 0;
-    tickPreiod_ = sampleRate / updateRate;
     twoPiInvSampleRate_ = std::numbers::pi_v<float> * 2.0f / sampleRate_;
     hasNoteOn_ = false;
     output_ = false;
     maxRadiusFreqs_ = kMaxFreq * twoPiInvSampleRate_;
+    ifft_.Init(maxRadiusFreqs_);
+    useIfft_ = false;
 
     noteStack_.reserve(64);
 
     std::fill_n(oldFreqs_, std::size(oldFreqs_), -1.0f);
+    std::fill_n(rates_, std::size(rates_), 1);
+    numFullRate_ = 0;
+    numHalfRate_ = 0;
+    numQuarterRate_ = 0;
+    numRatePartials_ = 0;
+    multirate_.Reset();
 
     lfo1_.Init(sampleRate, updateRate);
     lfo2_.Init(sampleRate, updateRate);
@@ -88,23 +141,82 @@ void Lazerbass::Init(uint32_t sampleRate, uint32_t updateRate) {
     ampEnv_.Init(sampleRate, updateRate);
     env1_.Init(sampleRate, updateRate);
     env2_.Init(sampleRate, updateRate);
+    midi_.Init(updateRate);
+    macros_.Init(updateRate);
+    clock_.Init(sampleRate);
+    sequencer_.Init(sampleRate);
+    effects_.Init(sampleRate);
+
+    auto& controlRate = params_.render.controlRate;
+    controlRate.value = ClampUncheck(static_cast<int32_t>(updateRate), controlRate.min, controlRate.max);
+    SetUpdateRate(controlRate.Get());
 }
 
-void Lazerbass::Process(std::span<StereoSample> block) {
+void Lazerbass::SetUpdateRate(uint32_t updateRate) {
+    updateRate_ = updateRate;
+    tickPreiod_ = sampleRate_ / updateRate;
+    sliceSamples_ = (tickPreiod_ + kNumTickSlices - 1) / kNumTickSlices;
+
+    lfo1_.SetUpdateRate(sampleRate_, updateRate);
+    lfo2_.SetUpdateRate(sampleRate_, updateRate);
+    lfo3_.SetUpdateRate(sampleRate_, updateRate);
+    lfo4_.SetUpdateRate(sampleRate_, updateRate);
+    ampEnv_.SetUpdateRate(sampleRate_, updateRate);
+    env1_.SetUpdateRate(sampleRate_, updateRate);
+    env2_.SetUpdateRate(sampleRate_, updateRate);
+    midi_.SetUpdateRate(updateRate);
+    macros_.SetUpdateRate(updateRate);
+}
+
+template<class TSample>
+void Lazerbass::Process(std::span<TSample> block) {
     uint32_t samplePos = 0;
     const uint32_t blockSize = static_cast<uint32_t>(block.size());
+    RunRealtime();
     while (samplePos < blockSize) {
+        if (sequencer_.IsDue()) {
+            RunSequencer();
+        }
         if (tickPos_ <= 0) {
             Tick();
             tickPos_ = tickPreiod_;
         }
         uint32_t numSamples = std::min(tickPos_, blockSize - samplePos);
+        numSamples = std::min(numSamples, kMaxBlockSize);
+        // 在音序器的下一个事件处切开
+        numSamples = std::min(numSamples, sequencer_.GetSamplesToNextEvent());
+        if (audioFreq_ || audioGain_) {
+            /* 在从Tick开始的kAudioRateBlock网格上更新音频速率的调制 */
+            const uint32_t elapsed = tickPreiod_ - tickPos_;
+            const uint32_t subPos = elapsed % kAudioRateBlock;
+            if (subPos == 0) {
+                AudioRateStep(elapsed, std::min(kAudioRateBlock, tickPos_));
+            }
+            numSamples = std::min(numSamples, kAudioRateBlock - subPos);
+        }
+        if (schedule_ == TickSchedule::kSlice) {
+            /* 把下一个Tick的分音计算分摊到这个Tick的各个子块 */
+            numSamples = std::min(numSamples, sliceSamples_);
+            uint32_t sliceEnd = std::min(sliceBegin_ + slicePartials_, back_->numPartials);
+            ProcessPartials(*back_, sliceBegin_, sliceEnd);
+            sliceBegin_ = sliceEnd;
+        }
         tickPos_ -= numSamples;
-        AudioGen(block.data() + samplePos, numSamples);
+        sequencer_.Advance(numSamples);
+        sampleTime_ += numSamples;
+        bool stereo = useIfft_ ? AudioGenIfft(numSamples)
+                    : smooth_ ? AudioGenSmooth(numSamples)
+                    : AudioGen(numSamples);
+        if (ampVca_ && output_) {
+            ApplyAmpEnvelope(numSamples, stereo);
+        }
+        stereo = effects_.Process(mix_, mixRight_, numSamples, stereo);
+        MixToOutput(block.data() + samplePos, numSamples, stereo);
         samplePos += numSamples;
     }
 }
 
+
 static float LimitCosConvert(float sin) {
     auto e = 1.0f - sin * sin;
     if (e < 0.0f) {
@@ -118,14 +230,42 @@ static float LimitCosConvert(float sin) {
     }
 }
 
-void Lazerbass::AudioGen(StereoSample* out, uint32_t numSamples) {
-    std::fill_n(out, numSamples, StereoSample{});
+_CODE_ITCM bool Lazerbass::AudioGen(uint32_t numSamples) {
+    const bool stereo = front_->stereo;
+    std::fill_n(mix_, numSamples, 0.0f);
+    if (stereo) {
+        std::fill_n(mixRight_, numSamples, 0.0f);
+    }
 
     if (!output_) {
+        return stereo;
+    }
+
+    McfRender(bandPartials_, numFullRate_, 1, mix_, mixRight_, numSamples, stereo);
+    if (numHalfRate_ + numQuarterRate_ > 0) {
+        const uint32_t numFrames = multirate_.BeginBlock(numSamples, stereo);
+        const uint16_t* halfRate = bandPartials_ + numFullRate_;
+        const uint16_t* quarterRate = halfRate + numHalfRate_;
+        McfRender(halfRate, numHalfRate_, 2, multirate_.GetBand(2, false), multirate_.GetBand(2, true), 2 * numFrames, stereo);
+        McfRender(quarterRate, numQuarterRate_, 4, multirate_.GetBand(4, false), multirate_.GetBand(4, true), numFrames, stereo);
+        multirate_.EndBlock(mix_, mixRight_, numSamples);
+    }
+
+    return stereo;
+}
+
+/* partials中的分音每rate个输出采样走一步, 累加numSamples个采样到left(和right) */
+_CODE_ITCM void Lazerbass::McfRender(const uint16_t* partials, uint32_t numPartials, uint32_t rate,
+                                     float* left, float* right, uint32_t numSamples, bool stereo) {
+    if (numSamples == 0 || numPartials == 0) {
         return;
     }
-    
-    const auto numPartials = static_cast<uint32_t>(params_.oscillor.numPartials.Get());
+
+    const auto* freqs = front_->freqs;
+    const auto* gains = front_->gains;
+    const auto* panLefts = front_->panLefts;
+    const auto* panRights = front_->panRights;
+    const float rateMul = static_cast<float>(rate);
     /* 在第一个采样处执行频率更改
      *       phi     = (pi - w) / 2
      *       phi_new = (pi - w_new) / 2
@@ -140,57 +280,81 @@ void Lazerbass::AudioGen(StereoSample* out, uint32_t numSamples) {
      *       c_new = 2 * sin(w_new / 2)
      * PredCos: x(n) > x(n-1) ? |cos(x(n))| : -|cos(x(n))|
      *          |Cos(x(n))| = sqrt(1 - x(n)^2)
+     * 低速率的分音w_new为rate倍的频率
      */
     {
         float firstSampleOut = 0.0f;
-        for (uint32_t i = 0; i < numPartials; ++i) {
+        float firstSampleLeft = 0.0f;
+        float firstSampleRight = 0.0f;
+        for (uint32_t j = 0; j < numPartials; ++j) {
+            const uint32_t i = partials[j];
             auto ret = sin0_[i];
-            firstSampleOut += ret * gains_[i];
+            firstSampleOut += ret * gains[i];
+            if (stereo) {
+                firstSampleLeft += ret * gains[i] * panLefts[i];
+                firstSampleRight += ret * gains[i] * panRights[i];
+            }
 
             sin0_[i] -= coefs_[i] * sin1_[i];
             sin1_[i] += coefs_[i] * sin0_[i];
 
-            if (oldFreqs_[i] != freqs_[i]) {
-                bool freqOutOfRange = freqs_[i] > maxRadiusFreqs_ || freqs_[i] < 0.0f;
+            if (oldFreqs_[i] != freqs[i]) {
+                bool freqOutOfRange = freqs[i] > maxRadiusFreqs_ || freqs[i] < 0.0f;
                 enable_[i] = !freqOutOfRange;
 
+                float w = freqs[i] * rateMul;
                 if (sin0_[i] > ret) {
                     float predCos = LimitCosConvert(sin0_[i]);
-                    coefs_[i] = 2.0f * std::sin(freqs_[i] / 2.0f);
-                    sin1_[i] = sin0_[i] * std::sin(freqs_[i] / 2.0f) - predCos * std::cos(freqs_[i] / 2.0f);
+                    coefs_[i] = 2.0f * std::sin(w / 2.0f);
+                    sin1_[i] = sin0_[i] * std::sin(w / 2.0f) - predCos * std::cos(w / 2.0f);
                 }
                 else {
                     float predCos = -LimitCosConvert(sin0_[i]);
-                    coefs_[i] = 2.0f * std::sin(freqs_[i] / 2.0f);
-                    sin1_[i] = sin0_[i] * std::sin(freqs_[i] / 2.0f) - predCos * std::cos(freqs_[i] / 2.0f);
+                    coefs_[i] = 2.0f * std::sin(w / 2.0f);
+                    sin1_[i] = sin0_[i] * std::sin(w / 2.0f) - predCos * std::cos(w / 2.0f);
                 }
 
-                oldFreqs_[i] = freqs_[i];
+                oldFreqs_[i] = freqs[i];
             }
         }
 
-        auto int16FirstSampleOut = static_cast<int16_t>(firstSampleOut * std::numeric_limits<int16_t>::max() / 8);
-        out[0].left = int16FirstSampleOut;
-        out[0].right = int16FirstSampleOut;
+        if (stereo) {
+            left[0] += firstSampleLeft;
+            right[0] += firstSampleRight;
+        }
+        else {
+            left[0] += firstSampleOut;
+        }
     }
 
     /* 在其他采样处执行恒定频率MCF
      * x(n+1) = x(n-1) - y(n)   * c
      * y(n+1) = y(n-1) + x(n+1) * c
     */
-    for (uint32_t i = 0; i < numPartials; ++i) {
+    for (uint32_t j = 0; j < numPartials; ++j) {
+        const uint32_t i = partials[j];
         auto c = coefs_[i];
         auto x = sin0_[i];
         auto y = sin1_[i];
-        auto g = gains_[i];
+        auto g = gains[i];
+
+        if (enable_[i] && g != 0.0f && stereo) {
+            /* 两个累加器, 每个采样只比单声道多一次乘加 */
+            auto gl = g * panLefts[i];
+            auto gr = g * panRights[i];
+            for (uint32_t sampleIdx = 1; sampleIdx < numSamples; ++sampleIdx) {
+                left[sampleIdx] += x * gl;
+                right[sampleIdx] += x * gr;
 
-        if (enable_[i]) {
+                x -= y * c;
+                y += x * c;
+            }
+        }
+        else if (enable_[i] && g != 0.0f) {
             /* 计算振幅 */
             for (uint32_t sampleIdx = 1; sampleIdx < numSamples; ++sampleIdx) {
                 // output
-                auto oscOut = x * g;
-                auto int16OscOut = static_cast<int16_t>(oscOut * std::numeric_limits<int16_t>::max() / 8);
-                out[sampleIdx].left += int16OscOut;
+                left[sampleIdx] += x * g;
 
                 // mcf
                 x -= y * c;
@@ -208,27 +372,431 @@ void Lazerbass::AudioGen(StereoSample* out, uint32_t numSamples) {
         sin0_[i] = x;
         sin1_[i] = y;
     }
+}
+
+bool Lazerbass::AudioGenIfft(uint32_t numSamples) {
+    const bool stereo = front_->stereo;
+    if (!output_) {
+        std::fill_n(mix_, numSamples, 0.0f);
+        if (stereo) {
+            std::fill_n(mixRight_, numSamples, 0.0f);
+        }
+        return stereo;
+    }
 
+    ifft_.Render(front_->freqs, front_->gains, front_->panLefts, front_->panRights,
+                 front_->numPartials, stereo, mix_, mixRight_, numSamples);
+    return stereo;
+}
+
+/* release结束后停止渲染, 等下一个音符 */
+void Lazerbass::ApplyAmpEnvelope(uint32_t numSamples, bool stereo) {
+    float gains[kMaxBlockSize];
+    ampEnv_.Render(gains, numSamples);
     for (uint32_t i = 0; i < numSamples; ++i) {
-        out[i].right = out[i].left;
+        mix_[i] *= gains[i];
+    }
+    if (stereo) {
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            mixRight_[i] *= gains[i];
+        }
+    }
+
+    if (ampEnv_.IsIdle() && !hasNoteOn_) {
+        output_ = false;
     }
 }
 
+/* 混音缓冲区里8.0为满幅, 转换到输出格式, 截断到16bit时加TPDF抖动 */
+template<class T>
+struct OutputTrait;
+
+template<>
+struct OutputTrait<int16_t> {
+    static constexpr float kMaxOut = 32767.0f;
+    static constexpr bool kDither = true;
+};
+
+template<>
+struct OutputTrait<int32_t> {
+    static constexpr float kMaxOut = 2147483520.0f; // 小于2^31的最大float
+    static constexpr bool kDither = false;
+};
+
+float Lazerbass::TpdfDither() {
+    /* 两个均匀分布相加, -1~1 LSB三角分布 */
+    ditherSeed_ = ditherSeed_ * 1664525u + 1013904223u;
+    float r0 = (ditherSeed_ >> 8) * (1.0f / 16777216.0f);
+    ditherSeed_ = ditherSeed_ * 1664525u + 1013904223u;
+    float r1 = (ditherSeed_ >> 8) * (1.0f / 16777216.0f);
+    return r0 - r1;
+}
+
+template<class TSample>
+void Lazerbass::MixToOutput(TSample* out, uint32_t numSamples, bool stereo) {
+    using T = decltype(TSample::left);
+    using Trait = OutputTrait<T>;
+    constexpr float kMaxOut = Trait::kMaxOut;
+    constexpr float kScale = kMaxOut / 8;
+
+    const float* right = stereo ? mixRight_ : mix_;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        float l = mix_[i] * kScale;
+        float r = right[i] * kScale;
+        if constexpr (Trait::kDither) {
+            l += TpdfDither();
+            r += TpdfDither();
+        }
+        out[i].left = static_cast<T>(ClampUncheck(l, -kMaxOut, kMaxOut));
+        out[i].right = static_cast<T>(ClampUncheck(r, -kMaxOut, kMaxOut));
+    }
+}
+
+_CODE_ITCM bool Lazerbass::AudioGenSmooth(uint32_t numSamples) {
+    const bool stereo = rampStereo_;
+    std::fill_n(mix_, numSamples, 0.0f);
+    if (stereo) {
+        std::fill_n(mixRight_, numSamples, 0.0f);
+    }
+
+    if (!output_) {
+        return stereo;
+    }
+
+    McfRenderSmooth(bandPartials_, numFullRate_, mix_, mixRight_, numSamples, stereo);
+    if (numHalfRate_ + numQuarterRate_ > 0) {
+        const uint32_t numFrames = multirate_.BeginBlock(numSamples, stereo);
+        const uint16_t* halfRate = bandPartials_ + numFullRate_;
+        const uint16_t* quarterRate = halfRate + numHalfRate_;
+        McfRenderSmooth(halfRate, numHalfRate_, multirate_.GetBand(2, false), multirate_.GetBand(2, true), 2 * numFrames, stereo);
+        McfRenderSmooth(quarterRate, numQuarterRate_, multirate_.GetBand(4, false), multirate_.GetBand(4, true), numFrames, stereo);
+        multirate_.EndBlock(mix_, mixRight_, numSamples);
+    }
+
+    return stereo;
+}
+
+_CODE_ITCM void Lazerbass::McfRenderSmooth(const uint16_t* partials, uint32_t numPartials,
+                                           float* left, float* right, uint32_t numSamples, bool stereo) {
+    /* 增益和MCF系数都在一个Tick内线性变化, 由BeginRamp计算增量, 低速率的分音的增量已经乘了rate
+     * x(n+1) = x(n-1) - y(n)   * c(n)
+     * y(n+1) = y(n-1) + x(n+1) * c(n)
+     * c(n+1) = c(n) + dc
+     */
+    for (uint32_t j = 0; j < numPartials; ++j) {
+        const uint32_t i = partials[j];
+        auto c = coefs_[i];
+        auto dc = coefIncs_[i] + modCoefIncs_[i];
+        auto x = sin0_[i];
+        auto y = sin1_[i];
+        auto g = rampGains_[i];
+        auto dg = rampGainIncs_[i];
+        auto gr = rampRightGains_[i];
+        auto dgr = rampRightGainIncs_[i];
+
+        if (stereo && (g != 0.0f || dg != 0.0f || gr != 0.0f || dgr != 0.0f)) {
+            /* g是左声道增益, gr是右声道增益 */
+            for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
+                left[sampleIdx] += x * g;
+                right[sampleIdx] += x * gr;
+                g += dg;
+                gr += dgr;
+
+                x -= y * c;
+                y += x * c;
+                c += dc;
+            }
+            rampRightGains_[i] = gr;
+        }
+        else if (!stereo && (g != 0.0f || dg != 0.0f)) {
+            for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
+                left[sampleIdx] += x * g;
+                g += dg;
+
+                x -= y * c;
+                y += x * c;
+                c += dc;
+            }
+        }
+        else {
+            /* 只计算相位 */
+            for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
+                x -= y * c;
+                y += x * c;
+                c += dc;
+            }
+        }
+
+        coefs_[i] = c;
+        sin0_[i] = x;
+        sin1_[i] = y;
+        rampGains_[i] = g;
+    }
+}
+
+void Lazerbass::BeginRamp(uint32_t numPartials, bool resetCoefs) {
+    const float invPeriod = 1.0f / tickPreiod_;
+    const auto* freqs = front_->freqs;
+    const auto* gains = front_->gains;
+    const auto* panLefts = front_->panLefts;
+    const auto* panRights = front_->panRights;
+
+    /* MCF的不变量 q = x^2 + y^2 - c*x*y = A^2 * (1 - c^2/4)
+     * c缓慢变化时椭圆面积守恒, 振幅变为 A * ((1 - c0^2/4) / (1 - c1^2/4))^(1/4)
+     * 所以在开始时把x,y缩放 s = sqrt(sqrt(k0 * k1) / q), 斜坡结束时振幅回到1
+     */
+    for (uint32_t i = 0; i < numPartials; ++i) {
+        bool freqOutOfRange = freqs[i] > maxRadiusFreqs_ || freqs[i] < 0.0f;
+        enable_[i] = !freqOutOfRange;
+
+        // 低速率的分音每一步走rate个采样
+        const float rate = rates_[i];
+        const float rampInc = invPeriod * rate;
+
+        if (resetCoefs) {
+            rampGains_[i] = 0.0f;
+            rampRightGains_[i] = 0.0f;
+        }
+        float targetGain = freqOutOfRange ? 0.0f : gains[i];
+        if (rampStereo_) {
+            rampGainIncs_[i] = (targetGain * panLefts[i] - rampGains_[i]) * rampInc;
+            rampRightGainIncs_[i] = (targetGain * panRights[i] - rampRightGains_[i]) * rampInc;
+        }
+        else {
+            rampGainIncs_[i] = (targetGain - rampGains_[i]) * rampInc;
+        }
+
+        if (oldFreqs_[i] == freqs[i] && !resetCoefs) {
+            /* 上一个斜坡刚结束, 系数设为目标, 不保留逐采样累加的舍入误差 */
+            if (coefIncs_[i] != 0.0f && !audioFreq_) {
+                float w = ClampUncheck(freqs[i], 0.0f, maxRadiusFreqs_) * rate;
+                coefs_[i] = 2.0f * std::sin(w / 2.0f);
+            }
+            coefIncs_[i] = 0.0f;
+            continue;
+        }
+        oldFreqs_[i] = freqs[i];
+
+        float w = ClampUncheck(freqs[i], 0.0f, maxRadiusFreqs_) * rate;
+        float targetCoef = 2.0f * std::sin(w / 2.0f);
+        if (resetCoefs) {
+            coefs_[i] = targetCoef;
+            coefIncs_[i] = 0.0f;
+            modCoefs_[i] = 0.0f;
+            modCoefIncs_[i] = 0.0f;
+        }
+        if (audioFreq_) {
+            /* Tick时的频率就是这一刻的目标, 不再斜坡, 系数保持连续,
+             * 和新基准的差交给AudioRateStep斜坡到下一段的目标
+             */
+            baseSin_[i] = targetCoef * 0.5f;
+            baseCos_[i] = std::cos(w / 2.0f);
+            modCoefs_[i] = coefs_[i] - targetCoef;
+            coefIncs_[i] = 0.0f;
+            continue;
+        }
+        if (resetCoefs) {
+            continue;
+        }
+
+        float c0 = coefs_[i];
+        float x = sin0_[i];
+        float y = sin1_[i];
+        float k0 = 1.0f - c0 * c0 * 0.25f;
+        float k1 = 1.0f - targetCoef * targetCoef * 0.25f;
+        float q = x * x + y * y - c0 * x * y;
+        if (q > 1e-12f) {
+            float scale = std::sqrt(std::sqrt(k0 * k1) / q);
+            sin0_[i] = x * scale;
+            sin1_[i] = y * scale;
+        }
+        coefIncs_[i] = (targetCoef - c0) * rampInc;
+    }
+}
+
+/* 按音频速率的调制更新时, 关闭时把调制的部分从系数中去掉 */
+void Lazerbass::UpdateAudioRate() {
+    const bool pitch = params_.render.audioPitch.Get()
+        && modulationBank_.IsTargetUsed(&params_.oscillor.pitch);
+    const bool beating = params_.render.audioBeating.Get()
+        && params_.partialBeating.enable.Get()
+        && modulationBank_.IsTargetUsed(&params_.partialBeating.amount);
+    const bool audioFreq = (pitch || beating) && !useIfft_;
+    audioPitch_ = pitch;
+    audioBeating_ = beating;
+    const bool audioGain = params_.render.audioPhase.Get()
+        && params_.periodFilter.enable.Get()
+        && modulationBank_.IsTargetUsed(&params_.periodFilter.phaseShift)
+        && !useIfft_;
+
+    if (audioFreq && !audioFreq_) {
+        for (uint32_t i = 0; i < mcfPartials_; ++i) {
+            baseSin_[i] = coefs_[i] * 0.5f;
+            baseCos_[i] = LimitCosConvert(baseSin_[i]);
+        }
+        std::fill_n(modCoefs_, kMaxMcfPartials, 0.0f);
+        std::fill_n(modCoefIncs_, kMaxMcfPartials, 0.0f);
+    }
+    else if (!audioFreq && audioFreq_) {
+        for (uint32_t i = 0; i < kMaxMcfPartials; ++i) {
+            coefs_[i] -= modCoefs_[i];
+        }
+        std::fill_n(modCoefs_, kMaxMcfPartials, 0.0f);
+        std::fill_n(modCoefIncs_, kMaxMcfPartials, 0.0f);
+    }
+    audioFreq_ = audioFreq;
+    audioGain_ = audioGain;
+}
+
+/* 只有LFO能算出Tick之间的输出, 其他调制器保持Tick时的值 */
+float Lazerbass::PeekModulator(const float* outputReg, float ticks) {
+    for (auto* lfo : { &lfo1_, &lfo2_, &lfo3_, &lfo4_ }) {
+        if (outputReg == lfo->GetOutputReg()) {
+            return lfo->Peek(ticks);
+        }
+    }
+    return *outputReg;
+}
+
+/* 每kAudioRateBlock个采样用这一段结束时的调制器输出重新计算目标, 在smooth渲染的斜坡上叠加
+ * 频率: 相对Tick时的频率偏移dw, 系数的增量
+ *       2sin(w/2 + e) - 2sin(w/2) = 2(sin(w/2)(cos(e) - 1) + cos(w/2)sin(e)), e = dw/2
+ *       e很小, sin和cos用泰勒展开, 没有libm调用
+ * 增益: PeriodFilter只重新计算和phaseShift有关的部分, 其他增益用Tick时记下的
+ */
+_CODE_ITCM void Lazerbass::AudioRateStep(uint32_t elapsed, uint32_t numSamples) {
+    const float ticks = static_cast<float>(elapsed + numSamples) / tickPreiod_;
+    auto peek = [this, ticks](const float* outputReg) {
+        return PeekModulator(outputReg, ticks);
+    };
+    const float invNumSamples = 1.0f / numSamples;
+    const uint32_t numPartials = mcfPartials_;
+
+    if (audioFreq_) {
+        const uint32_t begin = bsp::Time::GetCycles();
+
+        float ratio = 1.0f;
+        if (audioPitch_) {
+            const auto& desc = params_.oscillor.pitch;
+            float delta = desc.GetFloatValue(modulationBank_.Evaluate(&desc, peek)) - desc.GetWithModulation();
+            ratio = Semitone2Ratio(ClampUncheck(delta, -kMaxAudioRateSemitones, kMaxAudioRateSemitones));
+        }
+        float beat = 0.0f;
+        if (audioBeating_) {
+            const auto& desc = params_.partialBeating.amount;
+            float delta = desc.GetFloatValue(modulationBank_.Evaluate(&desc, peek)) - desc.GetWithModulation();
+            beat = delta * twoPiInvSampleRate_;
+        }
+
+        const float* freqs = oldFreqs_;
+        const auto& beatingMask = front_->args.partialBeating.mask;
+        for (uint32_t i = 0; i < numPartials; ++i) {
+            float target = 0.0f;
+            if (enable_[i]) {
+                float dw = freqs[i] * (ratio - 1.0f) + (beatingMask.Test(i) ? beat : 0.0f);
+                dw = ClampUncheck(dw, -freqs[i], maxRadiusFreqs_ - freqs[i]);
+                float e = 0.5f * rates_[i] * dw;
+                float e2 = e * e;
+                float sinE = e * (1.0f - e2 * (1.0f / 6.0f) * (1.0f - e2 * (1.0f / 20.0f)));
+                float cosE = 1.0f - e2 * 0.5f * (1.0f - e2 * (1.0f / 12.0f));
+                target = 2.0f * (baseSin_[i] * (cosE - 1.0f) + baseCos_[i] * sinE);
+            }
+            modCoefIncs_[i] = (target - modCoefs_[i]) * rates_[i] * invNumSamples;
+            modCoefs_[i] = target;
+        }
+
+        auto target = audioPitch_ ? AudioRateTarget::kPitch : AudioRateTarget::kBeating;
+        audioRateCycles_[static_cast<uint32_t>(target)] += bsp::Time::GetCycles() - begin;
+    }
+
+    if (audioGain_) {
+        const uint32_t begin = bsp::Time::GetCycles();
+        const auto& desc = params_.periodFilter.phaseShift;
+        const float shift = desc.GetFloatValue(modulationBank_.Evaluate(&desc, peek));
+        const auto& periodFilter = params_.periodFilter;
+        const auto shape = MakePeriodFilterShape(periodFilter.peak.GetWithModulation(),
+                                                 periodFilter.apply.GetWithModulation(),
+                                                 periodFilter.blocks.Get());
+        const auto* filterGains = front_->filterGains;
+        const auto* filterPhases = front_->filterPhases;
+        const auto* panLefts = front_->panLefts;
+        const auto* panRights = front_->panRights;
+
+        for (uint32_t i = 0; i < numPartials; ++i) {
+            float g = enable_[i] ? filterGains[i] * PeriodFilterLevel(filterPhases[i] + shift, shape) : 0.0f;
+            const float inc = rates_[i] * invNumSamples;
+            if (rampStereo_) {
+                rampGainIncs_[i] = (g * panLefts[i] - rampGains_[i]) * inc;
+                rampRightGainIncs_[i] = (g * panRights[i] - rampRightGains_[i]) * inc;
+            }
+            else {
+                rampGainIncs_[i] = (g - rampGains_[i]) * inc;
+            }
+        }
+
+        audioRateCycles_[static_cast<uint32_t>(AudioRateTarget::kPhaseShift)] += bsp::Time::GetCycles() - begin;
+    }
+}
+
+/* MCF的不变量 q = x^2 + y^2 - c*x*y = A^2 * (1 - c^2/4)
+ * 单精度的舍入误差, 频率切换时的LimitCosConvert和平滑模式里变化的c都会让振幅慢慢偏离1,
+ * 每个Tick轮流把kRenormPartialsPerTick个分音的x,y缩放回振幅1, 相位不变
+ * 平滑模式在BeginRamp之前调用, 这时上一个斜坡已经结束
+ */
+void Lazerbass::RenormalizeMcf() {
+    const uint32_t numPartials = mcfPartials_;
+    const uint32_t count = std::min(kRenormPartialsPerTick, numPartials);
+    for (uint32_t n = 0; n < count; ++n) {
+        if (renormPos_ >= numPartials) {
+            renormPos_ = 0;
+        }
+        const uint32_t i = renormPos_++;
+
+        float c = coefs_[i];
+        float x = sin0_[i];
+        float y = sin1_[i];
+        float k = 1.0f - c * c * 0.25f;
+        float q = x * x + y * y - c * x * y;
+        if (k > 1e-6f && q > 1e-12f) {
+            float scale = std::sqrt(k / q);
+            sin0_[i] = x * scale;
+            sin1_[i] = y * scale;
+        }
+    }
+}
+
+float Lazerbass::GetMcfAmplitudeError() const {
+    if (useIfft_) {
+        return 0.0f;
+    }
+    float maxError = 0.0f;
+    for (uint32_t i = 0; i < mcfPartials_; ++i) {
+        float c = coefs_[i];
+        float x = sin0_[i];
+        float y = sin1_[i];
+        float k = 1.0f - c * c * 0.25f;
+        float q = x * x + y * y - c * x * y;
+        if (k > 1e-6f) {
+            maxError = std::max(maxError, std::abs(std::sqrt(q / k) - 1.0f));
+        }
+    }
+    return maxError;
+}
+
 void Lazerbass::ResetPhase() {
-    const auto numPartials = static_cast<uint32_t>(params_.oscillor.numPartials.Get());
+    const auto numPartials = mcfPartials_;
+    const auto* freqs = front_->freqs;
 
-    PhaseProcessing(numPartials);
+    PhaseProcessing(front_->numPartials);
 
-    /* 修改起始相位
+    /* 修改起始相位, 系数也一起设置, 第一个采样不需要再推算y
      * phi = (pi - w) / 2
      * x(0) = sin(phi_init)
      * y(0) = sin(phi_init - phi)
      */
     for (uint32_t i = 0; i < numPartials; ++i) {
-        float phi = (std::numbers::pi_v<float> - freqs_[i]) / 2.0f;
-        float phiInit = phase_[i];
-        sin0_[i] = std::sin(phiInit);
-        sin1_[i] = std::sin(phiInit - phi);
+        rates_[i] = 1;
+        SetMcfPhase(i, phase_[i], freqs[i]);
     }
 }
 
@@ -286,25 +854,67 @@ ModulatorDesc Lazerbass::GetModulatorDesc(ModulatorId id) {
         return env1_.GetModulatorDesc();
     case kEnv2:
         return env2_.GetModulatorDesc();
+    case kModSequence:
+        return sequencer_.GetModulatorDesc();
+    case kMacro1:
+    case kMacro2:
+    case kMacro3:
+    case kMacro4:
+        return macros_.GetModulatorDesc(static_cast<uint32_t>(id) - static_cast<uint32_t>(kMacro1));
+    case kVelocity:
+        return midi_.GetModulatorDesc(MidiModulators::kVelocity);
+    case kKeyTrack:
+        return midi_.GetModulatorDesc(MidiModulators::kKeyTrack);
+    case kChannelPressure:
+        return midi_.GetModulatorDesc(MidiModulators::kChannelPressure);
+    case kPolyPressure:
+        return midi_.GetModulatorDesc(MidiModulators::kPolyPressure);
     default:
         return lfo1_.GetModulatorDesc();
     }
 }
 
-void Lazerbass::NoteOn(uint32_t noteNumber, float velocity)
-{
+float Lazerbass::GetLfoRate(ModulatorId id) const {
+    using enum ModulatorId;
+
+    switch (id) {
+    case kLfo2:
+        return lfo2_.GetRate();
+    case kLfo3:
+        return lfo3_.GetRate();
+    case kLfo4:
+        return lfo4_.GetRate();
+    default:
+        return lfo1_.GetRate();
+    }
+}
+
+void Lazerbass::NoteOn(uint32_t noteNumber, float velocity) {
+    sequencer_.RecordNote(noteNumber, velocity);
+    TriggerNote(noteNumber, velocity);
+}
+
+void Lazerbass::TriggerNote(uint32_t noteNumber, float velocity) {
+    const bool held = !noteStack_.empty();
+    const bool sounding = output_;
     noteNumber_ = NoteEnqueue(noteNumber);
     velocity_ = velocity;
-    hasNoteOn_ = true;
-
-    // TODO: adsr envelope
+    midi_.NoteOn(velocity);
+    StartGlide(sounding);
+    // legato: 按住其他音符时只改变音高, 不重新触发包络和相位
+    if (!(held && params_.voice.legato.Get())) {
+        hasNoteOn_ = true;
+    }
     output_ = true;
 }
 
 void Lazerbass::NoteOff(uint32_t noteNumber, float /*velocity*/) {
     auto note = NoteDequeue(noteNumber);
     if (note == kInvalidNoteNumber) {
-        output_ = false;
+        // vca时等ampEnv的release结束再停止
+        if (!ampVca_) {
+            output_ = false;
+        }
         ampEnv_.GotoReleaseState();
         env1_.GotoReleaseState();
         env2_.GotoReleaseState();
@@ -312,338 +922,880 @@ void Lazerbass::NoteOff(uint32_t noteNumber, float /*velocity*/) {
     else if (note != noteNumber_) {
         // same as note on
         noteNumber_ = note;
-        hasNoteOn_ = true;
+        StartGlide(true);
+        if (!params_.voice.legato.Get()) {
+            hasNoteOn_ = true;
+        }
+        output_ = true;
+    }
+}
+
+/* 音符从事件所在的采样开始: 提前结束这个Tick周期, 下一个Tick立即重置相位和包络
+ * note off不需要Tick, output_和逐采样的vca在下一个采样就生效
+ */
+void Lazerbass::RunSequencer() {
+    Sequencer::Event events[Sequencer::kMaxEvents];
+    const uint32_t numEvents = sequencer_.Update(params_.bpm, sampleTime_, events);
+    for (uint32_t i = 0; i < numEvents; ++i) {
+        const auto& e = events[i];
+        if (e.type == Sequencer::Event::kNoteOn) {
+            TriggerNote(e.note, e.velocity);
+            tickPos_ = 0;
+        }
+        else {
+            NoteOff(e.note, 0.0f);
+        }
+    }
+}
+
+void Lazerbass::MidiRealtime(uint32_t status, uint32_t value, uint32_t cycles) {
+    const uint32_t write = realtimeWrite_.load(std::memory_order_relaxed);
+    if (write - realtimeRead_.load(std::memory_order_acquire) >= kRealtimeQueueSize) {
+        return;
+    }
+    realtimeQueue_[write % kRealtimeQueueSize] = {
+        cycles, static_cast<uint16_t>(value), static_cast<uint8_t>(status)
+    };
+    realtimeWrite_.store(write + 1, std::memory_order_release);
+}
+
+/* 到达时间按block开始的时刻换算成采样, 在block开始之前到达的是负的偏移 */
+void Lazerbass::RunRealtime() {
+    const uint32_t write = realtimeWrite_.load(std::memory_order_acquire);
+    uint32_t read = realtimeRead_.load(std::memory_order_relaxed);
+    for (; read != write; ++read) {
+        const auto& msg = realtimeQueue_[read % kRealtimeQueueSize];
+        const float offset = static_cast<float>(static_cast<int32_t>(msg.cycles - blockCycles_)) * samplesPerCycle_;
+        const uint32_t time = blockSample_ + static_cast<uint32_t>(static_cast<int32_t>(std::lround(offset)));
+        switch (msg.status) {
+        case 0xf8:
+            clock_.Clock(time);
+            break;
+        case 0xfa:
+            clock_.Start();
+            break;
+        case 0xfb:
+            clock_.Continue();
+            break;
+        case 0xfc:
+            clock_.Stop();
+            sequencer_.Stop();
+            break;
+        case 0xf2:
+            clock_.SongPosition(msg.value);
+            break;
+        default:
+            break;
+        }
+        if (clock_.TakeStarted()) {
+            sequencer_.SyncStart(clock_.GetPosition());
+        }
+    }
+    realtimeRead_.store(read, std::memory_order_release);
+    clock_.CheckTimeout(sampleTime_);
+}
+
+/* 固定时间的滑音, 从现在的音高按半音线性滑到noteNumber_, 没有发声时直接跳过去 */
+void Lazerbass::StartGlide(bool sounding) {
+    const float target = static_cast<float>(noteNumber_);
+    if (!params_.voice.glide.Get() || !sounding) {
+        glidePitch_ = target;
+        glideStep_ = 0.0f;
+        return;
     }
+
+    float ticks = std::max(params_.voice.time.Get() * 0.001f * updateRate_, 1.0f);
+    glideStep_ = (target - glidePitch_) / ticks;
+}
+
+/* 音符(滑音) + 弯音 + 音高参数 */
+void Lazerbass::UpdatePitch() {
+    const float target = static_cast<float>(noteNumber_);
+    glidePitch_ += glideStep_;
+    if ((glideStep_ > 0.0f && glidePitch_ >= target)
+        || (glideStep_ < 0.0f && glidePitch_ <= target)
+        || glideStep_ == 0.0f) {
+        glidePitch_ = target;
+        glideStep_ = 0.0f;
+    }
+
+    const float bend = pitchBend_.load(std::memory_order_relaxed) * params_.voice.bendRange.Get();
+    pitch_ = glidePitch_ + bend + params_.oscillor.pitch.GetWithModulation();
+    fundamental_ = Semitone2Hz(pitch_);
 }
 
 void Lazerbass::Tick()
 {
     const auto numPartials = static_cast<uint32_t>(params_.oscillor.numPartials.Get());
 
+    // step-2: control rate
+    auto updateRate = static_cast<uint32_t>(params_.render.controlRate.Get());
+    if (updateRate != updateRate_) {
+        SetUpdateRate(updateRate);
+    }
+
     // step-1: update modulator and parameters
+    const bool ampVca = params_.ampEnv.vca.Get();
+    if (ampVca_ && !ampVca && noteStack_.empty()) {
+        // release中关掉vca, 和没有vca时的note off一样
+        output_ = false;
+    }
+    ampVca_ = ampVca;
+    ampEnv_.SetPerSample(ampVca);
+    modulationBank_.AcquireMatrix();
     UpdateModulators();
     modulationBank_.Tick();
-    
-    // step0: calculate pitch and fundemental frequency
-    pitch_ = noteNumber_;
-    fundamental_ = Semitone2Hz(pitch_);
+    phaseMask_.Update(params_.oscPhase.parttern.Get());
 
-    // step1: oscilator -> ratio and gain
-    OscillatorProcessing(numPartials);
+    UpdatePitch();
 
-    // step2 ratio processing
-    RatioProcessing(numPartials);
-
-    // step3 filter processing
-    FilterProcessing(numPartials);
-    PeriodFilterProcessing(numPartials);
+    /* step0-5: 分音计算
+     * block: 立即全部计算
+     * slice: back已经在上一个Tick周期里分片计算好了(使用上一个Tick的调制值), 这里只补完剩下的分片
+     * pipeline: 交换预计算任务算好的表, 来不及时继续使用上一张表
+     * 新音符时总是立即全部计算
+     */
+    bool resetPhase = hasNoteOn_;
+    if (pipelineState_.load(std::memory_order_acquire) == kPipelineReady) {
+        if (schedule_ == TickSchedule::kPipeline && !pipelineStale_) {
+            std::swap(front_, pipeline_);
+        }
+        pipelineState_.store(kPipelineIdle, std::memory_order_relaxed);
+    }
+    if (resetPhase || schedule_ == TickSchedule::kBlock) {
+        PrepareTable(*back_, numPartials);
+        ProcessPartials(*back_, 0, numPartials);
+        std::swap(front_, back_);
+    }
+    else if (schedule_ == TickSchedule::kSlice) {
+        ProcessPartials(*back_, sliceBegin_, back_->numPartials);
+        std::swap(front_, back_);
+    }
+    if (resetPhase && pipelineState_.load(std::memory_order_acquire) != kPipelineIdle) {
+        // 正在计算的表是旧音符的, 算完后丢弃
+        pipelineStale_ = true;
+    }
 
-    // step4 update freqs
-    auto radixFundamental = fundamental_ * twoPiInvSampleRate_;
-    for (uint32_t i = 0; i < numPartials; ++i) {
-        freqs_[i] = ratio_[i] * radixFundamental;
+    schedule_ = params_.render.schedule.Get();
+    switch (schedule_) {
+    case TickSchedule::kSlice:
+        // 下一个Tick的分音在这个Tick周期中分片计算
+        PrepareTable(*back_, numPartials);
+        sliceBegin_ = 0;
+        slicePartials_ = (numPartials + kNumTickSlices - 1) / kNumTickSlices;
+        break;
+    case TickSchedule::kPipeline:
+        // 下一个Tick的分音交给预计算任务, 上一个请求还没完成时不再请求
+        if (pipelineState_.load(std::memory_order_acquire) == kPipelineIdle) {
+            PrepareTable(*pipeline_, numPartials);
+            pipelineStale_ = false;
+            pipelineState_.store(kPipelineRequested, std::memory_order_release);
+        }
+        break;
+    default:
+        break;
     }
 
-    // step5 part beating process
-    BeatingProcessing(numPartials);
+    /* 渲染的表的音高改变时按smooth渲染, 所有分音的MCF系数在一个Tick内线性插值,
+     * 滑音和弯音不会每个Tick跳一次, 每个采样只多一次加法
+     */
+    pitchMoving_ = !resetPhase && front_->pitch != renderPitch_;
+    renderPitch_ = front_->pitch;
 
     // step6 update sines
+    mcfPartials_ = std::min(front_->numPartials, kMaxMcfPartials);
     if (hasNoteOn_) {
         ResetPhase();
         ResetModulators();
         hasNoteOn_ = false;
     }
+
+    // step7 choose mcf or ifft by the number of audible partials
+    const bool wasIfft = useIfft_;
+    UpdateBackend(resetPhase);
+    UpdateAudioRate();
+
+    // step8 multirate: render low partials at fs/2 or fs/4
+    if (!useIfft_) {
+        UpdateBands(resetPhase, resetPhase || wasIfft);
+    }
+
+    // step9 keep mcf amplitudes at 1, a few partials per tick
+    if (!useIfft_ && !resetPhase) {
+        RenormalizeMcf();
+    }
+
+    // step10 smooth render: ramp gains and mcf coefficients to the new values
+    bool smooth = IsSmoothRender() && !useIfft_;
+    if (smooth) {
+        if (!smooth_) {
+            std::copy_n(front_->gains, mcfPartials_, rampGains_);
+        }
+        if (front_->stereo && (!smooth_ || !rampStereo_)) {
+            // 从单声道开始, 两边都从原来的增益斜坡到声像后的增益
+            std::copy_n(rampGains_, mcfPartials_, rampRightGains_);
+        }
+        rampStereo_ = front_->stereo;
+        BeginRamp(mcfPartials_, resetPhase);
+    }
+    smooth_ = smooth;
 }
 
-void Lazerbass::UpdateModulators() {
-    lfo1_.Tick();
-    lfo2_.Tick();
-    lfo3_.Tick();
-    lfo4_.Tick();
-    ampEnv_.Tick();
-    env1_.Tick();
-    env2_.Tick();
+/* 最后一个可以听到的分音之后的都不需要渲染 */
+uint32_t Lazerbass::CountActivePartials(const PartialTable& table) const {
+    uint32_t count = table.numPartials;
+    while (count > 0) {
+        float freq = table.freqs[count - 1];
+        bool audible = table.gains[count - 1] != 0.0f && freq >= 0.0f && freq <= maxRadiusFreqs_;
+        if (audible) {
+            break;
+        }
+        --count;
+    }
+    return count;
 }
 
-// --------------------------------------------------------------------------------
-// Processing Units
-// --------------------------------------------------------------------------------
-static constexpr auto kSawGainTable = []{
-    std::array<float, Lazerbass::kMaxNumPartials * 2> ret;
-    for (uint32_t i = 0; i < Lazerbass::kMaxNumPartials * 2; ++i) {
-        ret[i] = 1.0f / (1.0f + i);
+/* MCF和IFFT切换时交接每个分音的相位, 不会产生相位跳变, 新音符时直接用初始相位 */
+void Lazerbass::UpdateBackend(bool resetPhase) {
+    const uint32_t activePartials = CountActivePartials(*front_);
+    const bool useIfft = useIfft_
+        ? activePartials > kMaxMcfPartials - kBackendHysteresis
+        : activePartials > kMaxMcfPartials;
+
+    const auto* freqs = front_->freqs;
+    if (useIfft && (!useIfft_ || resetPhase)) {
+        float* phases = ifft_.GetPhases();
+        const uint32_t numMcf = resetPhase ? 0 : mcfPartials_;
+        for (uint32_t i = 0; i < numMcf; ++i) {
+            phases[i] = GetMcfPhase(i);
+        }
+        std::copy(phase_ + numMcf, phase_ + front_->numPartials, phases + numMcf);
+        ifft_.Start(freqs, front_->gains, front_->panLefts, front_->panRights, front_->numPartials, front_->stereo);
     }
-    return ret;
-}();
+    else if (!useIfft && useIfft_) {
+        for (uint32_t i = 0; i < mcfPartials_; ++i) {
+            rates_[i] = 1;
+            SetMcfPhase(i, resetPhase ? phase_[i] : ifft_.GetPhase(i, freqs[i]), freqs[i]);
+        }
+    }
+    useIfft_ = useIfft;
+}
 
-void Lazerbass::OscillatorProcessing(uint32_t numProcess) {
-    using enum dsp::OscillatorType;
-    switch (params_.oscillor.type.Get()) {
-    case kFullSaw: {
-        std::copy_n(kSawGainTable.cbegin(), numProcess, gains_);
+/* 低于fs/8的分音在fs/2渲染, 低于fs/16的在fs/4渲染, 进入频段时有kBandHysteresis的余量
+ * 改变速率的分音交接相位, 并且把它过去的采样从原来频段的插值历史中减去, 加到新频段的历史中
+ * restart: 新音符或者从IFFT切回来, 插值的历史作废, 重新填入当前的分音
+ */
+void Lazerbass::UpdateBands(bool resetPhase, bool restart) {
+    const auto* freqs = front_->freqs;
+    const uint32_t numPartials = mcfPartials_;
+
+    auto desiredRate = [this, freqs](uint32_t i) -> uint32_t {
+        float w = freqs[i];
+        if (w < 0.0f) {
+            return 1;
+        }
+        float limit4 = MultirateMixer::kMaxFreq4 * (rates_[i] == 4 ? 1.0f : kBandHysteresis);
+        float limit2 = MultirateMixer::kMaxFreq2 * (rates_[i] >= 2 ? 1.0f : kBandHysteresis);
+        return w < limit4 ? 4 : w < limit2 ? 2 : 1;
+    };
 
-        /* 计算偶次谐波偏移 */
-        auto ratioBeating = params_.oscillor.beating.GetWithModulation() / fundamental_ + 1.0f;
-        ratioBeating *= Semitone2Ratio(params_.oscillor.transport.GetWithModulation());
-        for (uint32_t i = 0; i < numProcess; i += 2) {
-            ratio_[i] = i + 1.0f;
-            ratio_[i + 1] = (i + 2.0f) * ratioBeating;
+    uint32_t numLow = 0;
+    if (params_.render.multirate.Get()) {
+        for (uint32_t i = 0; i < numPartials; ++i) {
+            if (desiredRate(i) > 1) {
+                ++numLow;
+            }
         }
-        break;
     }
-    case kDualSaw: {
-        uint32_t partialIdx = 0;
-        auto ratioBeating = params_.oscillor.beating.GetWithModulation() / fundamental_ + 1.0f;
-        ratioBeating *= Semitone2Ratio(params_.oscillor.transport.GetWithModulation());
-        for (uint32_t i = 0; i < numProcess; i += 2) {
-            gains_[i] = kSawGainTable[partialIdx];
-            gains_[i + 1] = kSawGainTable[partialIdx];
-            ratio_[i] = partialIdx + 1.0f;
-            ratio_[i + 1] = (partialIdx + 1.0f) * ratioBeating;
-            ++partialIdx;
+    const uint32_t minLow = GetNumDecimatedPartials() > 0 ? kMinDecimatedPartials / 2 : kMinDecimatedPartials;
+    const bool decimate = numLow >= minLow;
+
+    if (restart) {
+        multirate_.Reset();
+    }
+    multirate_.SetStereo(front_->stereo);
+    // 平滑模式的新音符从0开始斜坡, 不需要填历史
+    const bool prime = !(resetPhase && IsSmoothRender());
+
+    const uint32_t numUpdate = std::max(numPartials, numRatePartials_);
+    for (uint32_t i = 0; i < numUpdate; ++i) {
+        const uint32_t oldRate = rates_[i];
+        const uint32_t rate = decimate && i < numPartials ? desiredRate(i) : 1;
+        // restart时低速率分音的状态还是全速率的
+        const bool changed = restart ? rate != 1 || oldRate != 1 : rate != oldRate;
+        if (!changed) {
+            continue;
+        }
+
+        float theta;
+        float freq;
+        if (resetPhase && i < numPartials) {
+            theta = phase_[i];
+            freq = freqs[i];
+        }
+        else {
+            theta = GetMcfPhase(i);
+            freq = oldFreqs_[i];
+        }
+
+        float gainLeft;
+        float gainRight;
+        if (!restart && oldRate > 1) {
+            GetBandGains(i, restart, gainLeft, gainRight);
+            multirate_.AddSine(oldRate, theta, freq, -gainLeft, -gainRight);
+        }
+        rates_[i] = static_cast<uint8_t>(rate);
+        SetMcfPhase(i, theta, freq);
+        if (rate > 1 && (prime || !restart)) {
+            GetBandGains(i, restart, gainLeft, gainRight);
+            multirate_.AddSine(rate, theta, freq, gainLeft, gainRight);
         }
-        break;
     }
-    case kMultiSaw: {
-        uint32_t numOsc = params_.oscillor.number.Get();
-        float lowestDeltaPitch = -params_.oscillor.beating.GetWithModulation();
-        float lowestRatio = Semitone2Ratio(lowestDeltaPitch);
-        float pitchInterval = (params_.oscillor.beating.GetWithModulation() * 2) / (numOsc - 1);
-        float ratioInterval = Semitone2Ratio(pitchInterval);
+    numRatePartials_ = numPartials;
 
-        float oscRatio = lowestRatio;
-        for (uint32_t i = 0; i < numOsc; ++i) {
-            uint32_t partialIdx = 0;
-            for (uint32_t j = i; j < numProcess; j += numOsc) {
-                gains_[j] = kSawGainTable[partialIdx];
-                ratio_[j] = (partialIdx + 1.0f) * oscRatio;
-                ++partialIdx;
-            }
-            oscRatio *= ratioInterval;
+    // 按速率排列, 全速率的分音保持原来的顺序
+    numFullRate_ = 0;
+    numHalfRate_ = 0;
+    numQuarterRate_ = 0;
+    for (uint32_t i = 0; i < numPartials; ++i) {
+        if (rates_[i] == 1) {
+            ++numFullRate_;
+        }
+        else if (rates_[i] == 2) {
+            ++numHalfRate_;
+        }
+        else {
+            ++numQuarterRate_;
         }
-        break;
     }
-    case kFullSquare: {
-        auto ratioBeating = params_.oscillor.beating.GetWithModulation() / fundamental_ + 1.0f;
-        ratioBeating *= Semitone2Ratio(params_.oscillor.transport.GetWithModulation());
-        for (uint32_t i = 0; i < numProcess; i += 2) {
-            gains_[i] = kSawGainTable[2 * i];
-            gains_[i + 1] = kSawGainTable[2 * i + 3];
-            ratio_[i] = 2 * i + 1.0f;
-            ratio_[i + 1] = (2 * i + 3.0f) * ratioBeating;
+    uint32_t fullPos = 0;
+    uint32_t halfPos = numFullRate_;
+    uint32_t quarterPos = numFullRate_ + numHalfRate_;
+    for (uint32_t i = 0; i < numPartials; ++i) {
+        auto idx = static_cast<uint16_t>(i);
+        if (rates_[i] == 1) {
+            bandPartials_[fullPos++] = idx;
         }
-        break;
+        else if (rates_[i] == 2) {
+            bandPartials_[halfPos++] = idx;
+        }
+        else {
+            bandPartials_[quarterPos++] = idx;
+        }
+    }
+
+    if (GetNumDecimatedPartials() == 0) {
+        multirate_.Reset();
+    }
+}
+
+/* MCF: x = sin(theta), y = sin(theta - phi), phi = (pi - w) / 2
+ *      cos(theta) = (x * cos(phi) - y) / sin(phi) = (x * c / 2 - y) / sqrt(1 - c^2 / 4)
+ * 返回当前输出采样的相位, 低速率的分音要减掉超前的部分
+ */
+float Lazerbass::GetMcfPhase(uint32_t idx) const {
+    float c = coefs_[idx];
+    float cosTheta = (sin0_[idx] * c * 0.5f - sin1_[idx]) / std::sqrt(std::max(1.0f - c * c * 0.25f, 1e-12f));
+    float theta = std::atan2(sin0_[idx], cosTheta);
+    if (rates_[idx] > 1) {
+        theta -= oldFreqs_[idx] * multirate_.GetAdvance(rates_[idx]);
+    }
+    return theta;
+}
+
+/* 按rates_设置MCF的状态, theta为当前输出采样的相位 */
+void Lazerbass::SetMcfPhase(uint32_t idx, float theta, float freq) {
+    const uint32_t rate = rates_[idx];
+    if (rate > 1) {
+        theta += freq * multirate_.GetAdvance(rate);
+    }
+    float w = ClampUncheck(freq, 0.0f, maxRadiusFreqs_) * rate;
+    float phi = (std::numbers::pi_v<float> - w) / 2.0f;
+    sin0_[idx] = std::sin(theta);
+    sin1_[idx] = std::sin(theta - phi);
+    coefs_[idx] = 2.0f * std::sin(w / 2.0f);
+    modCoefs_[idx] = 0.0f;
+    modCoefIncs_[idx] = 0.0f;
+    if (audioFreq_) {
+        baseSin_[idx] = coefs_[idx] * 0.5f;
+        baseCos_[idx] = std::cos(w / 2.0f);
     }
-    case kDualSquare: {
-        uint32_t partialIdx = 0;
-        auto ratioBeating = params_.oscillor.beating.GetWithModulation() / fundamental_ + 1.0f;
-        ratioBeating *= Semitone2Ratio(params_.oscillor.transport.GetWithModulation());
-        for (uint32_t i = 0; i < numProcess; i += 2) {
-            gains_[i] = kSawGainTable[partialIdx];
-            gains_[i + 1] = kSawGainTable[partialIdx];
+    oldFreqs_[idx] = freq;
+    enable_[idx] = freq <= maxRadiusFreqs_ && freq >= 0.0f;
+}
 
-            ratio_[i] = partialIdx + 1.0f;
-            ratio_[i + 1] = (partialIdx + 1.0f) * ratioBeating;
-            partialIdx += 2;
+/* 分音在当前采样的增益, 和这个Tick开始渲染时一致
+ * restart后平滑模式从分音表的增益开始斜坡(见Tick step10), 否则是斜坡的当前值
+ */
+void Lazerbass::GetBandGains(uint32_t idx, bool restart, float& left, float& right) const {
+    if (restart && IsSmoothRender()) {
+        left = front_->gains[idx];
+        right = front_->gains[idx];
+        return;
+    }
+    if (!restart && smooth_) {
+        left = rampGains_[idx];
+        right = rampStereo_ ? rampRightGains_[idx] : rampGains_[idx];
+        return;
+    }
+
+    float gain = enable_[idx] ? front_->gains[idx] : 0.0f;
+    if (front_->stereo) {
+        left = gain * front_->panLefts[idx];
+        right = gain * front_->panRights[idx];
+    }
+    else {
+        left = gain;
+        right = gain;
+    }
+}
+
+/* 在Tick里调用, 拷贝分音计算用到的所有参数, 之后的分片和预计算任务都不再读params_ */
+void Lazerbass::PrepareTable(PartialTable& table, uint32_t numPartials) {
+    table.numPartials = numPartials;
+    table.pitch = pitch_;
+    table.fundamental = fundamental_;
+    table.stereo = params_.pan.enable.Get();
+
+    auto& args = table.args;
+    args.oscillor.type = params_.oscillor.type.Get();
+    args.oscillor.number = params_.oscillor.number.Get();
+    args.oscillor.beating = params_.oscillor.beating.GetWithModulation();
+    args.oscillor.transport = params_.oscillor.transport.GetWithModulation();
+    args.oscillor.pluseWidth = params_.oscillor.pluseWidth.GetWithModulation();
+    args.oscillor.fundamental = params_.oscillor.fundamental.Get();
+
+    args.dispersion.enable = params_.dispersion.enable.Get();
+    args.dispersion.key = params_.dispersion.key.GetWithModulation();
+    args.dispersion.shape = params_.dispersion.shape.GetWithModulation();
+    args.dispersion.amount = params_.dispersion.amount.GetWithModulation();
+
+    args.ratioMul.enable = params_.ratioMul.enable.Get();
+    args.ratioMul.amount = SynthParams::RatioMulAmountConvert(params_.ratioMul.amount.GetWithModulation());
+    args.ratioMul.mask.Update(params_.ratioMul.parttern.Get());
+
+    args.ratioAdd.enable = params_.ratioAdd.enable.Get();
+    args.ratioAdd.amount = params_.ratioAdd.amount.GetWithModulation();
+    args.ratioAdd.mask.Update(params_.ratioAdd.parttern.Get());
+
+    args.attenuation.enable = params_.attenuation.enable.Get();
+    args.attenuation.balance = params_.attenuation.balance.Get();
+    args.attenuation.symmetry = params_.attenuation.symmetry.GetWithModulation();
+    args.attenuation.mask.Update(params_.attenuation.parttern.Get());
+
+    args.periodFilter.enable = params_.periodFilter.enable.Get();
+    args.periodFilter.pinch = params_.periodFilter.pinch.GetWithModulation();
+    args.periodFilter.stretch = params_.periodFilter.stretch.Get();
+    args.periodFilter.cycle = params_.periodFilter.cycle.GetWithModulation();
+    args.periodFilter.phaseShift = params_.periodFilter.phaseShift.GetWithModulation();
+    args.periodFilter.peak = params_.periodFilter.peak.GetWithModulation();
+    args.periodFilter.apply = params_.periodFilter.apply.GetWithModulation();
+    args.periodFilter.blocks = params_.periodFilter.blocks.Get();
+
+    args.filter.enable = params_.filter.enable.Get();
+    args.filter.brightness = params_.filter.brightness.GetWithModulation();
+    args.filter.key = params_.filter.key.GetWithModulation();
+    args.filter.floor = params_.filter.floor.GetWithModulation();
+
+    args.partialBeating.enable = params_.partialBeating.enable.Get();
+    args.partialBeating.amount = params_.partialBeating.amount.GetWithModulation();
+    args.partialBeating.mask.Update(params_.partialBeating.parttern.Get());
+
+    args.pan.mode = params_.pan.mode.Get();
+    args.pan.width = params_.pan.width.GetWithModulation();
+    args.pan.center = params_.pan.center.GetWithModulation();
+}
+
+void Lazerbass::RunPipeline() {
+    if (pipelineState_.load(std::memory_order_acquire) != kPipelineRequested) {
+        return;
+    }
+
+    ProcessPartials(*pipeline_, 0, pipeline_->numPartials);
+    pipelineState_.store(kPipelineReady, std::memory_order_release);
+}
+
+void Lazerbass::ProcessPartials(PartialTable& table, uint32_t begin, uint32_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    // step1: oscilator -> ratio and gain
+    OscillatorProcessing(table, begin, end);
+
+    // step2 ratio processing
+    RatioProcessing(table, begin, end);
+
+    // step3 filter processing
+    AttenuationProcessing(table, begin, end);
+    FilterProcessing(table, begin, end);
+    PeriodFilterProcessing(table, begin, end);
+
+    // step4 update freqs
+    auto radixFundamental = table.fundamental * twoPiInvSampleRate_;
+    for (uint32_t i = begin; i < end; ++i) {
+        table.freqs[i] = table.ratios[i] * radixFundamental;
+    }
+
+    // step5 part beating process
+    BeatingProcessing(table, begin, end);
+
+    // step6 pan
+    PanProcessing(table, begin, end);
+}
+
+/* 只更新调制矩阵用到的调制器, 其他的只记下跳过的Tick, 再被用到时一次补上 */
+void Lazerbass::UpdateModulators() {
+    // 跟随MIDI时钟时bpm同步的LFO使用估计的速度, 播放中相位锁定在song position上
+    params_.tempo = clock_.IsLocked() ? clock_.GetBpm() : static_cast<float>(params_.bpm);
+    const bool beatLocked = clock_.IsLocked() && clock_.IsRunning();
+    const double beats = beatLocked ? clock_.GetBeats(sampleTime_) : 0.0;
+    lfo1_.SetBeatPosition(beatLocked, beats);
+    lfo2_.SetBeatPosition(beatLocked, beats);
+    lfo3_.SetBeatPosition(beatLocked, beats);
+    lfo4_.SetBeatPosition(beatLocked, beats);
+
+    auto update = [this](auto& modulator) {
+        if (modulationBank_.IsSourceUsed(modulator.GetOutputReg())) {
+            modulator.Tick();
+        }
+        else {
+            modulator.Skip();
+        }
+    };
+
+    update(lfo1_);
+    update(lfo2_);
+    update(lfo3_);
+    update(lfo4_);
+    if (!ampVca_) {
+        // vca时ampEnv在渲染时逐采样运行
+        update(ampEnv_);
+    }
+    update(env1_);
+    update(env2_);
+    midi_.Tick(modulationBank_, noteNumber_);
+    macros_.Tick(params_, modulationBank_);
+}
+
+// --------------------------------------------------------------------------------
+// Processing Units
+// --------------------------------------------------------------------------------
+static_assert(kOscillatorTableSize == static_cast<uint32_t>(Lazerbass::kMaxNumPartials));
+
+void Lazerbass::OscillatorProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* gains = table.gains;
+    auto* ratios = table.ratios;
+    const auto& args = table.args.oscillor;
+
+    using enum dsp::OscillatorType;
+    auto type = args.type;
+    switch (type) {
+    case kFullSaw:
+    case kDualSaw:
+    case kFullSquare:
+    case kDualSquare:
+    case kPwmSquare: {
+        const auto& base = type == kDualSaw ? kDualSawTable
+                         : type == kFullSquare ? kFullSquareTable
+                         : type == kDualSquare ? kDualSquareTable
+                         : kFullSawTable;
+        std::copy(base.ratios.cbegin() + begin, base.ratios.cbegin() + end, ratios + begin);
+        std::copy(base.gains.cbegin() + begin, base.gains.cbegin() + end, gains + begin);
+
+        /* 计算偶次谐波偏移, 都在奇数序号的分音上 */
+        auto ratioBeating = args.beating / table.fundamental + 1.0f;
+        ratioBeating *= Semitone2Ratio(args.transport);
+        for (uint32_t i = begin | 1; i < end; i += 2) {
+            ratios[i] *= ratioBeating;
+        }
+
+        if (type == kPwmSquare) {
+            /* (cos(k * pi * pw) - 1) / 2, cos用复数旋转递推, 只在起始分音调用一次三角函数 */
+            constexpr float pi = std::numbers::pi_v<float>;
+            float mul0 = args.pluseWidth * pi;
+            float stepCos = std::cos(mul0);
+            float stepSin = std::sin(mul0);
+            float c = std::cos(mul0 * (begin + 1.0f));
+            float s = std::sin(mul0 * (begin + 1.0f));
+            for (uint32_t i = begin; i < end; ++i) {
+                gains[i] *= (c - 1.0f) * 0.5f;
+                float nc = c * stepCos - s * stepSin;
+                s = s * stepCos + c * stepSin;
+                c = nc;
+            }
         }
         break;
     }
+    case kMultiSaw:
     case kMultiSquare: {
-        uint32_t numOsc = params_.oscillor.number.Get();
-        float lowestDeltaPitch = -params_.oscillor.beating.GetWithModulation();
+        uint32_t numOsc = args.number;
+        float lowestDeltaPitch = -args.beating;
         float lowestRatio = Semitone2Ratio(lowestDeltaPitch);
-        float pitchInterval = (params_.oscillor.beating.GetWithModulation() * 2) / (numOsc - 1);
+        float pitchInterval = (args.beating * 2) / (numOsc - 1);
         float ratioInterval = Semitone2Ratio(pitchInterval);
 
+        float oscRatios[SynthParams::kMaxNumOscs];
         float oscRatio = lowestRatio;
         for (uint32_t i = 0; i < numOsc; ++i) {
-            uint32_t partialIdx = 0;
-            for (uint32_t j = i; j < numProcess; j += numOsc) {
-                gains_[j] = kSawGainTable[partialIdx];
-                ratio_[j] = (partialIdx + 1.0f) * oscRatio;
-                partialIdx += 2;
-            }
+            oscRatios[i] = oscRatio;
             oscRatio *= ratioInterval;
         }
-        break;
-    }
-    case kPwmSquare: {
-        auto ratioBeating = params_.oscillor.beating.GetWithModulation() / fundamental_ + 1.0f;
-        ratioBeating *= Semitone2Ratio(params_.oscillor.transport.GetWithModulation());
-
-        constexpr float pi = std::numbers::pi_v<float>;
-        float pulseWidth = params_.oscillor.pluseWidth.GetWithModulation();
-        float mul0 = pulseWidth * pi;
 
-        for (uint32_t i = 0; i < numProcess; i += 2) {
-            ratio_[i] = i + 1.0f;
-            ratio_[i + 1] = (i + 2.0f) * ratioBeating;
-
-            gains_[i] = kSawGainTable[i] * (std::cos(mul0 * (i + 1.0f)) - 1.0f) * 0.5f;
-            gains_[i + 1] = kSawGainTable[i + 1] * (std::cos(mul0 * (i + 2.0f)) - 1.0f) * 0.5f;
+        const auto& base = type == kMultiSaw ? kMultiSawTables[numOsc - kMinNumOscs] : kMultiSquareTables[numOsc - kMinNumOscs];
+        std::copy(base.gains.cbegin() + begin, base.gains.cbegin() + end, gains + begin);
+        uint32_t oscIdx = begin % numOsc;
+        for (uint32_t j = begin; j < end; ++j) {
+            ratios[j] = base.ratios[j] * oscRatios[oscIdx];
+            if (++oscIdx == numOsc) {
+                oscIdx = 0;
+            }
         }
         break;
     }
     case kFullPulse: {
-        std::fill_n(gains_, numProcess, 0.5f);
-        for (uint32_t i = 0; i < numProcess; ++i) {
-            ratio_[i] = i + 1.0f;
-        }
+        std::fill(gains + begin, gains + end, 0.5f);
+        std::copy(kFullSawTable.ratios.cbegin() + begin, kFullSawTable.ratios.cbegin() + end, ratios + begin);
         break;
     }
     default:
         break;
     }
-    gains_[0] *= params_.oscillor.fundamental.Get();
+
+    if (begin == 0) {
+        gains[0] *= args.fundamental;
+    }
 }
 
-void Lazerbass::RatioProcessing(uint32_t numProcess) {
-    if (params_.dispersion.enable.Get()) {
-        float dp = pitch_ - 60;
+void Lazerbass::RatioProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* ratios = table.ratios;
+    const auto& args = table.args;
+
+    if (args.dispersion.enable) {
+        float dp = table.pitch - 60;
         float dpff = Semitone2Ratio(dp);
-        float l = LerpUncheck(1, 1.0f / dpff, params_.dispersion.key.GetWithModulation());
-        float shape = params_.dispersion.shape.GetWithModulation();
-        float amount = params_.dispersion.amount.GetWithModulation();
+        float l = LerpUncheck(1, 1.0f / dpff, args.dispersion.key);
+        float shape = args.dispersion.shape;
+        float amount = args.dispersion.amount;
         float absAmount = std::abs(amount);
-        for (uint32_t i = 0; i < numProcess; ++i) {
-            float idx01 = i / static_cast<float>(kMaxOrignalNumPartials);
+        for (uint32_t i = begin; i < end; ++i) {
+            // 超过原始分音数的部分保持最后的倍率, 分音不会折回来
+            float idx01 = std::min(i / static_cast<float>(kMaxOrignalNumPartials), 1.0f);
             float mul0 = ParabolaWarp(idx01, shape) * l;
             float val1 = absAmount * 4 * mul0 + 1;
             if (amount > 0) {
-                ratio_[i] *= val1;
+                ratios[i] *= val1;
             }
             else {
-                ratio_[i] /= val1;
+                ratios[i] /= val1;
             }
         }
     }
 
-    if (params_.ratioMul.enable.Get()) {
-        uint32_t parttern = params_.ratioMul.parttern.Get();
-        uint32_t notApply = parttern / 2;
-        uint32_t apply = parttern - notApply;
-        float amount = params_.ratioMul.amount.GetWithModulation();
-        amount = SynthParams::RatioMulAmountConvert(amount);
+    /* parttern的前一半分音不处理, 后一半处理 */
+    if (args.ratioMul.enable) {
+        float amount = args.ratioMul.amount;
 
-        uint32_t i = 0;
-        while (i < numProcess) {
-            i += notApply;
-            for (uint32_t j = 0; j < apply && i < numProcess; ++j) {
-                ratio_[i] *= amount;
-                ++i;
+        for (uint32_t i = begin; i < end; ++i) {
+            if (args.ratioMul.mask.Test(i)) {
+                ratios[i] *= amount;
             }
         }
     }
 
-    if (params_.ratioAdd.enable.Get()) {
-        uint32_t parttern = params_.ratioAdd.parttern.Get();
-        uint32_t notApply = parttern / 2;
-        uint32_t apply = parttern - notApply;
-        float amount = params_.ratioAdd.amount.GetWithModulation();
+    if (args.ratioAdd.enable) {
+        float amount = args.ratioAdd.amount;
 
-        uint32_t i = 0;
-        while (i < numProcess) {
-            i += notApply;
-            for (uint32_t j = 0; j < apply && i < numProcess; ++j) {
-                ratio_[i] += amount;
-                ++i;
+        for (uint32_t i = begin; i < end; ++i) {
+            if (args.ratioAdd.mask.Test(i)) {
+                ratios[i] += amount;
             }
         }
     }
 }
 
-void Lazerbass::BeatingProcessing(uint32_t numProcess) {
-    if (params_.partialBeating.enable.Get()) {
-        uint32_t parttern = params_.partialBeating.parttern.Get();
-        uint32_t notApply = parttern / 2;
-        uint32_t apply = parttern - notApply;
-        float amount = params_.partialBeating.amount.GetWithModulation();
-        float radixFreq = amount * twoPiInvSampleRate_;
+void Lazerbass::BeatingProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* freqs = table.freqs;
+    const auto& args = table.args.partialBeating;
 
-        uint32_t i = 0;
-        while (i < numProcess) {
-            i += notApply;
-            for (uint32_t j = 0; j < apply && i < numProcess; ++j) {
-                freqs_[i] += radixFreq;
-                ++i;
+    if (args.enable) {
+        float radixFreq = args.amount * twoPiInvSampleRate_;
+
+        for (uint32_t i = begin; i < end; ++i) {
+            if (args.mask.Test(i)) {
+                freqs[i] += radixFreq;
             }
         }
     }
 }
 
+/* 每个分音固定的随机数, -1~1, 不依赖rand()所以每个Tick都一样 */
+static constexpr float PanHash(uint32_t idx) {
+    uint32_t h = idx * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+    return (h >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/* 近似等功率声像, sin(pi/2 * x) ~= x * (1.5 - 0.5 * x^2)
+ * 乘以sqrt(2)使中间位置两边增益为1, 和单声道一样响
+ */
+void Lazerbass::PanProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    if (!table.stereo) {
+        return;
+    }
+
+    const auto& args = table.args.pan;
+    float width = args.width;
+    float center = args.center;
+    float invNumPartials = 1.0f / table.numPartials;
+    auto mode = args.mode;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        float side = (i & 1) ? 1.0f : -1.0f;
+        float pos = 0.0f;
+        switch (mode) {
+        case PanMode::kAlternate:
+            pos = side * width;
+            break;
+        case PanMode::kSpread:
+            pos = side * width * (i + 1) * invNumPartials;
+            break;
+        case PanMode::kRandom:
+            pos = PanHash(i) * width;
+            break;
+        default:
+            break;
+        }
+        if (i == 0) {
+            // 基音保持在中间
+            pos = 0.0f;
+        }
+        pos = ClampUncheck(pos + center, -1.0f, 1.0f);
+
+        float xr = (pos + 1.0f) * 0.5f;
+        float xl = 1.0f - xr;
+        constexpr float kSqrt2 = std::numbers::sqrt2_v<float>;
+        table.panLefts[i] = xl * (1.5f - 0.5f * xl * xl) * kSqrt2;
+        table.panRights[i] = xr * (1.5f - 0.5f * xr * xr) * kSqrt2;
+    }
+}
+
 void Lazerbass::PhaseProcessing(uint32_t numProcess) {
     if (params_.oscPhase.enable.Get()) {
         float randomAmount = params_.oscPhase.random.GetWithModulation();
         float symmetry = params_.oscPhase.symmetry.GetWithModulation();
-        uint32_t parttern = params_.oscPhase.parttern.Get();
 
-        uint32_t applyLeft = parttern / 2;
-        uint32_t applyRight = parttern - applyLeft;
         float maxRadix = std::numbers::pi_v<float> * randomAmount;
         float leftAmount = (1.0f - symmetry) * 2.0f * maxRadix;
         float rightAmount = symmetry * 2.0f * maxRadix;
 
-        uint32_t i = 0;
-        while (i < numProcess) {
-            uint32_t loopLeft = std::min(applyLeft, numProcess - i);
-            for (uint32_t j = 0; j < loopLeft; ++j) {
-                phase_[i++] = leftAmount * rand() / static_cast<float>(RAND_MAX);
-            }
+        for (uint32_t i = 0; i < numProcess; ++i) {
+            float amount = phaseMask_.Test(i) ? rightAmount : leftAmount;
+            phase_[i] = amount * rand() / static_cast<float>(RAND_MAX);
+        }
+    }
+}
 
-            uint32_t loopRight = std::min(applyRight, numProcess - i);
-            for (uint32_t j = 0; j < loopRight; ++j) {
-                phase_[i++] = rightAmount * rand() / static_cast<float>(RAND_MAX);
-            }
+/* parttern的前一半分音为左, 后一半为右
+ * balance小于50时衰减右边, 大于50时衰减左边
+ * symmetry把衰减偏向高次(>0)或低次(<0)分音
+ */
+void Lazerbass::AttenuationProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* gains = table.gains;
+    const auto& args = table.args.attenuation;
+
+    if (args.enable) {
+        float balance = args.balance / 50.0f;
+        float symmetry = args.symmetry;
+        float leftAttenuation = 1.0f - std::min(2.0f - balance, 1.0f);
+        float rightAttenuation = 1.0f - std::min(balance, 1.0f);
+
+        for (uint32_t i = begin; i < end; ++i) {
+            float idx01 = i / static_cast<float>(kMaxOrignalNumPartials);
+            float weight = ClampUncheck(1.0f + symmetry * (idx01 * 2.0f - 1.0f), 0.0f, 1.0f);
+            float attenuation = args.mask.Test(i) ? rightAttenuation : leftAttenuation;
+            gains[i] *= 1.0f - weight * attenuation;
         }
     }
 }
 
-void Lazerbass::PeriodFilterProcessing(uint32_t numProcess) {
-    if (params_.periodFilter.enable.Get()) {
-        float argPeak = params_.periodFilter.peak.GetWithModulation();
-        float argApply = params_.periodFilter.apply.GetWithModulation();
-        bool argBlocks = params_.periodFilter.blocks.Get();
-        float argPinch = params_.periodFilter.pinch.GetWithModulation();
-        bool argStretch = params_.periodFilter.stretch.Get();
-        float argCycle = params_.periodFilter.cycle.GetWithModulation();
-        float argPhaseShift = params_.periodFilter.phaseShift.GetWithModulation();
+void Lazerbass::PeriodFilterProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* gains = table.gains;
+    const uint32_t numProcess = table.numPartials;
 
-        float log2NumProcess = 1.0f / std::log2(numProcess);
+    // MCF的分音记下滤波之前的增益, 没有开启时相位为0
+    const uint32_t mcfEnd = std::min(end, kMaxMcfPartials);
+    if (begin < mcfEnd) {
+        std::copy(gains + begin, gains + mcfEnd, table.filterGains + begin);
+        std::fill(table.filterPhases + begin, table.filterPhases + mcfEnd, 0.0f);
+    }
 
-        const float magFloor = LerpUncheck(24.0f, 300.0f, argPeak);
-        const float lerpVal0 = YUpBp1(argPeak, 0.5f);
-        const float val0 = 1.0f + argApply * 0.3f
-                        + argPeak * 1.2f * (1.0f - argBlocks);
-        const float val1 = val0 * argApply;
-        const float val2 = 1.0f - argApply;
+    const auto& args = table.args.periodFilter;
+    if (args.enable) {
+        float argPinch = args.pinch;
+        bool argStretch = args.stretch;
+        float argCycle = args.cycle;
+        float argPhaseShift = args.phaseShift;
 
-        for (uint32_t i = 0; i < numProcess; ++i) {
+        float log2NumProcess = 1.0f / std::log2(numProcess);
+        const auto shape = MakePeriodFilterShape(args.peak, args.apply, args.blocks);
+
+        for (uint32_t i = begin; i < end; ++i) {
             float idx01 = i / static_cast<float>(kMaxOrignalNumPartials);
             float val0 = ParabolaWarp(idx01, argPinch);
-            float phase0 = val0 * argCycle + argPhaseShift;
+            float phase0 = val0 * argCycle;
             if (argStretch) {
                 phase0 = val0 * argCycle * numProcess + 1;
                 float val1 = std::log2(phase0);
                 float val2 = argCycle * log2NumProcess;
-                phase0 = val1 * val2 + argPhaseShift;
+                phase0 = val1 * val2;
             }
-            float phaseRound = phase0 - static_cast<int32_t>(phase0);
-            float waveVal = phaseRound > 0.5f ? 1.0f : 0.0f;
-            if (!argBlocks) {
-                waveVal = std::cos(phaseRound * std::numbers::pi_v<float> * 2.0f);
-                waveVal = (waveVal + 1.0f) * 0.5f;
+            if (i < mcfEnd) {
+                table.filterPhases[i] = phase0;
             }
-
-            float mag = (waveVal - 1.0f) * magFloor;
-            float level = Db2Gain(mag);
-            float level0 = LerpUncheck(waveVal, level, lerpVal0);
-            float level1 = level0 * val1 + val2;
-            gains_[i] *= level1;
+            gains[i] *= PeriodFilterLevel(phase0 + argPhaseShift, shape);
         }
     }
 }
 
-void Lazerbass::FilterProcessing(uint32_t numProcess) {
+static constexpr float kFilterMinCutoffPitch = 24.0f;
+static constexpr float kFilterMaxCutoffPitch = 144.0f;
+static constexpr float kFilterFloorDb = 96.0f;
+static constexpr float kFilterCullGain = 1.5849e-5f; // -96dB
+
+/* 跟随音高的频谱低通, 增益曲线 1 / (1 + (r/rc)^2), 截止频率以上-12dB/oct
+ * 每个分音只有一次乘法和一次除法, 没有libm调用
+ * floor为1时衰减到-96dB以下的分音增益直接置0, 渲染时只计算相位
+ */
+void Lazerbass::FilterProcessing(PartialTable& table, uint32_t begin, uint32_t end) {
+    auto* gains = table.gains;
+    const auto* ratios = table.ratios;
+
+    const auto& args = table.args.filter;
+    if (args.enable) {
+        float brightness = args.brightness;
+        float key = args.key;
+        float floor = args.floor;
+
+        float cutoffPitch = LerpUncheck(kFilterMinCutoffPitch, kFilterMaxCutoffPitch, brightness)
+                          + (table.pitch - 60.0f) * key;
+        float invCutoffRatio = table.fundamental / Semitone2Hz(cutoffPitch);
+        float floorGain = floor < 1.0f ? Db2Gain(-kFilterFloorDb * floor) : 0.0f;
+
+        for (uint32_t i = begin; i < end; ++i) {
+            float x = ratios[i] * invCutoffRatio;
+            float lp = 1.0f / (1.0f + x * x);
+            gains[i] *= lp > kFilterCullGain ? std::max(lp, floorGain) : floorGain;
+        }
+    }
 }
 
+// --------------------------------------------------------------------------------
+// Output formats
+// --------------------------------------------------------------------------------
+template void Lazerbass::Process(std::span<StereoSample16> block);
+template void Lazerbass::Process(std::span<StereoSample32> block);
+
 }
@@ -1,48 +1,265 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <span>
 #include <vector>
 #include "Types.hpp"
 #include "dsp/params.hpp"
 #include "dsp/ModulationBank.hpp"
+#include "dsp/PatternMask.hpp"
+#include "dsp/IfftRenderer.hpp"
+#include "dsp/MultirateMixer.hpp"
 #include "dsp/LFO.hpp"
 #include "dsp/Envelope.hpp"
+#include "dsp/MidiModulators.hpp"
+#include "dsp/Macros.hpp"
+#include "dsp/MidiClock.hpp"
+#include "dsp/Sequencer.hpp"
+#include "dsp/effect/EffectChain.hpp"
 
 namespace dsp {
 
 class Lazerbass {
 public:
-    static constexpr int kMaxNumPartials = 256;
+    static constexpr int kMaxNumPartials = 1024;
+    static constexpr uint32_t kMaxMcfPartials = 256;     // 超过时切换到反FFT合成
+    static constexpr uint32_t kBackendHysteresis = 32;   // 切回MCF的分音数余量
     static constexpr int kMaxOrignalNumPartials = 324;
     static constexpr float kMaxFreq = 12000.0f;
     static constexpr uint32_t kInvalidNoteNumber = 1024;
+    static constexpr uint32_t kMaxBlockSize = 256;
+    static constexpr uint32_t kNumTickSlices = 4;
+    static constexpr float kBandHysteresis = 0.94f;      // 进入低速率频段的频率余量, 约一个半音
+    static constexpr uint32_t kMinDecimatedPartials = 8; // 少于这个数时插值的开销比省下的多
+    static constexpr uint32_t kRenormPartialsPerTick = 16; // 每个Tick校正振幅的MCF分音数
+    static constexpr uint32_t kAudioRateBlock = 16;       // 音频速率调制的更新间隔(采样)
+    static constexpr float kMaxAudioRateSemitones = 3.0f; // Tick之间音高偏离Tick时的值的上限
+    static constexpr uint32_t kRealtimeQueueSize = 32;    // MIDI实时消息的队列, 2的幂
 
-    Lazerbass();
+    using Mask = PatternMask<kMaxNumPartials>;
+
+    /* PrepareTable时从params_拷贝的参数(带调制)和parttern,
+     * 分音计算只读这里, 预计算任务不持有音频锁也不会和Tick里的调制更新冲突
+     */
+    struct PartialArgs {
+        struct {
+            OscillatorType type{};
+            uint32_t number{};
+            float beating{};
+            float transport{};
+            float pluseWidth{};
+            float fundamental{};
+        } oscillor;
+        struct {
+            bool enable{};
+            float key{};
+            float shape{};
+            float amount{};
+        } dispersion;
+        struct {
+            bool enable{};
+            float amount{}; // 已经转换成倍率
+            Mask mask;
+        } ratioMul;
+        struct {
+            bool enable{};
+            float amount{};
+            Mask mask;
+        } ratioAdd;
+        struct {
+            bool enable{};
+            float balance{};
+            float symmetry{};
+            Mask mask;
+        } attenuation;
+        struct {
+            bool enable{};
+            float pinch{};
+            bool stretch{};
+            float cycle{};
+            float phaseShift{};
+            float peak{};
+            float apply{};
+            bool blocks{};
+        } periodFilter;
+        struct {
+            bool enable{};
+            float brightness{};
+            float key{};
+            float floor{};
+        } filter;
+        struct {
+            bool enable{};
+            float amount{};
+            Mask mask;
+        } partialBeating;
+        struct {
+            PanMode mode{};
+            float width{};
+            float center{};
+        } pan;
+    };
+
+    static_assert(static_cast<uint32_t>(kMaxNumPartials) <= IfftRenderer::kMaxNumPartials);
+    static_assert(kMaxBlockSize <= MultirateMixer::kMaxBlockSize);
+
+    /* 一个Tick的频谱, 渲染时只读front, 计算写入back */
+    struct PartialTable {
+        uint32_t numPartials{};
+        float pitch{};
+        float fundamental{};
+        PartialArgs args;
+        float ratios[kMaxNumPartials]{};
+        float freqs[kMaxNumPartials]{};
+        float gains[kMaxNumPartials]{};
+        bool stereo{};
+        float panLefts[kMaxNumPartials]{};
+        float panRights[kMaxNumPartials]{};
+        // PeriodFilter之前的增益和不带phaseShift的相位, 音频速率的phaseShift用
+        float filterGains[kMaxMcfPartials]{};
+        float filterPhases[kMaxMcfPartials]{};
+    };
+    static constexpr uint32_t kNumPartialTables = 3; // front, back, pipeline
+
+    /**
+     * @param tables 分音表, 1024个分音的表放不进DTCM, 由持有者放在SRAM D1
+     * @param effectMemory 效果器延迟线的内存, 由持有者放在SRAM D2
+     */
+    Lazerbass(std::span<PartialTable, kNumPartialTables> tables,
+              std::span<float, EffectChain::kArenaSize> effectMemory);
 
     void Init(uint32_t sampleRate, uint32_t updateRate);
-    void Process(std::span<StereoSample> block);
+    /**
+     * @brief TSample为StereoSample16或者StereoSample32, 输出格式的转换在编译期特化
+     */
+    template<class TSample>
+    void Process(std::span<TSample> block);
 
     SynthParams& GetParams() { return params_; }
+    bool IsIfftBackend() const { return useIfft_; }
+    uint32_t GetNumDecimatedPartials() const { return numHalfRate_ + numQuarterRate_; }
     ModulationBank& GetModulationBank() { return modulationBank_; }
+    EffectChain& GetEffectChain() { return effects_; }
+    Sequencer& GetSequencer() { return sequencer_; }
+    const MidiClock& GetMidiClock() const { return clock_; }
     ModulatorDesc GetModulatorDesc(ModulatorId id);
+    /**
+     * @brief MIDI CC1~127作为调制器
+     */
+    ModulatorDesc GetControllerModulatorDesc(uint32_t controller) { return midi_.GetControllerModulatorDesc(controller); }
+    /**
+     * @brief LFO缓存的频率(hz), 不带调制, GUI显示用
+     */
+    float GetLfoRate(ModulatorId id) const;
 
+    /**
+     * @brief 外部演奏的音符, 音序器录音时同时写入音序器
+     */
     void NoteOn(uint32_t noteNumber, float velocity);
     void NoteOff(uint32_t noteNumber, float velocity);
-    void SetPitchBend(float pitchBend) { pitchBend_ = pitchBend; }
+    /* MIDI任务中调用, 不需要持有音频锁, 下一个Tick生效 */
+    void SetPitchBend(float pitchBend) { pitchBend_.store(pitchBend, std::memory_order_relaxed); } // -1~1
+    void ControlChange(uint32_t controller, uint32_t value) { midi_.ControlChange(controller, value); }
+    void ChannelPressure(uint32_t value) { midi_.ChannelPressure(value); }
+    void PolyPressure(uint32_t noteNumber, uint32_t value) { midi_.PolyPressure(noteNumber, value); }
+    /**
+     * @brief MIDI实时消息(0xf8~0xfc)和song position(0xf2), MIDI任务中调用, 不需要持有音频锁
+     * @param cycles 收到的时间, bsp::Time::GetCycles(), 音频任务换算成采样
+     */
+    void MidiRealtime(uint32_t status, uint32_t value, uint32_t cycles);
+    /**
+     * @brief 音频任务在每个block开始时调用, 这个时刻对应block的第一个采样
+     */
+    void BeginBlock(uint32_t cycles) {
+        blockCycles_ = cycles;
+        blockSample_ = sampleTime_;
+    }
+    void SetCpuClock(uint32_t hz) { samplesPerCycle_ = static_cast<float>(sampleRate_) / hz; }
+    void SetUpdateRate(uint32_t updateRate);
+
+    /**
+     * @brief 到下一个Tick还有多少采样, 音频任务按这个分块调用Process
+     */
+    uint32_t GetSamplesToNextTick() const { return tickPos_ > 0 ? tickPos_ : tickPreiod_; }
+
+    /**
+     * @brief pipeline调度下是否有分音表等待预计算任务处理
+     */
+    bool IsPipelineRequested() const { return pipelineState_.load(std::memory_order_acquire) == kPipelineRequested; }
+
+    /**
+     * @brief 预计算任务调用, 不需要持有音频锁
+     */
+    void RunPipeline();
+
+    /**
+     * @brief 每个音频速率调制目标累计的周期数, 音频任务每个block读取后清零
+     *        pitch和beating共用一次系数更新, 都打开时记在pitch上
+     */
+    uint32_t GetAudioRateCycles(AudioRateTarget target) const { return audioRateCycles_[static_cast<uint32_t>(target)]; }
+    void ClearAudioRateCycles() { audioRateCycles_.fill(0); }
+    /**
+     * @brief MCF分音振幅和1的最大偏差, 测试RenormalizeMcf用, 反FFT合成时返回0
+     */
+    float GetMcfAmplitudeError() const;
 private:
+    enum : uint32_t {
+        kPipelineIdle = 0,  // 音频任务持有
+        kPipelineRequested, // 预计算任务持有
+        kPipelineReady      // 计算完成, 等待下一个Tick交换
+    };
+
+    void PrepareTable(PartialTable& table, uint32_t numPartials);
     void Tick();
+    void ProcessPartials(PartialTable& table, uint32_t begin, uint32_t end);
     void UpdateModulators();
-    void AudioGen(StereoSample* out, uint32_t numSamples);
+    // 渲染到mix_(和mixRight_), 返回是否是立体声
+    bool AudioGen(uint32_t numSamples);
+    bool AudioGenSmooth(uint32_t numSamples);
+    bool AudioGenIfft(uint32_t numSamples);
+    // ampEnv的vca逐采样乘到mix_(和mixRight_)
+    void ApplyAmpEnvelope(uint32_t numSamples, bool stereo);
+    void McfRender(const uint16_t* partials, uint32_t numPartials, uint32_t rate,
+                   float* left, float* right, uint32_t numSamples, bool stereo);
+    void McfRenderSmooth(const uint16_t* partials, uint32_t numPartials,
+                         float* left, float* right, uint32_t numSamples, bool stereo);
+    template<class TSample>
+    void MixToOutput(TSample* out, uint32_t numSamples, bool stereo);
+    float TpdfDither();
+    void BeginRamp(uint32_t numPartials, bool resetCoefs);
+    void RenormalizeMcf();
     void ResetPhase();
     void ResetModulators();
+    uint32_t CountActivePartials(const PartialTable& table) const;
+    void UpdateBackend(bool resetPhase);
+    void UpdateBands(bool resetPhase, bool restart);
+    float GetMcfPhase(uint32_t idx) const;
+    void SetMcfPhase(uint32_t idx, float theta, float freq);
+    void GetBandGains(uint32_t idx, bool restart, float& left, float& right) const;
+    // 音频速率的调制和音高的滑动需要smooth渲染的斜坡
+    bool IsSmoothRender() const { return params_.render.smooth.Get() || audioFreq_ || audioGain_ || pitchMoving_; }
+    void StartGlide(bool sounding);
+    void UpdatePitch();
+    void UpdateAudioRate();
+    void AudioRateStep(uint32_t elapsed, uint32_t numSamples);
+    float PeekModulator(const float* outputReg, float ticks);
 
-    void OscillatorProcessing(uint32_t numProcess);
-    void RatioProcessing(uint32_t numProcess);
-    void BeatingProcessing(uint32_t numProcess);
+    void OscillatorProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+    void RatioProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+    void BeatingProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+    void PanProcessing(PartialTable& table, uint32_t begin, uint32_t end);
     void PhaseProcessing(uint32_t numProcess);
     
-    void PeriodFilterProcessing(uint32_t numProcess);
-    void FilterProcessing(uint32_t numProcess);
+    void AttenuationProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+    void PeriodFilterProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+    void FilterProcessing(PartialTable& table, uint32_t begin, uint32_t end);
+
+    void TriggerNote(uint32_t noteNumber, float velocity);
+    // 执行音序器这个采样上的事件, 新音符时立即Tick
+    void RunSequencer();
+    // 取出MIDI实时消息交给MidiClock, 在每次Process开始时调用
+    void RunRealtime();
 
     uint32_t NoteEnqueue(uint32_t noteNumber);
     uint32_t NoteDequeue(uint32_t noteNumber);
@@ -52,32 +269,87 @@ private:
     float maxRadiusFreqs_{};
     uint32_t tickPos_{};
     uint32_t tickPreiod_{};
+    uint32_t updateRate_{};
+    uint32_t sampleTime_{};   // 渲染过的采样数, MIDI时钟和音序器的时间
+
+    // tick schedule
+    TickSchedule schedule_{};
+    uint32_t sliceBegin_{};
+    uint32_t slicePartials_{};
+    uint32_t sliceSamples_{};
 
-    // mcf
-    float sin0_[kMaxNumPartials]{};
-    float sin1_[kMaxNumPartials]{};
-    float coefs_[kMaxNumPartials]{};
+    // mcf, 只渲染前kMaxMcfPartials个分音
+    uint32_t mcfPartials_{};
+    float sin0_[kMaxMcfPartials]{};
+    float sin1_[kMaxMcfPartials]{};
+    float coefs_[kMaxMcfPartials]{};
+    uint32_t renormPos_{};
 
     // sines
-    float freqs_[kMaxNumPartials]{};
-    float oldFreqs_[kMaxNumPartials]{};
+    float oldFreqs_[kMaxMcfPartials]{};
     float phase_[kMaxNumPartials]{};
-    bool enable_[kMaxNumPartials]{};
+    bool enable_[kMaxMcfPartials]{};
+
+    // multirate, 按rate排列的分音: 全速率, fs/2, fs/4
+    uint8_t rates_[kMaxMcfPartials]{};
+    uint16_t bandPartials_[kMaxMcfPartials]{};
+    uint32_t numFullRate_{};
+    uint32_t numHalfRate_{};
+    uint32_t numQuarterRate_{};
+    uint32_t numRatePartials_{};
+    MultirateMixer multirate_;
+
+    // ifft render
+    bool useIfft_{};
+    IfftRenderer ifft_;
+
+    // smooth render
+    bool smooth_{};
+    bool rampStereo_{};
+    float rampGains_[kMaxMcfPartials]{};
+    float rampGainIncs_[kMaxMcfPartials]{};
+    float rampRightGains_[kMaxMcfPartials]{};
+    float rampRightGainIncs_[kMaxMcfPartials]{};
+    float coefIncs_[kMaxMcfPartials]{};
+
+    // audio rate modulation, 在smooth渲染的斜坡上叠加
+    bool audioPitch_{};
+    bool audioBeating_{};
+    bool audioFreq_{};     // pitch或者beating, 不使用IFFT时
+    bool audioGain_{};
+    float modCoefs_[kMaxMcfPartials]{};    // coefs_中音频速率调制的部分
+    float modCoefIncs_[kMaxMcfPartials]{};
+    float baseSin_[kMaxMcfPartials]{};     // 斜坡终点的sin(w/2), cos(w/2)
+    float baseCos_[kMaxMcfPartials]{};
+    std::array<uint32_t, static_cast<uint32_t>(AudioRateTarget::kCount)> audioRateCycles_{};
+
+    float mix_[kMaxBlockSize]{};
+    float mixRight_[kMaxBlockSize]{};
+    uint32_t ditherSeed_{ 22222 };
 
     // notes
     bool output_{};
+    bool ampVca_{};
     float velocity_{};
     bool hasNoteOn_{};
 
     // pitch and fundamental
     uint32_t noteNumber_{};
-    float pitchBend_{};
+    std::atomic<float> pitchBend_{};
+    float glidePitch_{};   // 滑动中的音符音高
+    float glideStep_{};    // 每个Tick滑动的半音, 0时没有滑动
+    float renderPitch_{};  // 正在渲染的表的音高
+    bool pitchMoving_{};   // 这个Tick渲染的音高改变了, 按smooth渲染
     float pitch_{};
     float fundamental_{};
 
     // processings
-    float gains_[kMaxNumPartials]{};
-    float ratio_[kMaxNumPartials]{};
+    Mask phaseMask_;
+    PartialTable* front_{};
+    PartialTable* back_{};
+    PartialTable* pipeline_{};
+    std::atomic<uint32_t> pipelineState_{ kPipelineIdle };
+    bool pipelineStale_{};
 
     // note statck
     std::vector<uint8_t> noteStack_;
@@ -92,6 +364,26 @@ private:
     Envelope ampEnv_;
     Envelope env1_;
     Envelope env2_;
+    MidiModulators midi_;
+    Macros macros_;
+    MidiClock clock_;
+    Sequencer sequencer_;
+
+    // MIDI实时消息, MIDI任务写, 音频任务读
+    struct RealtimeMessage {
+        uint32_t cycles;
+        uint16_t value;
+        uint8_t status;
+    };
+    std::array<RealtimeMessage, kRealtimeQueueSize> realtimeQueue_{};
+    std::atomic<uint32_t> realtimeWrite_{};
+    std::atomic<uint32_t> realtimeRead_{};
+    uint32_t blockCycles_{};
+    uint32_t blockSample_{};
+    float samplesPerCycle_{};
+
+    // effects
+    EffectChain effects_;
 };
 
 }
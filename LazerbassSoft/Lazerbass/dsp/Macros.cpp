@@ -0,0 +1,53 @@
+#include "Macros.hpp"
+#include <cmath>
+#include "ModulationBank.hpp"
+
+namespace dsp {
+
+static constexpr const char* kMacroNames[] = { "macro1", "macro2", "macro3", "macro4" };
+static_assert(std::size(kMacroNames) == Macros::kNumMacros);
+
+using MacroParams = decltype(SynthParams::macro);
+static constexpr FloatParamDesc MacroParams::* kKnobs[] = {
+    &MacroParams::macro1, &MacroParams::macro2, &MacroParams::macro3, &MacroParams::macro4
+};
+static_assert(std::size(kKnobs) == Macros::kNumMacros);
+
+void Macros::Init(uint32_t updateRate) {
+    SetUpdateRate(updateRate);
+}
+
+void Macros::SetUpdateRate(uint32_t updateRate) {
+    smoothK_ = -std::expm1(-1.0f / (kSmoothTime * updateRate));
+}
+
+/* 没有被使用的宏直接跟随旋钮, 重新连上时不从旧值滑过来 */
+void Macros::Tick(const SynthParams& params, const ModulationBank& bank) {
+    for (uint32_t i = 0; i < kNumMacros; ++i) {
+        const float target = GetKnob(params, i).Get();
+        if (bank.IsSourceUsed(&outputs_[i])) {
+            outputs_[i] += (target - outputs_[i]) * smoothK_;
+        }
+        else {
+            outputs_[i] = target;
+        }
+    }
+}
+
+FloatParamDesc& Macros::GetKnob(SynthParams& params, uint32_t macro) {
+    return params.macro.*kKnobs[macro % kNumMacros];
+}
+
+const FloatParamDesc& Macros::GetKnob(const SynthParams& params, uint32_t macro) {
+    return params.macro.*kKnobs[macro % kNumMacros];
+}
+
+ModulatorDesc Macros::GetModulatorDesc(uint32_t macro) {
+    macro = macro < kNumMacros ? macro : 0;
+    ModulatorDesc desc;
+    desc.name = kMacroNames[macro];
+    desc.outputReg = &outputs_[macro];
+    return desc;
+}
+
+}
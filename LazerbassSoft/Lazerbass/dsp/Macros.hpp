@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include "params.hpp"
+#include "ModulatorDesc.hpp"
+
+namespace dsp {
+
+class ModulationBank;
+
+/**
+ * @brief 宏旋钮, 每个宏是一个调制器, 驱动的目标就是以它为源的调制link
+ *        每个目标有自己的范围(link的offset ~ offset + amount)和曲线, 和其他link一起编译进调制矩阵
+ *        旋钮的值是SynthParams::macro里的参数, 输出在Tick里平滑, 编码器的跳变不会有拉链噪声
+ */
+class Macros {
+public:
+    static constexpr uint32_t kNumMacros = 4;
+    static constexpr float kSmoothTime = 0.02f;      // 平滑的时间常数(秒)
+
+    void Init(uint32_t updateRate);
+    void SetUpdateRate(uint32_t updateRate);
+
+    /**
+     * @brief 平滑调制矩阵使用的宏, 在音频任务中调用
+     */
+    void Tick(const SynthParams& params, const ModulationBank& bank);
+
+    static FloatParamDesc& GetKnob(SynthParams& params, uint32_t macro);
+    static const FloatParamDesc& GetKnob(const SynthParams& params, uint32_t macro);
+    ModulatorDesc GetModulatorDesc(uint32_t macro);
+
+private:
+    float outputs_[kNumMacros]{};
+    float smoothK_{ 1.0f };
+};
+
+}
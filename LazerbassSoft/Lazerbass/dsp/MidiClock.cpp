@@ -0,0 +1,118 @@
+#include "MidiClock.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+void MidiClock::Init(uint32_t sampleRate) {
+    sampleRate_ = sampleRate;
+    minPeriod_ = 60.0f * sampleRate / (kClocksPerBeat * kMaxBpm);
+    maxPeriod_ = 60.0f * sampleRate / (kClocksPerBeat * kMinBpm);
+    period_ = 60.0f * sampleRate / (kClocksPerBeat * 120.0f);
+    numClocks_ = 0;
+    running_ = false;
+    waiting_ = false;
+    started_ = false;
+}
+
+/* 从这个时钟重新开始估计, 保留上次的周期 */
+void MidiClock::Restart(uint32_t time) {
+    numClocks_ = 1;
+    lastTime_ = time;
+    predTime_ = time;
+    predFrac_ = 0.0f;
+}
+
+void MidiClock::Clock(uint32_t time) {
+    if (running_) {
+        position_ = nextPosition_++;
+        if (waiting_) {
+            waiting_ = false;
+            started_ = true;
+        }
+    }
+
+    if (numClocks_ == 0) {
+        Restart(time);
+        return;
+    }
+
+    if (numClocks_ == 1) {
+        // 第二个时钟: 间隔就是周期
+        const auto interval = static_cast<float>(static_cast<int32_t>(time - lastTime_));
+        if (interval < minPeriod_ || interval > maxPeriod_) {
+            Restart(time);
+            return;
+        }
+        period_ = interval;
+        numClocks_ = 2;
+        lastTime_ = time;
+        predTime_ = time;
+        predFrac_ = period_;
+    }
+    else {
+        const float err = static_cast<float>(static_cast<int32_t>(time - predTime_)) - predFrac_;
+        if (std::abs(err) > 0.5f * period_) {
+            // 丢了时钟或者速度跳变
+            Restart(time);
+            return;
+        }
+
+        // 最小二乘的增益, 第n个时钟: alpha = 2(2n-1)/(n(n+1)), beta = 6/(n(n+1))
+        const auto n = static_cast<float>(numClocks_);
+        const float alpha = std::max(2.0f * (2.0f * n - 1.0f) / (n * (n + 1.0f)), kAlpha);
+        const float beta = std::max(6.0f / (n * (n + 1.0f)), kBeta);
+        period_ = std::clamp(period_ + beta * err, minPeriod_, maxPeriod_);
+        predFrac_ += alpha * err + period_;
+        ++numClocks_;
+        lastTime_ = time;
+    }
+
+    const float whole = std::floor(predFrac_);
+    predTime_ += static_cast<uint32_t>(static_cast<int32_t>(whole));
+    predFrac_ -= whole;
+}
+
+void MidiClock::Start() {
+    running_ = true;
+    waiting_ = true;
+    nextPosition_ = 0;
+}
+
+void MidiClock::Continue() {
+    running_ = true;
+    waiting_ = true;
+}
+
+void MidiClock::Stop() {
+    running_ = false;
+    waiting_ = false;
+}
+
+void MidiClock::SongPosition(uint32_t sixteenths) {
+    nextPosition_ = sixteenths * kClocksPerStep;
+}
+
+void MidiClock::CheckTimeout(uint32_t now) {
+    if (numClocks_ == 0) {
+        return;
+    }
+    const auto elapsed = static_cast<float>(static_cast<int32_t>(now - lastTime_));
+    const float timeout = numClocks_ >= 2 ? kTimeoutBeats * kClocksPerBeat * period_ : maxPeriod_;
+    if (elapsed > timeout) {
+        numClocks_ = 0;
+    }
+}
+
+float MidiClock::GetTimeUntil(uint32_t position, uint32_t now) const {
+    const auto next = static_cast<float>(static_cast<int32_t>(predTime_ - now)) + predFrac_;
+    return next + static_cast<float>(static_cast<int32_t>(position - (position_ + 1))) * period_;
+}
+
+double MidiClock::GetBeats(uint32_t now) const {
+    const float until = GetTimeUntil(position_ + 1, now);
+    const float frac = std::clamp(1.0f - until / period_, 0.0f, 1.0f);
+    return (static_cast<double>(position_) + frac) / kClocksPerBeat;
+}
+
+}
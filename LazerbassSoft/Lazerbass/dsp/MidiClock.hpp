@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+
+namespace dsp {
+
+/**
+ * @brief MIDI时钟(24 ppqn)的速度和位置估计, 在音频任务中调用, 时间的单位是采样
+ *        alpha-beta滤波(二阶锁相环): 预测下一个时钟的时间, 用到达时间的误差修正相位(alpha)和周期(beta)
+ *        USB每1ms一帧, 到达时间有1ms左右的抖动, 周期每个时钟只修正beta倍的误差
+ *        开始时按最小二乘的增益快速收敛, 逐渐减小到稳态的kAlpha
+ */
+class MidiClock {
+public:
+    static constexpr uint32_t kClocksPerBeat = 24;
+    static constexpr uint32_t kClocksPerStep = 6;      // 16分音符, song position的单位
+    static constexpr float kAlpha = 0.05f;
+    static constexpr float kBeta = kAlpha * kAlpha / (2.0f - kAlpha);
+    static constexpr uint32_t kLockClocks = kClocksPerBeat; // 收到一拍的时钟后认为锁定
+    static constexpr float kMinBpm = 20.0f;
+    static constexpr float kMaxBpm = 400.0f;
+    static constexpr float kTimeoutBeats = 2.0f;       // 超过这个时间没有时钟时失锁
+
+    void Init(uint32_t sampleRate);
+
+    /* 实时消息, time是到达时间 */
+    void Clock(uint32_t time);
+    void Start();
+    void Continue();
+    void Stop();
+    void SongPosition(uint32_t sixteenths);
+    /**
+     * @brief 太久没有时钟时失锁, 每个Tick调用
+     */
+    void CheckTimeout(uint32_t now);
+
+    bool IsLocked() const { return numClocks_ >= kLockClocks; }
+    /**
+     * @brief 至少收到了两个连续的时钟, GetTimeUntil()可以使用
+     */
+    bool HasPrediction() const { return numClocks_ >= 2; }
+    /**
+     * @brief Start/Continue之后已经收到了时钟, 位置有效
+     */
+    bool IsRunning() const { return running_ && !waiting_; }
+    /**
+     * @brief Start/Continue之后的第一个时钟到达时返回一次true, 这个时钟的位置是GetPosition()
+     */
+    bool TakeStarted() {
+        bool started = started_;
+        started_ = false;
+        return started;
+    }
+    float GetBpm() const { return 60.0f * sampleRate_ / (kClocksPerBeat * period_); }
+    float GetSamplesPerClock() const { return period_; }
+    /**
+     * @brief 最后一个时钟的位置, 从song position开始数的时钟数
+     */
+    uint32_t GetPosition() const { return position_; }
+    /**
+     * @brief 第position个时钟预计的到达时间减去now, 可以是负的
+     */
+    float GetTimeUntil(uint32_t position, uint32_t now) const;
+    /**
+     * @brief now的位置(拍), 在两个时钟之间按预计的时间插值
+     */
+    double GetBeats(uint32_t now) const;
+
+private:
+    void Restart(uint32_t time);
+
+    uint32_t sampleRate_{};
+
+    // 估计
+    uint32_t numClocks_{};     // 这次锁定以来的时钟数
+    uint32_t lastTime_{};
+    uint32_t predTime_{};      // 预计的下一个时钟的时间, 整数和小数部分分开, 长时间运行不损失精度
+    float predFrac_{};
+    float period_{ 1.0f };
+    float minPeriod_{};
+    float maxPeriod_{};
+
+    // transport
+    bool running_{};
+    bool waiting_{};           // 等待Start/Continue之后的第一个时钟
+    bool started_{};
+    uint32_t position_{};
+    uint32_t nextPosition_{};
+};
+
+}
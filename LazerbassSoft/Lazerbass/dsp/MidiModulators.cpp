@@ -0,0 +1,80 @@
+#include "MidiModulators.hpp"
+#include <cmath>
+#include "ModulationBank.hpp"
+
+namespace dsp {
+
+/* "cc1" ~ "cc127", 编译期生成, 放在flash里 */
+struct ControllerName {
+    char str[6];
+};
+static constexpr auto kControllerNames = [] {
+    std::array<ControllerName, MidiModulators::kNumControllers> names{};
+    for (uint32_t i = 0; i < names.size(); ++i) {
+        uint32_t cc = i + 1;
+        char* p = names[i].str;
+        *p++ = 'c';
+        *p++ = 'c';
+        if (cc >= 100) {
+            *p++ = static_cast<char>('0' + cc / 100);
+        }
+        if (cc >= 10) {
+            *p++ = static_cast<char>('0' + cc / 10 % 10);
+        }
+        *p++ = static_cast<char>('0' + cc % 10);
+    }
+    return names;
+}();
+
+static constexpr const char* kSourceNames[] = { "velocity", "key", "aftertouch", "polyAT" };
+
+void MidiModulators::Init(uint32_t updateRate) {
+    SetUpdateRate(updateRate);
+}
+
+void MidiModulators::SetUpdateRate(uint32_t updateRate) {
+    smoothK_ = -std::expm1(-1.0f / (kSmoothTime * updateRate));
+}
+
+/* 只遍历编译后的调制矩阵读取的源, 没有使用时没有开销 */
+void MidiModulators::Tick(const ModulationBank& bank, uint32_t noteNumber) {
+    outputs_[kKeyTrack] = (noteNumber & 0x7f) / 127.0f;
+
+    for (const float* reg : bank.GetSources()) {
+        if (reg < outputs_ || reg >= outputs_ + kNumSources) {
+            continue;
+        }
+        const auto idx = static_cast<uint32_t>(reg - outputs_);
+        uint8_t raw = 0;
+        switch (idx) {
+        case kVelocity:
+        case kKeyTrack:
+            continue;
+        case kPolyPressure:
+            raw = polyPressures_[noteNumber & 0x7f].load(std::memory_order_relaxed);
+            break;
+        default:
+            raw = raws_[idx].load(std::memory_order_relaxed);
+            break;
+        }
+        outputs_[idx] += (raw / 127.0f - outputs_[idx]) * smoothK_;
+    }
+}
+
+void MidiModulators::NoteOn(float velocity) {
+    outputs_[kVelocity] = velocity;
+}
+
+ModulatorDesc MidiModulators::GetModulatorDesc(Source source) {
+    ModulatorDesc desc;
+    desc.name = source < kFirstController ? kSourceNames[source] : kControllerNames[source - kFirstController].str;
+    desc.outputReg = &outputs_[source];
+    return desc;
+}
+
+ModulatorDesc MidiModulators::GetControllerModulatorDesc(uint32_t controller) {
+    controller = controller < 1 ? 1 : controller > kNumControllers ? kNumControllers : controller;
+    return GetModulatorDesc(static_cast<Source>(kFirstController + controller - 1));
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "ModulatorDesc.hpp"
+
+namespace dsp {
+
+class ModulationBank;
+
+/**
+ * @brief 演奏控制的调制器: velocity, key tracking, channel/poly aftertouch, CC1~127
+ *        MIDI任务无锁写入原始值(0~127), 音频任务只在Tick里平滑调制矩阵读取的那些
+ *        velocity和key tracking在音符开始时跳变, 不平滑
+ */
+class MidiModulators {
+public:
+    static constexpr uint32_t kNumControllers = 127; // CC1~127
+    static constexpr uint32_t kNumNotes = 128;
+    static constexpr float kSmoothTime = 0.01f;      // 平滑的时间常数(秒)
+
+    enum Source : uint32_t {
+        kVelocity = 0,
+        kKeyTrack,
+        kChannelPressure,
+        kPolyPressure,
+        kFirstController,
+        kNumSources = kFirstController + kNumControllers
+    };
+
+    void Init(uint32_t updateRate);
+    void SetUpdateRate(uint32_t updateRate);
+
+    /**
+     * @brief 平滑调制矩阵使用的源, noteNumber是正在发声的音符, 在音频任务中调用
+     */
+    void Tick(const ModulationBank& bank, uint32_t noteNumber);
+
+    /**
+     * @brief 新音符, 在音频任务中调用
+     */
+    void NoteOn(float velocity);
+
+    /* MIDI任务中调用, 不需要持有音频锁 */
+    void ControlChange(uint32_t controller, uint32_t value) {
+        if (controller >= 1 && controller <= kNumControllers) {
+            raws_[kFirstController + controller - 1].store(static_cast<uint8_t>(value & 0x7f), std::memory_order_relaxed);
+        }
+    }
+    void ChannelPressure(uint32_t value) {
+        raws_[kChannelPressure].store(static_cast<uint8_t>(value & 0x7f), std::memory_order_relaxed);
+    }
+    void PolyPressure(uint32_t noteNumber, uint32_t value) {
+        polyPressures_[noteNumber & 0x7f].store(static_cast<uint8_t>(value & 0x7f), std::memory_order_relaxed);
+    }
+
+    float* GetOutputReg(Source source) { return &outputs_[source]; }
+    ModulatorDesc GetModulatorDesc(Source source);
+    /**
+     * @brief controller 1~127
+     */
+    ModulatorDesc GetControllerModulatorDesc(uint32_t controller);
+
+private:
+    std::array<std::atomic<uint8_t>, kNumSources> raws_{};
+    std::array<std::atomic<uint8_t>, kNumNotes> polyPressures_{};
+    float outputs_[kNumSources]{};
+    float smoothK_{ 1.0f };
+};
+
+}
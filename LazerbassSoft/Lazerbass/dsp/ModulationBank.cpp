@@ -1,59 +1,143 @@
 #include "ModulationBank.hpp"
+#include <algorithm>
 
 namespace dsp {
 
+/* 曲线的系数 x, x^2, x^3
+ * exp: x^2, log: 1 - (1 - x)^2, s-curve: 3x^2 - 2x^3
+ */
+static constexpr float kCurveCoefs[][3] = {
+    { 1.0f, 0.0f, 0.0f },
+    { 0.0f, 1.0f, 0.0f },
+    { 2.0f, -1.0f, 0.0f },
+    { 0.0f, 3.0f, -2.0f },
+};
+static_assert(std::size(kCurveCoefs) == static_cast<uint32_t>(ModulationCurve::kCount));
+
 void ModulationBank::Tick() {
-    for (uint32_t i = 0; i < numParamInfos_; ++i) {
-        auto& paramInfo = paramInfos_[i];
-        paramInfo.paramReg->modulationValue = 0.0f;
+    AcquireMatrix();
+    const auto& m = matrices_[readMatrix_];
+
+    /* 先在本地累加, 每个目标只写一次modulationValue */
+    float sources[kMaxNumModulations];
+    float values[kMaxNumModulations];
+    for (uint32_t i = 0; i < m.numSources; ++i) {
+        sources[i] = *m.sourceRegs[i];
     }
+    std::fill_n(values, m.numTargets, 0.0f);
 
-    for (uint32_t i = 0; i < numLinks_; ++i) {
-        auto& link = links_[i];
-        if (link.enable) {
-            float modulatorOutput = *link.sourceModulator.outputReg;
-            float modulationValue = 0.0f;
-            if (link.symmetric) {
-                modulationValue = (modulatorOutput - 0.5f) * link.amount;
-            }
-            else {
-                modulationValue = modulatorOutput * link.amount;
-            }
-            link.targetParamInfo->paramReg->modulationValue += modulationValue;
+    for (uint32_t i = 0; i < m.numLinks; ++i) {
+        float x = sources[m.linkSources[i]];
+        values[m.linkTargets[i]] += ((m.k3[i] * x + m.k2[i]) * x + m.k1[i]) * x + m.k0[i];
+    }
+
+    for (uint32_t i = 0; i < m.numTargets; ++i) {
+        m.targetRegs[i]->modulationValue = values[i];
+    }
+}
+
+bool ModulationBank::IsSourceUsed(const float* outputReg) const {
+    const auto& m = matrices_[readMatrix_];
+    return std::find(m.sourceRegs, m.sourceRegs + m.numSources, outputReg) != m.sourceRegs + m.numSources;
+}
+
+bool ModulationBank::IsTargetUsed(const FloatParamDesc* targetParam) const {
+    const auto& m = matrices_[readMatrix_];
+    for (uint32_t i = 0; i < m.numLinks; ++i) {
+        if (m.targetRegs[m.linkTargets[i]] == targetParam) {
+            return true;
         }
     }
+    return false;
 }
 
-ModulationLink* ModulationBank::AddNewLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam, bool& exited) {
-    if (numLinks_ >= kMaxNumModulations) {
-        exited = false;
-        return nullptr;
+/* 取走编辑任务最新的表, 不再被调制的参数清零 */
+void ModulationBank::SwapMatrix() {
+    readMatrix_ = readyMatrix_.exchange(readMatrix_, std::memory_order_acq_rel) & kIndexMask;
+    const auto& m = matrices_[readMatrix_];
+
+    for (uint32_t i = 0; i < numTouchedParams_; ++i) {
+        auto* param = touchedParams_[i];
+        if (std::find(m.targetRegs, m.targetRegs + m.numTargets, param) == m.targetRegs + m.numTargets) {
+            param->modulationValue = 0.0f;
+        }
     }
+    std::copy_n(m.targetRegs, m.numTargets, touchedParams_.data());
+    numTouchedParams_ = m.numTargets;
+}
+
+void ModulationBank::Compile() {
+    auto& m = matrices_[writeMatrix_];
+    m.numSources = 0;
+    m.numTargets = 0;
+    m.numLinks = 0;
 
+    for (uint32_t i = 0; i < numLinks_; ++i) {
+        const auto& link = *order_[i];
+
+        // 关闭的link的参数也要写0
+        auto* targetEnd = m.targetRegs + m.numTargets;
+        auto* target = std::find(m.targetRegs, targetEnd, link.targetParam);
+        if (target == targetEnd) {
+            m.targetRegs[m.numTargets++] = link.targetParam;
+        }
+        if (!link.enable) {
+            continue;
+        }
+
+        const float* sourceReg = link.sourceModulator.outputReg;
+        auto* sourceEnd = m.sourceRegs + m.numSources;
+        auto* source = std::find(m.sourceRegs, sourceEnd, sourceReg);
+        if (source == sourceEnd) {
+            m.sourceRegs[m.numSources++] = sourceReg;
+        }
+
+        const auto& coefs = kCurveCoefs[static_cast<uint32_t>(link.curve)];
+        const uint32_t n = m.numLinks++;
+        m.linkSources[n] = static_cast<uint8_t>(source - m.sourceRegs);
+        m.linkTargets[n] = static_cast<uint8_t>(target - m.targetRegs);
+        m.k0[n] = link.offset + (link.symmetric ? -0.5f * link.amount : 0.0f);
+        m.k1[n] = coefs[0] * link.amount;
+        m.k2[n] = coefs[1] * link.amount;
+        m.k3[n] = coefs[2] * link.amount;
+    }
+
+    writeMatrix_ = readyMatrix_.exchange(writeMatrix_ | kNewMatrix, std::memory_order_acq_rel) & kIndexMask;
+}
+
+ModulationLink* ModulationBank::AddNewLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam, bool& exited) {
     auto* linkExist = GetLink(sourceModulator, targetParam);
     if (linkExist != nullptr) {
         exited = true;
         return linkExist;
     }
 
-    auto& allocLink = links_[numLinks_++];
+    exited = false;
+    if (numLinks_ >= kMaxNumModulations) {
+        return nullptr;
+    }
+
+    uint32_t slot = static_cast<uint32_t>(std::find(slotUsed_.begin(), slotUsed_.end(), false) - slotUsed_.begin());
+    slotUsed_[slot] = true;
+    auto& allocLink = links_[slot];
     allocLink.sourceModulator = sourceModulator;
+    allocLink.targetParam = targetParam;
     allocLink.enable = true;
     allocLink.amount = 0.0f;
+    allocLink.offset = 0.0f;
     allocLink.symmetric = false;
+    allocLink.curve = ModulationCurve::kLinear;
+    order_[numLinks_++] = &allocLink;
 
-    auto* regInfo = TryAddNewParamRegInfo(targetParam);
-    allocLink.targetParamInfo = regInfo;
-    regInfo->numLinks++;
-
+    Compile();
     return &allocLink;
 }
 
 ModulationLink* ModulationBank::GetLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam) {
     for (uint32_t i = 0; i < numLinks_; ++i) {
-        if (links_[i].sourceModulator == sourceModulator 
-            && links_[i].targetParamInfo->paramReg == targetParam) {
-            return &links_[i];
+        if (order_[i]->sourceModulator == sourceModulator
+            && order_[i]->targetParam == targetParam) {
+            return order_[i];
         }
     }
     return nullptr;
@@ -64,12 +148,12 @@ uint32_t ModulationBank::GetLinkOfParam(FloatParamDesc* targetParam, std::span<M
     uint32_t write = 0;
 
     for (uint32_t i = 0; i < numLinks_; ++i) {
-        if (links_[i].targetParamInfo->paramReg == targetParam) {
+        if (order_[i]->targetParam == targetParam) {
             if (write >= maxWrite) {
                 break;
             }
             else {
-                links[write++] = &links_[i];
+                links[write++] = order_[i];
             }
         }
     }
@@ -82,12 +166,12 @@ uint32_t ModulationBank::GetLinkOfModulator(ModulatorDesc sourceModulator, std::
     uint32_t write = 0;
 
     for (uint32_t i = 0; i < numLinks_; ++i) {
-        if (links_[i].sourceModulator == sourceModulator) {
+        if (order_[i]->sourceModulator == sourceModulator) {
             if (write >= maxWrite) {
                 break;
             }
             else {
-                links[write++] = &links_[i];
+                links[write++] = order_[i];
             }
         }
     }
@@ -95,81 +179,69 @@ uint32_t ModulationBank::GetLinkOfModulator(ModulatorDesc sourceModulator, std::
     return write;
 }
 
-void ModulationBank::RemoveLink(ModulationLink* link) {
-    std::swap(*link, links_[numLinks_ - 1]);
+/* 其他link的地址不变, 只从顺序表中去掉 */
+void ModulationBank::RemoveLinkAt(uint32_t orderIdx) {
+    slotUsed_[order_[orderIdx] - links_.data()] = false;
+    std::copy(order_.begin() + orderIdx + 1, order_.begin() + numLinks_, order_.begin() + orderIdx);
     --numLinks_;
+}
 
-    --link->targetParamInfo->numLinks;
-    if (link->targetParamInfo->numLinks == 0) {
-        RemoveParamRegInfo(link->targetParamInfo);
+void ModulationBank::RemoveLink(ModulationLink* link) {
+    auto* end = order_.data() + numLinks_;
+    auto* it = std::find(order_.data(), end, link);
+    if (it != end) {
+        RemoveLinkAt(static_cast<uint32_t>(it - order_.data()));
+        Compile();
     }
 }
 
 void ModulationBank::RemoveLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam)
 {
-    for (uint32_t i = 0; i < numLinks_; ++i) {
-        if (links_[i].sourceModulator == sourceModulator 
-            && links_[i].targetParamInfo->paramReg == targetParam) {
-            RemoveLink(&links_[i]);
-            break;
-        }
+    auto* link = GetLink(sourceModulator, targetParam);
+    if (link != nullptr) {
+        RemoveLink(link);
     }
 }
 
 void ModulationBank::RemoveLinkOfParam(FloatParamDesc* targetParam) {
     for (uint32_t i = 0; i < numLinks_;) {
-        if (links_[i].targetParamInfo->paramReg == targetParam) {
-            RemoveLink(&links_[i]);
+        if (order_[i]->targetParam == targetParam) {
+            RemoveLinkAt(i);
         }
         else {
             ++i;
         }
     }
+    Compile();
 }
 
 void ModulationBank::RemoveLinkOfModulator(ModulatorDesc sourceModulator) {
     for (uint32_t i = 0; i < numLinks_;) {
-        if (links_[i].sourceModulator == sourceModulator) {
-            RemoveLink(&links_[i]);
+        if (order_[i]->sourceModulator == sourceModulator) {
+            RemoveLinkAt(i);
         }
         else {
             ++i;
         }
     }
+    Compile();
 }
 
 void ModulationBank::RemoveAllLinks() {
     numLinks_ = 0;
-    numParamInfos_ = 0;
+    slotUsed_.fill(false);
+    Compile();
 }
 
-ParamRegInfo *ModulationBank::TryAddNewParamRegInfo(FloatParamDesc* targetParam) {
-    for (uint32_t i = 0; i < numParamInfos_; ++i) {
-        if (paramInfos_[i].paramReg == targetParam) {
-            return &paramInfos_[i];
-        }
+void ModulationBank::LoadLinks(std::span<const ModulationLink> links) {
+    numLinks_ = static_cast<uint32_t>(std::min<size_t>(links.size(), kMaxNumModulations));
+    slotUsed_.fill(false);
+    for (uint32_t i = 0; i < numLinks_; ++i) {
+        links_[i] = links[i];
+        slotUsed_[i] = true;
+        order_[i] = &links_[i];
     }
-
-    auto& allocParamInfo = paramInfos_[numParamInfos_++];
-    allocParamInfo.paramReg = targetParam;
-    allocParamInfo.numLinks = 1;
-    
-    return &allocParamInfo;
-}
-
-void ModulationBank::RemoveParamRegInfo(ParamRegInfo* targetParam) {
-    std::swap(*targetParam, paramInfos_[numParamInfos_ - 1]);
-    --numParamInfos_;
+    Compile();
 }
 
-void ModulationBank::RemoveParamRegInfo(FloatParamDesc* targetParam) {
-    for (uint32_t i = 0; i < numParamInfos_;) {
-        if (paramInfos_[i].paramReg == targetParam) {
-            std::swap(paramInfos_[i], paramInfos_[numParamInfos_ - 1]);
-            --numParamInfos_;
-            break;
-        }
-    }
 }
-
-}
\ No newline at end of file
@@ -1,23 +1,31 @@
 #pragma once
 #include <cstdint>
 #include <array>
+#include <atomic>
 #include <span>
 #include "params.hpp"
 #include "ModulatorDesc.hpp"
 
 namespace dsp {
 
-struct ParamRegInfo {
-    FloatParamDesc* paramReg;
-    uint32_t numLinks;
+/* 调制器输出(0~1)到调制量的曲线, 都是三次多项式, 编译时和amount合并成系数 */
+enum class ModulationCurve : int32_t {
+    kLinear = 0,
+    kExp,
+    kLog,
+    kSCurve,
+    kCount
 };
+static constexpr const char* kModulationCurveNames[] = { "linear", "exp", "log", "s-curve" };
 
 struct ModulationLink {
     bool enable{};
     bool symmetric{};
-    float amount{}; // -1~1
+    float amount{}; // -1~1, 宏的目标是-2~2
+    float offset{}; // 调制量的起点, 宏的目标的范围是offset ~ offset + amount
+    ModulationCurve curve{};
     ModulatorDesc sourceModulator{};
-    ParamRegInfo* targetParamInfo{};
+    FloatParamDesc* targetParam{};
 
     auto GetModulationRange() const {
         struct ReturnStruct {
@@ -26,12 +34,12 @@ struct ModulationLink {
         } ret;
 
         if (symmetric) {
-            ret.min = -amount * 0.5f;
-            ret.max = amount * 0.5f;
+            ret.min = offset - amount * 0.5f;
+            ret.max = offset + amount * 0.5f;
         }
         else {
-            ret.min = 0.0f;
-            ret.max = amount;
+            ret.min = offset;
+            ret.max = offset + amount;
         }
 
         return ret;
@@ -39,29 +47,84 @@ struct ModulationLink {
 };
 using ModulationLinkHandle = ModulationLink*;
 
+/**
+ * @brief 调制矩阵
+ *        编辑(GUI任务)操作links_, link的地址在删除前不会改变, 修改link的字段后调用Compile()
+ *        Compile()把矩阵编译成SoA的调度表, 通过三缓冲无锁交给音频任务, Tick()只读编译后的表
+ */
 class ModulationBank {
 public:
-    static constexpr uint32_t kMaxNumModulations = 16;
+    static constexpr uint32_t kMaxNumModulations = 64;
 
     /**
-     * @brief 更新参数
+     * @brief 更新参数, 在音频任务中调用
      */
     void Tick();
 
+    /**
+     * @brief 取走编辑任务最新的调制矩阵, Tick()也会调用, 在音频任务中调用
+     */
+    void AcquireMatrix() {
+        if (readyMatrix_.load(std::memory_order_relaxed) & kNewMatrix) {
+            SwapMatrix();
+        }
+    }
+
+    /**
+     * @brief 当前的调制矩阵是否读取这个调制器的输出, 在音频任务中调用
+     */
+    bool IsSourceUsed(const float* outputReg) const;
+
+    /**
+     * @brief 当前的调制矩阵读取的所有调制器输出, 在音频任务中调用
+     */
+    std::span<const float* const> GetSources() const {
+        const auto& m = matrices_[readMatrix_];
+        return std::span(m.sourceRegs, m.numSources);
+    }
+
+    /**
+     * @brief 当前的调制矩阵是否调制这个参数, 在音频任务中调用
+     */
+    bool IsTargetUsed(const FloatParamDesc* targetParam) const;
+
+    /**
+     * @brief 用给定时刻的调制器输出单独计算一个参数的调制量, 在音频任务中调用
+     * @param sourceValue (const float* outputReg) -> float, 调制器在这个时刻的输出
+     */
+    template<class TFunc>
+    float Evaluate(const FloatParamDesc* targetParam, TFunc&& sourceValue) const {
+        const auto& m = matrices_[readMatrix_];
+        float value = 0.0f;
+        for (uint32_t i = 0; i < m.numLinks; ++i) {
+            if (m.targetRegs[m.linkTargets[i]] != targetParam) {
+                continue;
+            }
+            float x = sourceValue(m.sourceRegs[m.linkSources[i]]);
+            value += ((m.k3[i] * x + m.k2[i]) * x + m.k1[i]) * x + m.k0[i];
+        }
+        return value;
+    }
+
+    /**
+     * @brief 重新编译调制矩阵, 修改link的字段后调用, 只能在编辑的任务中调用
+     */
+    void Compile();
+
     /**
      * @brief 如果数量达到上限,返回nullptr, 如果已经存在,返回已经存在的并且设置exited为true
      * @param sourceModulator !nullptr
      * @param targetParam !nullptr
      * @param exitsed 返回
-     * @return 
+     * @return
      */
     ModulationLink* AddNewLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam, bool& exitsed);
 
     /**
      * @brief 如果没有找到,返回nullptr
-     * @param sourceModulator 
-     * @param targetParam 
-     * @return 
+     * @param sourceModulator
+     * @param targetParam
+     * @return
      */
     ModulationLink* GetLink(ModulatorDesc sourceModulator, FloatParamDesc* targetParam);
 
@@ -82,10 +145,10 @@ public:
     uint32_t GetLinkOfModulator(ModulatorDesc sourceModulator, std::span<ModulationLinkHandle> links);
 
     /**
-     * @brief 获取所有link
-     * @return 
+     * @brief 获取所有link, 按添加的顺序
+     * @return
      */
-    std::span<ModulationLink> GetLinks() { return std::span<ModulationLink>(links_.data(), numLinks_); }
+    std::span<const ModulationLinkHandle> GetLinks() const { return std::span(order_.data(), numLinks_); }
 
     /**
      * @brief 移除link
@@ -116,16 +179,53 @@ public:
      * @brief 移除所有link
      */
     void RemoveAllLinks();
-private:
-    ParamRegInfo* TryAddNewParamRegInfo(FloatParamDesc* targetParam);
-    void RemoveParamRegInfo(ParamRegInfo* targetParam);
-    void RemoveParamRegInfo(FloatParamDesc* targetParam);
 
-    std::array<ModulationLink, kMaxNumModulations> links_;
+    /**
+     * @brief 用links替换所有link, 只编译一次, 加载预设时使用
+     * @param links 超过kMaxNumModulations的部分丢弃
+     */
+    void LoadLinks(std::span<const ModulationLink> links);
+private:
+    /* 编译后的调制矩阵
+     * value = ((k3 * x + k2) * x + k1) * x + k0, x为调制器的输出
+     * 同一个调制器只读一次, 同一个参数只写一次
+     */
+    struct CompiledMatrix {
+        uint32_t numSources;
+        uint32_t numTargets;
+        uint32_t numLinks;
+        const float* sourceRegs[kMaxNumModulations];
+        FloatParamDesc* targetRegs[kMaxNumModulations];
+        uint8_t linkSources[kMaxNumModulations];
+        uint8_t linkTargets[kMaxNumModulations];
+        float k0[kMaxNumModulations];
+        float k1[kMaxNumModulations];
+        float k2[kMaxNumModulations];
+        float k3[kMaxNumModulations];
+    };
+
+    // 三缓冲, readyMatrix_的低位是缓冲的序号, kNewMatrix表示音频任务还没取走
+    static constexpr uint32_t kNewMatrix = 0x100;
+    static constexpr uint32_t kIndexMask = 0xff;
+
+    void RemoveLinkAt(uint32_t orderIdx);
+    void SwapMatrix();
+
+    // 编辑
+    std::array<ModulationLink, kMaxNumModulations> links_{};
+    std::array<bool, kMaxNumModulations> slotUsed_{};
+    std::array<ModulationLinkHandle, kMaxNumModulations> order_{};
     uint32_t numLinks_{};
 
-    std::array<ParamRegInfo, kMaxNumModulations> paramInfos_{};
-    uint32_t numParamInfos_{};
+    // 编译
+    std::array<CompiledMatrix, 3> matrices_{};
+    uint32_t writeMatrix_{ 0 };
+    std::atomic<uint32_t> readyMatrix_{ 1 };
+    uint32_t readMatrix_{ 2 };
+
+    // 音频任务写过的参数, 换表后不再调制的参数要清零
+    std::array<FloatParamDesc*, kMaxNumModulations> touchedParams_{};
+    uint32_t numTouchedParams_{};
 };
 
-}
\ No newline at end of file
+}
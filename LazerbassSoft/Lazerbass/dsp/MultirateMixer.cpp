@@ -0,0 +1,125 @@
+#include "MultirateMixer.hpp"
+#include <algorithm>
+#include <cmath>
+
+#include "mcu/Memory.hpp"
+
+namespace dsp {
+
+/* 相位从phase开始, 间隔step的正弦, 用复数旋转代替逐个sin */
+class SineSequence {
+public:
+    SineSequence(float phase, float step)
+        : sin_(std::sin(phase))
+        , cos_(std::cos(phase))
+        , stepSin_(std::sin(step))
+        , stepCos_(std::cos(step)) {}
+
+    float Next() {
+        float ret = sin_;
+        float s = sin_ * stepCos_ + cos_ * stepSin_;
+        cos_ = cos_ * stepCos_ - sin_ * stepSin_;
+        sin_ = s;
+        return ret;
+    }
+private:
+    float sin_;
+    float cos_;
+    float stepSin_;
+    float stepCos_;
+};
+
+void MultirateMixer::Reset() {
+    up4Left_.Reset();
+    up4Right_.Reset();
+    up2Left_.Reset();
+    up2Right_.Reset();
+    numPending_ = 0;
+    numFrames_ = 0;
+}
+
+void MultirateMixer::SetStereo(bool stereo) {
+    if (stereo && !stereo_) {
+        up4Right_ = up4Left_;
+        up2Right_ = up2Left_;
+        std::copy_n(pendingLeft_, numPending_, pendingRight_);
+    }
+    stereo_ = stereo;
+}
+
+uint32_t MultirateMixer::BeginBlock(uint32_t numSamples, bool stereo) {
+    SetStereo(stereo);
+
+    numFrames_ = numSamples > numPending_ ? (numSamples - numPending_ + kMaxRate - 1) / kMaxRate : 0;
+    std::fill_n(band4Left_, numFrames_, 0.0f);
+    std::fill_n(band2Left_, 2 * numFrames_, 0.0f);
+    if (stereo) {
+        std::fill_n(band4Right_, numFrames_, 0.0f);
+        std::fill_n(band2Right_, 2 * numFrames_, 0.0f);
+    }
+    return numFrames_;
+}
+
+_CODE_ITCM void MultirateMixer::EndBlock(float* left, float* right, uint32_t numSamples) {
+    const uint32_t numOut = numPending_ + kMaxRate * numFrames_;
+
+    auto process = [this, numSamples, numOut](HalfbandUpsampler<kFilterSize>& up4, HalfbandUpsampler<kFilterSize>& up2,
+                                              const float* band4, const float* band2, float* pending, float* out) {
+        float rate2[2 * kMaxFrames];
+        float rate1[kMaxBlockSize + kMaxRate];
+
+        up4.Process(band4, rate2, numFrames_);
+        for (uint32_t i = 0; i < 2 * numFrames_; ++i) {
+            rate2[i] += band2[i];
+        }
+        std::copy_n(pending, numPending_, rate1);
+        up2.Process(rate2, rate1 + numPending_, 2 * numFrames_);
+
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            out[i] += rate1[i];
+        }
+        std::copy(rate1 + numSamples, rate1 + numOut, pending);
+    };
+
+    process(up4Left_, up2Left_, band4Left_, band2Left_, pendingLeft_, left);
+    if (stereo_) {
+        process(up4Right_, up2Right_, band4Right_, band2Right_, pendingRight_, right);
+    }
+    numPending_ = numOut - numSamples;
+}
+
+/* 未输出的第k个采样在当前采样之后k个采样
+ * fs/2的第k新的输入在 numPending - 2 - 2k 个采样处, 插值后延迟kLatency2
+ * fs/4的第k新的输入在 numPending - 4 - 4k 个采样处, 插值后延迟kLatency4
+ * fs/4的分音经过第一级插值后也是fs/2的输入
+ */
+void MultirateMixer::AddSine(uint32_t rate, float theta, float w, float gainLeft, float gainRight) {
+    const float pending = static_cast<float>(numPending_);
+
+    SineSequence outSine(theta, w);
+    for (uint32_t i = 0; i < numPending_; ++i) {
+        float s = outSine.Next();
+        pendingLeft_[i] += s * gainLeft;
+        pendingRight_[i] += s * gainRight;
+    }
+
+    SineSequence sine2(theta + w * (pending - 2.0f + kLatency2), -2.0f * w);
+    float history2[2 * kFilterSize];
+    for (auto& s : history2) {
+        s = sine2.Next();
+    }
+    up2Left_.AddToHistory([&](uint32_t k) { return history2[k] * gainLeft; });
+    up2Right_.AddToHistory([&](uint32_t k) { return history2[k] * gainRight; });
+
+    if (rate == kMaxRate) {
+        SineSequence sine4(theta + w * (pending - 4.0f + kLatency4), -4.0f * w);
+        float history4[2 * kFilterSize];
+        for (auto& s : history4) {
+            s = sine4.Next();
+        }
+        up4Left_.AddToHistory([&](uint32_t k) { return history4[k] * gainLeft; });
+        up4Right_.AddToHistory([&](uint32_t k) { return history4[k] * gainRight; });
+    }
+}
+
+}
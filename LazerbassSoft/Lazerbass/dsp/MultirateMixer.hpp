@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <numbers>
+#include "dsp/effect/Oversampler.hpp"
+
+namespace dsp {
+
+/**
+ * @brief 低频分音降采样渲染, 再插值回原采样率
+ *        低于fs/16的分音在fs/4渲染, 低于fs/8的在fs/2渲染
+ *        fs/4的先插值到fs/2和fs/2的分音相加, 再插值到fs, 以fs/4的一帧(4个输出采样)为单位生成, 多出来的留到下一个块
+ *        插值有延迟, 低速率的MCF相位超前GetAdvance(rate)个输出采样, 插值后正好和全速率的分音对齐
+ */
+class MultirateMixer {
+public:
+    static constexpr uint32_t kFilterSize = 6; // 23 taps, 镜像-70dB
+    static constexpr uint32_t kMaxRate = 4;
+    static constexpr uint32_t kMaxBlockSize = 256;
+    static constexpr uint32_t kMaxFrames = kMaxBlockSize / kMaxRate;
+    // 以输出采样计的插值延迟
+    static constexpr uint32_t kLatency2 = 2 * kFilterSize - 1;
+    static constexpr uint32_t kLatency4 = 3 * kLatency2;
+    // 频段的最高频率(rad/sample), 插值的镜像在3/4奈奎斯特以上
+    static constexpr float kMaxFreq2 = std::numbers::pi_v<float> / 4.0f;
+    static constexpr float kMaxFreq4 = std::numbers::pi_v<float> / 8.0f;
+
+    void Reset();
+
+    /**
+     * @brief 从单声道切到立体声时右声道从左声道的状态开始
+     */
+    void SetStereo(bool stereo);
+
+    /**
+     * @brief 开始渲染一个块, 清空频段缓冲
+     * @return 这个块要生成的fs/4采样数, fs/2的是它的两倍
+     */
+    uint32_t BeginBlock(uint32_t numSamples, bool stereo);
+
+    /**
+     * @brief rate为2或者4, 低速率的分音累加到这里
+     */
+    float* GetBand(uint32_t rate, bool right) {
+        if (rate == kMaxRate) {
+            return right ? band4Right_ : band4Left_;
+        }
+        return right ? band2Right_ : band2Left_;
+    }
+
+    /**
+     * @brief 插值后加到left(和right)
+     */
+    void EndBlock(float* left, float* right, uint32_t numSamples);
+
+    /**
+     * @brief 低速率MCF的相位要比当前输出采样超前多少个采样
+     */
+    float GetAdvance(uint32_t rate) const {
+        return static_cast<float>(numPending_ + (rate == kMaxRate ? kLatency4 : kLatency2));
+    }
+
+    /**
+     * @brief 把一个正弦过去的采样加到插值的历史和未输出的采样里, 分音进入频段时增益为正, 离开时为负
+     *        之后的输出就像这个分音一直在(或者从来不在)这个频段里, 不需要淡入淡出
+     * @param theta 当前输出采样的相位
+     * @param w 频率(rad/sample)
+     */
+    void AddSine(uint32_t rate, float theta, float w, float gainLeft, float gainRight);
+private:
+    HalfbandUpsampler<kFilterSize> up4Left_;
+    HalfbandUpsampler<kFilterSize> up4Right_;
+    HalfbandUpsampler<kFilterSize> up2Left_;
+    HalfbandUpsampler<kFilterSize> up2Right_;
+    float band4Left_[kMaxFrames]{};
+    float band4Right_[kMaxFrames]{};
+    float band2Left_[2 * kMaxFrames]{};
+    float band2Right_[2 * kMaxFrames]{};
+    // 已经插值但还没输出的采样
+    float pendingLeft_[kMaxRate]{};
+    float pendingRight_[kMaxRate]{};
+    uint32_t numPending_{};
+    uint32_t numFrames_{};
+    bool stereo_{};
+};
+
+}
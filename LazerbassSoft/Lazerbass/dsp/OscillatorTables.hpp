@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <utility>
+#include "dsp/params.hpp"
+
+namespace dsp {
+
+static constexpr uint32_t kOscillatorTableSize = 1024; // Lazerbass::kMaxNumPartials
+static constexpr uint32_t kMinNumOscs = 2;
+
+inline constexpr auto kSawGainTable = []{
+    std::array<float, kOscillatorTableSize * 2> ret;
+    for (uint32_t i = 0; i < kOscillatorTableSize * 2; ++i) {
+        ret[i] = 1.0f / (1.0f + i);
+    }
+    return ret;
+}();
+
+/* 每种振荡器不随参数变化的倍频和增益, Tick时只需要复制再叠加beating/transport/pulseWidth */
+struct OscillatorTable {
+    std::array<float, kOscillatorTableSize> ratios;
+    std::array<float, kOscillatorTableSize> gains;
+};
+
+/* func(i) 返回第i个分音的 { 谐波序号, 增益表序号 } */
+template<class TFunc>
+consteval OscillatorTable MakeOscillatorTable(TFunc func) {
+    OscillatorTable ret{};
+    for (uint32_t i = 0; i < kOscillatorTableSize; ++i) {
+        auto [harmonic, gainIdx] = func(i);
+        ret.ratios[i] = harmonic + 1.0f;
+        ret.gains[i] = kSawGainTable[gainIdx];
+    }
+    return ret;
+}
+
+/* 第j个分音属于第j%numOsc个振荡器的第j/numOsc个谐波 */
+template<uint32_t kHarmonicStep>
+consteval auto MakeMultiOscillatorTables() {
+    std::array<OscillatorTable, SynthParams::kMaxNumOscs - kMinNumOscs + 1> ret{};
+    for (uint32_t numOsc = kMinNumOscs; numOsc <= static_cast<uint32_t>(SynthParams::kMaxNumOscs); ++numOsc) {
+        ret[numOsc - kMinNumOscs] = MakeOscillatorTable([numOsc](uint32_t j) {
+            uint32_t partialIdx = j / numOsc * kHarmonicStep;
+            return std::pair{ partialIdx, partialIdx };
+        });
+    }
+    return ret;
+}
+
+inline constexpr auto kFullSawTable = MakeOscillatorTable([](uint32_t i) {
+    return std::pair{ i, i };
+});
+inline constexpr auto kDualSawTable = MakeOscillatorTable([](uint32_t i) {
+    return std::pair{ i / 2, i / 2 };
+});
+inline constexpr auto kFullSquareTable = MakeOscillatorTable([](uint32_t i) {
+    return std::pair{ 2 * i, (i & 1) ? 2 * i + 1 : 2 * i };
+});
+inline constexpr auto kDualSquareTable = MakeOscillatorTable([](uint32_t i) {
+    return std::pair{ i & ~1u, i & ~1u };
+});
+inline constexpr auto kMultiSawTables = MakeMultiOscillatorTables<1>();
+inline constexpr auto kMultiSquareTables = MakeMultiOscillatorTables<2>();
+
+}
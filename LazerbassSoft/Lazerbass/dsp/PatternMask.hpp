@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <array>
+
+namespace dsp {
+
+/**
+ * @brief parttern的位图, 每parttern个分音里前一半为0(不处理), 后一半为1(处理)
+ *        只在parttern改变时重新计算, 各个分音处理单元共用
+ */
+template<uint32_t kNumPartials>
+class PatternMask {
+public:
+    static constexpr uint32_t kNumWords = (kNumPartials + 31) / 32;
+
+    void Update(uint32_t parttern) {
+        if (parttern == parttern_) {
+            return;
+        }
+        parttern_ = parttern;
+
+        bits_.fill(0);
+        uint32_t notApply = parttern / 2;
+        uint32_t posInParttern = 0;
+        for (uint32_t i = 0; i < kNumPartials; ++i) {
+            if (posInParttern >= notApply) {
+                bits_[i >> 5] |= 1u << (i & 31);
+            }
+            if (++posInParttern == parttern) {
+                posInParttern = 0;
+            }
+        }
+    }
+
+    bool Test(uint32_t idx) const {
+        return (bits_[idx >> 5] >> (idx & 31)) & 1u;
+    }
+private:
+    uint32_t parttern_{};
+    std::array<uint32_t, kNumWords> bits_{};
+};
+
+}
@@ -0,0 +1,240 @@
+#include "Sequencer.hpp"
+#include <algorithm>
+
+namespace dsp {
+
+void Sequencer::Init(uint32_t sampleRate) {
+    sampleRate_ = sampleRate;
+    running_ = false;
+    sounding_ = false;
+    numRestores_ = 0;
+    countdown_ = kNoEvent;
+    ResetPattern();
+}
+
+void Sequencer::ResetPattern() {
+    pattern_.length = kNumSteps;
+    for (auto& step : pattern_.steps) {
+        step.active = false;
+        step.note = kDefaultNote;
+        step.velocity = kDefaultVelocity;
+        step.gate = kDefaultGate;
+        step.mod = 0.0f;
+        step.numLocks = 0;
+    }
+}
+
+bool Sequencer::AddParamLock(uint32_t step, FloatParamDesc& param) {
+    auto& s = pattern_.steps[step % kNumSteps];
+    auto* end = s.locks + s.numLocks;
+    auto* it = std::find_if(s.locks, end, [&param](const ParamLock& lock) { return lock.param == &param; });
+    if (it != end) {
+        it->value = param.value;
+        return true;
+    }
+    if (s.numLocks >= kMaxLocks) {
+        return false;
+    }
+    s.locks[s.numLocks++] = { &param, param.value };
+    return true;
+}
+
+void Sequencer::ClearParamLocks(uint32_t step) {
+    pattern_.steps[step % kNumSteps].numLocks = 0;
+}
+
+uint32_t Sequencer::Update(uint32_t bpm, uint32_t now, std::span<Event, kMaxEvents> events) {
+    uint32_t numEvents = 0;
+
+    switch (command_.exchange(kCommandNone, std::memory_order_acquire)) {
+    case kCommandPlay:
+        if (!running_) {
+            StartPlayback(false, 0, now);
+        }
+        break;
+    case kCommandSyncStart:
+        StopPlayback(events, numEvents);
+        StartPlayback(true, syncPosition_, now);
+        break;
+    case kCommandStop:
+        StopPlayback(events, numEvents);
+        return numEvents;
+    default:
+        break;
+    }
+
+    if (!running_ || countdown_ > 0) {
+        return numEvents;
+    }
+
+    if (sounding_ && elapsed_ == gateLength_ && gateLength_ < stepLength_) {
+        events[numEvents++] = { Event::kNoteOff, soundingNote_, 0.0f };
+        sounding_ = false;
+    }
+    if (elapsed_ >= stepLength_) {
+        NextStep(bpm, now, events, numEvents);
+    }
+
+    const uint32_t next = sounding_ && gateLength_ > elapsed_ ? gateLength_ : stepLength_;
+    countdown_ = next - elapsed_;
+    return numEvents;
+}
+
+/* 从position(时钟数)之后的第一个整步开始, 内部时钟时position为0, 第0步在这个采样上触发 */
+void Sequencer::StartPlayback(bool synced, uint32_t position, uint32_t now) {
+    running_ = true;
+    synced_ = synced;
+    const uint32_t firstStep = (position + MidiClock::kClocksPerStep - 1) / MidiClock::kClocksPerStep;
+    songStep_ = firstStep - 1;
+    elapsed_ = 0;
+    stepLength_ = 0;
+    if (synced && position % MidiClock::kClocksPerStep != 0 && clock_.HasPrediction()) {
+        const float until = clock_.GetTimeUntil(firstStep * MidiClock::kClocksPerStep, now);
+        stepLength_ = static_cast<uint32_t>(std::max(until + 0.5f, 0.0f));
+    }
+    gateLength_ = stepLength_;
+    remainder_ = 0;
+    countdown_ = stepLength_;
+    playing_.store(true, std::memory_order_relaxed);
+}
+
+void Sequencer::StopPlayback(std::span<Event, kMaxEvents> events, uint32_t& numEvents) {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    countdown_ = kNoEvent;
+    if (sounding_) {
+        events[numEvents++] = { Event::kNoteOff, soundingNote_, 0.0f };
+        sounding_ = false;
+    }
+    RestoreLocks();
+    playing_.store(false, std::memory_order_relaxed);
+}
+
+/* 这一步结束在预计的第6(songStep+1)个时钟, 落后超过半步时跳过, 不连续触发 */
+uint32_t Sequencer::SyncedStepLength(uint32_t now) {
+    const float nominal = clock_.GetSamplesPerClock() * MidiClock::kClocksPerStep;
+    if (!clock_.HasPrediction()) {
+        return static_cast<uint32_t>(nominal + 0.5f);
+    }
+
+    float until = clock_.GetTimeUntil((songStep_ + 1) * MidiClock::kClocksPerStep, now);
+    while (until < 0.5f * nominal) {
+        ++songStep_;
+        until += nominal;
+    }
+    return static_cast<uint32_t>(until + 0.5f);
+}
+
+/* 新的一步: 恢复上一步的参数锁, 计算步长, 连奏的音符在新音符之后note off */
+void Sequencer::NextStep(uint32_t bpm, uint32_t now, std::span<Event, kMaxEvents> events, uint32_t& numEvents) {
+    ++songStep_;
+    if (synced_) {
+        stepLength_ = SyncedStepLength(now);
+    }
+    else {
+        // 60 / bpm / 4 秒
+        bpm = static_cast<uint32_t>(ClampUncheck(static_cast<int32_t>(bpm), kMinBpm, kMaxBpm));
+        const uint32_t total = sampleRate_ * (60 / kStepsPerBeat);
+        remainder_ += total % bpm;
+        stepLength_ = total / bpm + remainder_ / bpm;
+        remainder_ %= bpm;
+    }
+    elapsed_ = 0;
+
+    const uint32_t length = std::clamp<uint32_t>(pattern_.length, 1, kNumSteps);
+    step_ = songStep_ % length;
+    playingStep_.store(step_, std::memory_order_relaxed);
+
+    RestoreLocks();
+    const auto& s = pattern_.steps[step_];
+    output_ = s.mod;
+
+    if (!s.active) {
+        if (sounding_) {
+            events[numEvents++] = { Event::kNoteOff, soundingNote_, 0.0f };
+            sounding_ = false;
+        }
+        gateLength_ = stepLength_;
+        return;
+    }
+
+    ApplyLocks(s);
+    const bool tied = sounding_;
+    const uint8_t tiedNote = soundingNote_;
+    if (!(tied && tiedNote == s.note)) {
+        events[numEvents++] = { Event::kNoteOn, s.note, s.velocity / 127.0f };
+        if (tied) {
+            events[numEvents++] = { Event::kNoteOff, tiedNote, 0.0f };
+        }
+    }
+    sounding_ = true;
+    soundingNote_ = s.note;
+
+    if (s.gate >= 100) {
+        gateLength_ = stepLength_;
+    }
+    else {
+        gateLength_ = std::clamp<uint32_t>(stepLength_ * s.gate / 100, 1, stepLength_ - 1);
+    }
+}
+
+void Sequencer::ApplyLocks(const Step& step) {
+    const uint32_t numLocks = std::min(step.numLocks, kMaxLocks);
+    for (uint32_t i = 0; i < numLocks; ++i) {
+        auto* param = step.locks[i].param;
+        restores_[i] = { param, param->value };
+        param->value = step.locks[i].value;
+    }
+    numRestores_ = numLocks;
+}
+
+/* 倒序恢复, 同一个参数锁了两次时恢复到最早的值 */
+void Sequencer::RestoreLocks() {
+    while (numRestores_ > 0) {
+        --numRestores_;
+        restores_[numRestores_].param->value = restores_[numRestores_].value;
+    }
+}
+
+/* 顺序查找, 同一个参数锁了两次时第一个是最早的值 */
+int32_t Sequencer::GetBaseValue(const FloatParamDesc& param) const {
+    for (uint32_t i = 0; i < numRestores_; ++i) {
+        if (restores_[i].param == &param) {
+            return restores_[i].value;
+        }
+    }
+    return param.value;
+}
+
+void Sequencer::RecordNote(uint32_t noteNumber, float velocity) {
+    if (!IsRecording()) {
+        return;
+    }
+
+    const uint32_t length = std::clamp<uint32_t>(pattern_.length, 1, kNumSteps);
+    uint32_t target = 0;
+    if (running_) {
+        // 超过半步时算作下一步
+        target = elapsed_ * 2 < stepLength_ ? step_ : (step_ + 1) % length;
+    }
+    else {
+        target = GetRecordStep() % length;
+        SetRecordStep((target + 1) % length);
+    }
+
+    auto& s = pattern_.steps[target];
+    s.note = static_cast<uint8_t>(noteNumber & 0x7f);
+    s.velocity = static_cast<uint8_t>(std::clamp(velocity * 127.0f, 1.0f, 127.0f));
+    s.active = true;
+}
+
+ModulatorDesc Sequencer::GetModulatorDesc() {
+    ModulatorDesc desc;
+    desc.name = "mod seq";
+    desc.outputReg = &output_;
+    return desc;
+}
+
+}
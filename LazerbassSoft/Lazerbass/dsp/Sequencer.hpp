@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include "ParamDesc.hpp"
+#include "ModulatorDesc.hpp"
+#include "MidiClock.hpp"
+
+namespace dsp {
+
+/**
+ * @brief 16步的步进音序器, 在音频任务中按采样计时
+ *        一步是16分音符, 长度 = sampleRate * 15 / bpm, 余数逐步累加, 长时间播放不漂移
+ *        跟随MIDI时钟时每一步在预计的第6n个时钟的时间结束, 相位锁定在时钟上, 不累积误差
+ *        Lazerbass在事件所在的采样切开渲染块, 音符从那个采样开始
+ *        GUI任务直接编辑Pattern的字段, 增删参数锁要持有音频锁; 播放/停止通过原子的命令交给音频任务
+ */
+class Sequencer {
+public:
+    static constexpr uint32_t kNumSteps = 16;
+    static constexpr uint32_t kMaxLocks = 4;        // 每一步的参数锁
+    static constexpr uint32_t kMaxEvents = 2;       // 同一个采样上最多的事件: 新音符和连奏的上一个音符的note off
+    static constexpr uint32_t kStepsPerBeat = 4;
+    static constexpr int32_t kMinBpm = 30;
+    static constexpr int32_t kMaxBpm = 300;
+    static constexpr uint8_t kDefaultNote = 36;
+    static constexpr uint8_t kDefaultVelocity = 100;
+    static constexpr uint8_t kDefaultGate = 50;
+    static constexpr uint32_t kNoEvent = UINT32_MAX;
+
+    struct ParamLock {
+        FloatParamDesc* param;
+        int32_t value;
+    };
+
+    struct Step {
+        bool active;
+        uint8_t note;
+        uint8_t velocity;   // 1~127
+        uint8_t gate;       // 占一步的百分比, 100时和下一步连奏, 同一个音符时延长
+        float mod;          // MOD sequence, 0~1
+        uint32_t numLocks;
+        ParamLock locks[kMaxLocks];
+    };
+
+    struct Pattern {
+        uint32_t length;
+        Step steps[kNumSteps];
+    };
+
+    struct Event {
+        enum Type : uint8_t {
+            kNoteOff = 0,
+            kNoteOn
+        } type;
+        uint8_t note;
+        float velocity;
+    };
+
+    Sequencer(const MidiClock& clock) : clock_(clock) {}
+
+    void Init(uint32_t sampleRate);
+    void ResetPattern();
+
+    /* GUI任务中调用, 不需要持有音频锁 */
+    void Play() { command_.store(kCommandPlay, std::memory_order_release); }
+    void Stop() { command_.store(kCommandStop, std::memory_order_release); }
+    void SetRecord(bool record) { recording_.store(record, std::memory_order_relaxed); }
+    bool IsRecording() const { return recording_.load(std::memory_order_relaxed); }
+    bool IsPlaying() const { return playing_.load(std::memory_order_relaxed); }
+    uint32_t GetPlayingStep() const { return playingStep_.load(std::memory_order_relaxed); }
+    // 停止时录音写入的步
+    void SetRecordStep(uint32_t step) { recordStep_.store(step % kNumSteps, std::memory_order_relaxed); }
+    uint32_t GetRecordStep() const { return recordStep_.load(std::memory_order_relaxed); }
+    Pattern& GetPattern() { return pattern_; }
+
+    /**
+     * @brief 把参数现在的值锁到这一步, 已经锁了时更新值, 需要持有音频锁
+     * @return 锁的数量达到上限时返回false
+     */
+    bool AddParamLock(uint32_t step, FloatParamDesc& param);
+    void ClearParamLocks(uint32_t step);
+    /**
+     * @brief 参数没有被正在播放的步锁住时的值, 需要持有音频锁
+     */
+    int32_t GetBaseValue(const FloatParamDesc& param) const;
+    /**
+     * @brief 丢掉等待恢复的锁, 不写回参数, 整体替换参数(加载预设)之后调用, 需要持有音频锁
+     */
+    void DropLocks() { numRestores_ = 0; }
+
+    /* 音频任务中调用 */
+    /**
+     * @brief MIDI Start/Continue之后的第一个时钟, position是这个时钟的位置, 从下一个整步开始
+     */
+    void SyncStart(uint32_t position) {
+        syncPosition_ = position;
+        command_.store(kCommandSyncStart, std::memory_order_relaxed);
+    }
+    bool IsDue() const { return countdown_ == 0 || command_.load(std::memory_order_relaxed) != kCommandNone; }
+    /**
+     * @brief 执行命令和到时的事件, 返回写入events的数量
+     * @param bpm 内部时钟的速度
+     * @param now 现在的采样时间, 和MIDI时钟的时间相同
+     */
+    uint32_t Update(uint32_t bpm, uint32_t now, std::span<Event, kMaxEvents> events);
+    /**
+     * @brief 到下一个事件的采样数, 停止时为kNoEvent
+     */
+    uint32_t GetSamplesToNextEvent() const { return countdown_; }
+    void Advance(uint32_t numSamples) {
+        if (running_) {
+            elapsed_ += numSamples;
+            countdown_ -= numSamples;
+        }
+    }
+    /**
+     * @brief 外部演奏的音符, 录音时播放中量化到最近的步, 停止时写到recordStep并前进一步
+     */
+    void RecordNote(uint32_t noteNumber, float velocity);
+
+    ModulatorDesc GetModulatorDesc();
+
+private:
+    enum : uint32_t {
+        kCommandNone = 0,
+        kCommandPlay,
+        kCommandSyncStart,
+        kCommandStop
+    };
+
+    void StartPlayback(bool synced, uint32_t position, uint32_t now);
+    void StopPlayback(std::span<Event, kMaxEvents> events, uint32_t& numEvents);
+    void NextStep(uint32_t bpm, uint32_t now, std::span<Event, kMaxEvents> events, uint32_t& numEvents);
+    uint32_t SyncedStepLength(uint32_t now);
+    void ApplyLocks(const Step& step);
+    void RestoreLocks();
+
+    Pattern pattern_{};
+    const MidiClock& clock_;
+    uint32_t sampleRate_{};
+
+    // 播放, 只在音频任务中访问
+    bool running_{};
+    bool synced_{};             // MIDI Start开始的, 跟随MIDI时钟
+    uint32_t songStep_{};       // 从开始数的步, 跟随时钟时是song position
+    uint32_t syncPosition_{};
+    uint32_t step_{};
+    uint32_t elapsed_{};        // 这一步开始后的采样
+    uint32_t stepLength_{};
+    uint32_t gateLength_{};     // note off的位置, 等于stepLength_时连奏到下一步
+    uint32_t remainder_{};      // 步长的余数, 单位1/bpm采样
+    uint32_t countdown_{ kNoEvent };
+    bool sounding_{};
+    uint8_t soundingNote_{};
+    ParamLock restores_[kMaxLocks]{};
+    uint32_t numRestores_{};
+    float output_{};            // MOD sequence
+
+    // GUI读写
+    std::atomic<uint32_t> command_{ kCommandNone };
+    std::atomic<bool> playing_{};
+    std::atomic<bool> recording_{};
+    std::atomic<uint32_t> playingStep_{};
+    std::atomic<uint32_t> recordStep_{};
+};
+
+}
@@ -0,0 +1,64 @@
+#include "Chorus.hpp"
+
+namespace dsp {
+
+/* 0~1的三角波 */
+static inline float Triangle(float phase) {
+    float t = 2.0f * phase;
+    return t < 1.0f ? t : 2.0f - t;
+}
+
+void Chorus::Init(uint32_t sampleRate, EffectArena& arena) {
+    sampleRate_ = static_cast<float>(sampleRate);
+    left_.Init(arena.Alloc(GetDelayLineSize(sampleRate)));
+    right_.Init(arena.Alloc(GetDelayLineSize(sampleRate)));
+    Reset();
+}
+
+void Chorus::Reset() {
+    phase_ = 0.0f;
+    left_.Clear();
+    right_.Clear();
+}
+
+void Chorus::Process(float* left, float* right, uint32_t numSamples) {
+    if (left_.GetSize() == 0 || right_.GetSize() == 0) {
+        return;
+    }
+
+    float rate = params_.chorus.rate.GetWithModulation();
+    float depth = params_.chorus.depth.GetWithModulation();
+    float mix = params_.chorus.mix.GetWithModulation();
+
+    const float phaseInc = rate / sampleRate_;
+    const float baseDelay = kBaseDelayMs * sampleRate_ / 1000.0f;
+    const float depthSamples = depth * kMaxDepthMs * sampleRate_ / 1000.0f;
+    const float dry = 1.0f - mix * 0.5f;
+    const float wet = mix * 0.5f;
+
+    /* 左右声道的lfo相差90度 */
+    float phase = phase_;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        float phaseRight = phase + 0.25f;
+        if (phaseRight >= 1.0f) {
+            phaseRight -= 1.0f;
+        }
+        float delayLeft = baseDelay + depthSamples * Triangle(phase);
+        float delayRight = baseDelay + depthSamples * Triangle(phaseRight);
+
+        float l = left[i];
+        float r = right[i];
+        left[i] = l * dry + left_.ReadFrac(delayLeft) * wet;
+        right[i] = r * dry + right_.ReadFrac(delayRight) * wet;
+        left_.Push(l);
+        right_.Push(r);
+
+        phase += phaseInc;
+        if (phase >= 1.0f) {
+            phase -= 1.0f;
+        }
+    }
+    phase_ = phase;
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include "dsp/params.hpp"
+#include "EffectArena.hpp"
+
+namespace dsp {
+
+class Chorus {
+public:
+    static constexpr float kBaseDelayMs = 12.0f;
+    static constexpr float kMaxDepthMs = 6.0f;
+
+    static constexpr uint32_t GetDelayLineSize(uint32_t sampleRate) {
+        return static_cast<uint32_t>((kBaseDelayMs + kMaxDepthMs) * sampleRate / 1000) + 2;
+    }
+    static constexpr uint32_t GetMemorySize(uint32_t sampleRate) {
+        return GetDelayLineSize(sampleRate) * 2;
+    }
+
+    Chorus(SynthParams& params)
+        : params_(params) {}
+
+    void Init(uint32_t sampleRate, EffectArena& arena);
+    void Process(float* left, float* right, uint32_t numSamples);
+    void Reset();
+private:
+    SynthParams& params_;
+    float sampleRate_{};
+    float phase_{};
+    DelayLine left_;
+    DelayLine right_;
+};
+
+}
@@ -0,0 +1,51 @@
+#include "Delay.hpp"
+#include <cmath>
+
+namespace dsp {
+
+static constexpr float kTimeSmoothMs = 20.0f;
+
+void Delay::Init(uint32_t sampleRate, EffectArena& arena) {
+    sampleRate_ = static_cast<float>(sampleRate);
+    smoothCoef_ = 1.0f - std::exp(-1000.0f / (kTimeSmoothMs * sampleRate_));
+    left_.Init(arena.Alloc(GetDelayLineSize(sampleRate)));
+    right_.Init(arena.Alloc(GetDelayLineSize(sampleRate)));
+    Reset();
+}
+
+void Delay::Reset() {
+    delaySamples_ = params_.delay.time.Get() * sampleRate_ / 1000.0f;
+    left_.Clear();
+    right_.Clear();
+}
+
+void Delay::Process(float* left, float* right, uint32_t numSamples) {
+    if (left_.GetSize() == 0 || right_.GetSize() == 0) {
+        return;
+    }
+
+    float time = params_.delay.time.GetWithModulation();
+    float feedback = params_.delay.feedback.GetWithModulation();
+    float mix = params_.delay.mix.GetWithModulation();
+
+    /* 延迟时间平滑变化, 避免调制时的爆音 */
+    const float targetDelay = ClampUncheck(time * sampleRate_ / 1000.0f, 1.0f, left_.GetSize() - 2.0f);
+    const float dry = 1.0f - mix;
+
+    float delaySamples = delaySamples_;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        delaySamples += (targetDelay - delaySamples) * smoothCoef_;
+
+        float l = left[i];
+        float r = right[i];
+        float delayedLeft = left_.ReadFrac(delaySamples);
+        float delayedRight = right_.ReadFrac(delaySamples);
+        left_.Push(l + delayedLeft * feedback);
+        right_.Push(r + delayedRight * feedback);
+        left[i] = l * dry + delayedLeft * mix;
+        right[i] = r * dry + delayedRight * mix;
+    }
+    delaySamples_ = delaySamples;
+}
+
+}
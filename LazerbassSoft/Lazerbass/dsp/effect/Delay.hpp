@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include "dsp/params.hpp"
+#include "EffectArena.hpp"
+
+namespace dsp {
+
+class Delay {
+public:
+    static constexpr float kMaxTimeMs = 400.0f;
+
+    static constexpr uint32_t GetDelayLineSize(uint32_t sampleRate) {
+        return static_cast<uint32_t>(kMaxTimeMs * sampleRate / 1000) + 2;
+    }
+    static constexpr uint32_t GetMemorySize(uint32_t sampleRate) {
+        return GetDelayLineSize(sampleRate) * 2;
+    }
+
+    Delay(SynthParams& params)
+        : params_(params) {}
+
+    void Init(uint32_t sampleRate, EffectArena& arena);
+    void Process(float* left, float* right, uint32_t numSamples);
+    void Reset();
+private:
+    SynthParams& params_;
+    float sampleRate_{};
+    float delaySamples_{};
+    float smoothCoef_{};
+    DelayLine left_;
+    DelayLine right_;
+};
+
+}
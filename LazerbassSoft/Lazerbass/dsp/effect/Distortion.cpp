@@ -0,0 +1,99 @@
+#include "Distortion.hpp"
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+
+namespace dsp {
+
+static constexpr float kFullScale = 8.0f;
+static constexpr float kInvFullScale = 1.0f / kFullScale;
+static constexpr float kMaxDriveDb = 36.0f;
+static constexpr float kMinToneHz = 500.0f;
+static constexpr float kMaxToneHz = 16000.0f;
+
+/* tanh的有理近似, |x| > 3时为1 */
+static inline float SoftClip(float x) {
+    x = ClampUncheck(x, -3.0f, 3.0f);
+    float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+void Distortion::Init(uint32_t sampleRate) {
+    sampleRate_ = static_cast<float>(sampleRate);
+    dryLeft_.Init(dryLeftBuffer_);
+    dryRight_.Init(dryRightBuffer_);
+    Reset();
+}
+
+void Distortion::Reset() {
+    toneLeft_ = 0.0f;
+    toneRight_ = 0.0f;
+    oversampleLeft_.Reset();
+    oversampleRight_.Reset();
+    dryLeft_.Clear();
+    dryRight_.Clear();
+}
+
+void Distortion::Process(float* left, float* right, uint32_t numSamples) {
+    static constexpr uint32_t kFactors[] = { 1, 2, 4 };
+    uint32_t factor = kFactors[static_cast<uint32_t>(params_.distortion.oversample.Get())];
+    if (factor != factor_) {
+        // 延迟改变了, 清掉滤波器里旧的状态
+        factor_ = factor;
+        Reset();
+    }
+    const uint32_t latency = Oversampler::GetLatency(factor);
+
+    float drive = params_.distortion.drive.GetWithModulation();
+    float tone = params_.distortion.tone.GetWithModulation();
+    float mix = params_.distortion.mix.GetWithModulation();
+
+    float driveGain = std::exp2(drive * kMaxDriveDb / 6.0206f) * kInvFullScale;
+    float toneHz = kMinToneHz * std::exp2(tone * std::log2(kMaxToneHz / kMinToneHz));
+    float toneCoef = 1.0f - std::exp(-2.0f * std::numbers::pi_v<float> * toneHz / sampleRate_);
+    float wet = mix * kFullScale;
+    float dry = 1.0f - mix;
+
+    auto shaper = [driveGain](float* x, uint32_t n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            x[i] = SoftClip(x[i] * driveGain);
+        }
+    };
+
+    float toneLeft = toneLeft_;
+    float toneRight = toneRight_;
+    for (uint32_t begin = 0; begin < numSamples; begin += Oversampler::kSubBlock) {
+        uint32_t n = std::min(Oversampler::kSubBlock, numSamples - begin);
+        float* l = left + begin;
+        float* r = right + begin;
+
+        float dryLefts[Oversampler::kSubBlock];
+        float dryRights[Oversampler::kSubBlock];
+        if (latency == 0) {
+            std::copy_n(l, n, dryLefts);
+            std::copy_n(r, n, dryRights);
+        }
+        else {
+            for (uint32_t i = 0; i < n; ++i) {
+                dryLefts[i] = dryLeft_.Read(latency);
+                dryLeft_.Push(l[i]);
+                dryRights[i] = dryRight_.Read(latency);
+                dryRight_.Push(r[i]);
+            }
+        }
+
+        oversampleLeft_.Process(l, n, factor, shaper);
+        oversampleRight_.Process(r, n, factor, shaper);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            toneLeft += (l[i] - toneLeft) * toneCoef;
+            toneRight += (r[i] - toneRight) * toneCoef;
+            l[i] = dryLefts[i] * dry + toneLeft * wet;
+            r[i] = dryRights[i] * dry + toneRight * wet;
+        }
+    }
+    toneLeft_ = toneLeft;
+    toneRight_ = toneRight;
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include "dsp/params.hpp"
+#include "EffectArena.hpp"
+#include "Oversampler.hpp"
+
+namespace dsp {
+
+class Distortion {
+public:
+    Distortion(SynthParams& params)
+        : params_(params) {}
+
+    void Init(uint32_t sampleRate);
+    void Process(float* left, float* right, uint32_t numSamples);
+    void Reset();
+private:
+    static constexpr uint32_t kMaxLatency = Oversampler::GetLatency(4);
+
+    SynthParams& params_;
+    float sampleRate_{};
+    float toneLeft_{};
+    float toneRight_{};
+
+    // 过采样的波形整形, dry信号延迟同样的采样数再混合
+    uint32_t factor_{ 1 };
+    Oversampler oversampleLeft_;
+    Oversampler oversampleRight_;
+    std::array<float, kMaxLatency + 1> dryLeftBuffer_{};
+    std::array<float, kMaxLatency + 1> dryRightBuffer_{};
+    DelayLine dryLeft_;
+    DelayLine dryRight_;
+};
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <algorithm>
+
+namespace dsp {
+
+/**
+ * @brief 效果器延迟线的固定内存池, 只在Init时顺序分配, 不使用堆
+ */
+class EffectArena {
+public:
+    EffectArena(float* memory, uint32_t size)
+        : memory_(memory), size_(size) {}
+
+    /**
+     * @brief 内存不足时返回空的span, 容量由EffectChain静态检查
+     */
+    std::span<float> Alloc(uint32_t numFloats) {
+        if (used_ + numFloats > size_) {
+            return {};
+        }
+        std::span<float> ret{ memory_ + used_, numFloats };
+        std::fill(ret.begin(), ret.end(), 0.0f);
+        used_ += numFloats;
+        return ret;
+    }
+
+    void Reset() { used_ = 0; }
+    uint32_t GetUsed() const { return used_; }
+    uint32_t GetSize() const { return size_; }
+private:
+    float* memory_;
+    uint32_t size_;
+    uint32_t used_{};
+};
+
+/**
+ * @brief 环形延迟线, 先Read再Push
+ */
+class DelayLine {
+public:
+    void Init(std::span<float> buffer) {
+        buffer_ = buffer;
+        writePos_ = 0;
+    }
+
+    void Clear() {
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+    }
+
+    uint32_t GetSize() const { return static_cast<uint32_t>(buffer_.size()); }
+
+    void Push(float x) {
+        buffer_[writePos_] = x;
+        if (++writePos_ == buffer_.size()) {
+            writePos_ = 0;
+        }
+    }
+
+    /* delay: 1 ~ size */
+    float Read(uint32_t delay) const {
+        uint32_t pos = writePos_ + GetSize() - delay;
+        if (pos >= GetSize()) {
+            pos -= GetSize();
+        }
+        return buffer_[pos];
+    }
+
+    /* 线性插值, delay: 1 ~ size - 1 */
+    float ReadFrac(float delay) const {
+        auto delayInt = static_cast<uint32_t>(delay);
+        float frac = delay - delayInt;
+        float a = Read(delayInt);
+        float b = Read(delayInt + 1);
+        return a + (b - a) * frac;
+    }
+private:
+    std::span<float> buffer_;
+    uint32_t writePos_{};
+};
+
+}
@@ -0,0 +1,120 @@
+#include "EffectChain.hpp"
+#include <algorithm>
+
+#include "bsp/Time.hpp"
+
+namespace dsp {
+
+EffectChain::EffectChain(SynthParams& params, std::span<float, kArenaSize> arenaMemory)
+    : params_(params)
+    , arena_(arenaMemory.data(), kArenaSize)
+    , distortion_(params)
+    , chorus_(params)
+    , delay_(params)
+    , reverb_(params) {
+}
+
+void EffectChain::Init(uint32_t sampleRate) {
+    arena_.Reset();
+    distortion_.Init(sampleRate);
+    chorus_.Init(sampleRate, arena_);
+    delay_.Init(sampleRate, arena_);
+    reverb_.Init(sampleRate, arena_);
+    std::fill_n(enabled_, kNumEffects, false);
+    ClearCycles();
+}
+
+void EffectChain::ClearCycles() {
+    std::fill_n(cycles_, kNumEffects, 0u);
+}
+
+bool EffectChain::IsEnabled(EffectId id) const {
+    switch (id) {
+    case kDistortion:
+        return params_.distortion.enable.Get();
+    case kChorus:
+        return params_.chorus.enable.Get();
+    case kDelay:
+        return params_.delay.enable.Get();
+    case kReverb:
+        return params_.reverb.enable.Get();
+    default:
+        return false;
+    }
+}
+
+bool EffectChain::Process(float* left, float* right, uint32_t numSamples, bool stereo) {
+    bool anyEnabled = false;
+    for (uint32_t i = 0; i < kNumEffects; ++i) {
+        auto id = static_cast<EffectId>(i);
+        bool enable = IsEnabled(id);
+        if (enable && !enabled_[i]) {
+            // 重新打开时清掉上一次留下的尾音
+            switch (id) {
+            case kDistortion:
+                distortion_.Reset();
+                break;
+            case kChorus:
+                chorus_.Reset();
+                break;
+            case kDelay:
+                delay_.Reset();
+                break;
+            case kReverb:
+                reverb_.Reset();
+                break;
+            default:
+                break;
+            }
+        }
+        enabled_[i] = enable;
+        anyEnabled = anyEnabled || enable;
+    }
+
+    if (anyEnabled && !stereo) {
+        std::copy_n(left, numSamples, right);
+        stereo = true;
+    }
+
+    for (uint32_t i = 0; i < kNumEffects; ++i) {
+        if (!enabled_[i]) {
+            continue;
+        }
+
+        uint32_t cycleBegin = bsp::Time::GetCycles();
+        switch (static_cast<EffectId>(i)) {
+        case kDistortion:
+            distortion_.Process(left, right, numSamples);
+            break;
+        case kChorus:
+            chorus_.Process(left, right, numSamples);
+            break;
+        case kDelay:
+            delay_.Process(left, right, numSamples);
+            break;
+        case kReverb:
+            reverb_.Process(left, right, numSamples);
+            break;
+        default:
+            break;
+        }
+        cycles_[i] += bsp::Time::GetCycles() - cycleBegin;
+    }
+
+    // master
+    float volume = params_.master.volume.GetWithModulation();
+    if (volume != 1.0f) {
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            left[i] *= volume;
+        }
+        if (stereo) {
+            for (uint32_t i = 0; i < numSamples; ++i) {
+                right[i] *= volume;
+            }
+        }
+    }
+
+    return stereo;
+}
+
+}
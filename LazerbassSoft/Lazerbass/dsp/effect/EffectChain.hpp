@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "dsp/params.hpp"
+#include "EffectArena.hpp"
+#include "Distortion.hpp"
+#include "Chorus.hpp"
+#include "Delay.hpp"
+#include "Reverb.hpp"
+
+namespace dsp {
+
+/**
+ * @brief 合成之后的效果器链 distortion -> chorus -> delay -> reverb -> master
+ *        延迟线从持有者给的固定内存池分配
+ */
+class EffectChain {
+public:
+    enum EffectId : uint32_t {
+        kDistortion = 0,
+        kChorus,
+        kDelay,
+        kReverb,
+        kNumEffects
+    };
+    static constexpr const char* kEffectNames[kNumEffects] = {
+        "dist",
+        "chorus",
+        "delay",
+        "reverb"
+    };
+
+    static constexpr uint32_t kMaxSampleRate = 48000;
+    static constexpr uint32_t kArenaSize = Chorus::GetMemorySize(kMaxSampleRate)
+                                         + Delay::GetMemorySize(kMaxSampleRate)
+                                         + Reverb::GetMemorySize(kMaxSampleRate);
+    static_assert(kArenaSize * sizeof(float) <= 288 * 1024, "effects do not fit in SRAM D2");
+
+    /**
+     * @param arenaMemory 延迟线的内存池, 由持有者放在SRAM D2
+     */
+    EffectChain(SynthParams& params, std::span<float, kArenaSize> arenaMemory);
+
+    void Init(uint32_t sampleRate);
+
+    /**
+     * @brief 在混音缓冲区上处理, 有效果器开启时把单声道扩展成立体声
+     * @return 处理之后是否是立体声
+     */
+    bool Process(float* left, float* right, uint32_t numSamples, bool stereo);
+
+    /**
+     * @brief 每个效果器累计的周期数, 音频任务每个block读取后清零
+     */
+    uint32_t GetCycles(EffectId id) const { return cycles_[id]; }
+    void ClearCycles();
+private:
+    bool IsEnabled(EffectId id) const;
+
+    SynthParams& params_;
+    EffectArena arena_;
+    Distortion distortion_;
+    Chorus chorus_;
+    Delay delay_;
+    Reverb reverb_;
+
+    bool enabled_[kNumEffects]{};
+    uint32_t cycles_[kNumEffects]{};
+};
+
+}
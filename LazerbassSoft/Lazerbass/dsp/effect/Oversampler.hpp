@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <utility>
+
+namespace dsp {
+
+namespace halfband {
+
+/* 编译期用的cos, 不依赖编译器把std::cos当作constexpr */
+constexpr double Cos(double x) {
+    constexpr double kPi = 3.14159265358979323846;
+    while (x > kPi) x -= 2.0 * kPi;
+    while (x < -kPi) x += 2.0 * kPi;
+    double x2 = x * x;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int i = 1; i < 20; ++i) {
+        term *= -x2 / ((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @brief blackman窗的半带FIR, 长度4M-1, 中心抽头为0.5, 其余偶数偏移的抽头为0
+ * @return 奇数偏移-(2M-1), ..., -1, 1, ..., 2M-1 的2M个抽头, 和为0.5
+ */
+template<uint32_t M>
+constexpr std::array<float, 2 * M> Design() {
+    constexpr double kPi = 3.14159265358979323846;
+    std::array<double, 2 * M> taps{};
+    double sum = 0.0;
+    for (uint32_t j = 0; j < 2 * M; ++j) {
+        double offset = 2.0 * j - (2.0 * M - 1.0);
+        // 0.5 * sinc(offset / 2), 奇数偏移时sin为±1
+        double sign = ((j + M) & 1) ? -1.0 : 1.0;
+        double ideal = sign / (kPi * offset);
+        double phase = 2.0 * kPi * offset / (4.0 * M);
+        double window = 0.42 + 0.5 * Cos(phase) + 0.08 * Cos(2.0 * phase);
+        taps[j] = ideal * window;
+        sum += taps[j];
+    }
+    std::array<float, 2 * M> ret{};
+    for (uint32_t j = 0; j < 2 * M; ++j) {
+        ret[j] = static_cast<float>(taps[j] * 0.5 / sum);
+    }
+    return ret;
+}
+
+}
+
+/**
+ * @brief 2倍多相半带上采样, 偶相位为2M抽头的FIR, 奇相位为纯延迟
+ */
+template<uint32_t M>
+class HalfbandUpsampler {
+public:
+    static constexpr auto kTaps = halfband::Design<M>();
+    static constexpr uint32_t kHistory = 2 * M;
+
+    void Reset() {
+        history_.fill(0.0f);
+        pos_ = 0;
+    }
+
+    /* out的长度为2 * numSamples */
+    void Process(const float* in, float* out, uint32_t numSamples) {
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            // 写两份, 读取时总是连续的kHistory个
+            history_[pos_] = in[i];
+            history_[pos_ + kHistory] = in[i];
+            if (++pos_ == kHistory) {
+                pos_ = 0;
+            }
+            // window[k]为x[n - (2M - 1) + k]
+            const float* window = history_.data() + pos_;
+
+            float even = 0.0f;
+            for (uint32_t k = 0; k < kHistory; ++k) {
+                even += kTaps[k] * window[k];
+            }
+            out[2 * i] = 2.0f * even;
+            out[2 * i + 1] = window[M];
+        }
+    }
+
+    /**
+     * @brief 把func(k)加到倒数第k个输入上(k = 0为最新的输入), 之后的输出就像过去的输入里多了这个信号
+     */
+    template<class TFunc>
+    void AddToHistory(TFunc&& func) {
+        for (uint32_t k = 0; k < kHistory; ++k) {
+            uint32_t idx = (pos_ + kHistory - 1 - k) % kHistory;
+            float v = func(k);
+            history_[idx] += v;
+            history_[idx + kHistory] += v;
+        }
+    }
+private:
+    std::array<float, 2 * kHistory> history_{};
+    uint32_t pos_{};
+};
+
+/**
+ * @brief 2倍多相半带下采样, 偶数样本过2M抽头的FIR, 奇数样本只过中心抽头
+ */
+template<uint32_t M>
+class HalfbandDownsampler {
+public:
+    static constexpr auto kTaps = halfband::Design<M>();
+    static constexpr uint32_t kHistory = 2 * M;
+
+    void Reset() {
+        evens_.fill(0.0f);
+        odds_.fill(0.0f);
+        pos_ = 0;
+    }
+
+    /* in的长度为2 * numSamples */
+    void Process(const float* in, float* out, uint32_t numSamples) {
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            evens_[pos_] = in[2 * i];
+            evens_[pos_ + kHistory] = in[2 * i];
+            odds_[pos_] = in[2 * i + 1];
+            odds_[pos_ + kHistory] = in[2 * i + 1];
+            if (++pos_ == kHistory) {
+                pos_ = 0;
+            }
+            const float* evenWindow = evens_.data() + pos_;
+            const float* oddWindow = odds_.data() + pos_;
+
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < kHistory; ++k) {
+                sum += kTaps[k] * evenWindow[kHistory - 1 - k];
+            }
+            out[i] = sum + 0.5f * oddWindow[M - 1];
+        }
+    }
+private:
+    std::array<float, 2 * kHistory> evens_{};
+    std::array<float, 2 * kHistory> odds_{};
+    uint32_t pos_{};
+};
+
+/**
+ * @brief 1x/2x/4x过采样, 4x为两级半带级联, 第二级的信号已经限制在1/4带宽, 用更短的滤波器
+ *        第二级的延迟是半个原采样, 在2x采样率上补一个采样的延迟凑成整数
+ *        按子块处理, 过采样的缓冲在栈上
+ */
+class Oversampler {
+public:
+    static constexpr uint32_t kStage1 = 16; // 63 taps
+    static constexpr uint32_t kStage2 = 8;  // 31 taps
+    static constexpr uint32_t kSubBlock = 32;
+
+    void Reset() {
+        up1_.Reset();
+        up2_.Reset();
+        down2_.Reset();
+        down1_.Reset();
+        align_ = 0.0f;
+    }
+
+    /**
+     * @brief 上下采样的总延迟, 以原采样率计
+     */
+    static constexpr uint32_t GetLatency(uint32_t factor) {
+        switch (factor) {
+        case 2:
+            return 2 * kStage1 - 1;
+        case 4:
+            return 2 * kStage1 - 1 + kStage2;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * @brief 原地处理, func(float* x, uint32_t n)在过采样率上运行
+     */
+    template<class TFunc>
+    void Process(float* x, uint32_t numSamples, uint32_t factor, TFunc&& func) {
+        if (factor == 1) {
+            func(x, numSamples);
+            return;
+        }
+
+        float rate2[kSubBlock * 2];
+        float rate4[kSubBlock * 4];
+        for (uint32_t begin = 0; begin < numSamples; begin += kSubBlock) {
+            uint32_t n = std::min(kSubBlock, numSamples - begin);
+            up1_.Process(x + begin, rate2, n);
+            if (factor == 4) {
+                up2_.Process(rate2, rate4, 2 * n);
+                func(rate4, 4 * n);
+                down2_.Process(rate4, rate2, 2 * n);
+                for (uint32_t i = 0; i < 2 * n; ++i) {
+                    std::swap(rate2[i], align_);
+                }
+            }
+            else {
+                func(rate2, 2 * n);
+            }
+            down1_.Process(rate2, x + begin, n);
+        }
+    }
+private:
+    HalfbandUpsampler<kStage1> up1_;
+    HalfbandUpsampler<kStage2> up2_;
+    HalfbandDownsampler<kStage2> down2_;
+    HalfbandDownsampler<kStage1> down1_;
+    float align_{};
+};
+
+}
@@ -0,0 +1,76 @@
+#include "Reverb.hpp"
+
+namespace dsp {
+
+static constexpr float kInputGain = 0.03f;
+static constexpr float kMinRoom = 0.7f;
+static constexpr float kRoomRange = 0.28f;
+static constexpr float kMaxDamp = 0.4f;
+static constexpr float kAllpassFeedback = 0.5f;
+
+void Reverb::Init(uint32_t sampleRate, EffectArena& arena) {
+    valid_ = true;
+    for (uint32_t i = 0; i < kNumCombs; ++i) {
+        left_.combs[i].Init(arena.Alloc(ScaleLength(kCombLengths[i], sampleRate)));
+        right_.combs[i].Init(arena.Alloc(ScaleLength(kCombLengths[i] + kStereoSpread, sampleRate)));
+        valid_ = valid_ && left_.combs[i].GetSize() != 0 && right_.combs[i].GetSize() != 0;
+    }
+    for (uint32_t i = 0; i < kNumAllpasses; ++i) {
+        left_.allpasses[i].Init(arena.Alloc(ScaleLength(kAllpassLengths[i], sampleRate)));
+        right_.allpasses[i].Init(arena.Alloc(ScaleLength(kAllpassLengths[i] + kStereoSpread, sampleRate)));
+        valid_ = valid_ && left_.allpasses[i].GetSize() != 0 && right_.allpasses[i].GetSize() != 0;
+    }
+    Reset();
+}
+
+void Reverb::Reset() {
+    for (auto* channel : { &left_, &right_ }) {
+        for (auto& comb : channel->combs) {
+            comb.Clear();
+        }
+        for (auto& allpass : channel->allpasses) {
+            allpass.Clear();
+        }
+        channel->combStores.fill(0.0f);
+    }
+}
+
+float Reverb::Channel::Process(float input, float feedback, float damp) {
+    float out = 0.0f;
+    for (uint32_t i = 0; i < kNumCombs; ++i) {
+        float delayed = combs[i].Read(combs[i].GetSize());
+        combStores[i] = delayed * (1.0f - damp) + combStores[i] * damp;
+        combs[i].Push(input + combStores[i] * feedback);
+        out += delayed;
+    }
+    for (auto& allpass : allpasses) {
+        float delayed = allpass.Read(allpass.GetSize());
+        allpass.Push(out + delayed * kAllpassFeedback);
+        out = delayed - out;
+    }
+    return out;
+}
+
+void Reverb::Process(float* left, float* right, uint32_t numSamples) {
+    if (!valid_) {
+        return;
+    }
+
+    float size = params_.reverb.size.GetWithModulation();
+    float damping = params_.reverb.damping.GetWithModulation();
+    float mix = params_.reverb.mix.GetWithModulation();
+
+    const float feedback = kMinRoom + kRoomRange * size;
+    const float damp = damping * kMaxDamp;
+    const float dry = 1.0f - mix;
+
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        float input = (left[i] + right[i]) * kInputGain;
+        float l = left_.Process(input, feedback, damp);
+        float r = right_.Process(input, feedback, damp);
+        left[i] = left[i] * dry + l * mix;
+        right[i] = right[i] * dry + r * mix;
+    }
+}
+
+}
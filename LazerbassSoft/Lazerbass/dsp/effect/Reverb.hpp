@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include "dsp/params.hpp"
+#include "EffectArena.hpp"
+
+namespace dsp {
+
+/**
+ * @brief freeverb结构, 每个声道4个梳状滤波器和2个全通滤波器
+ */
+class Reverb {
+public:
+    static constexpr uint32_t kNumCombs = 4;
+    static constexpr uint32_t kNumAllpasses = 2;
+    static constexpr uint32_t kStereoSpread = 23;
+    // 44.1khz下的长度
+    static constexpr std::array<uint32_t, kNumCombs> kCombLengths{ 1116, 1188, 1277, 1356 };
+    static constexpr std::array<uint32_t, kNumAllpasses> kAllpassLengths{ 556, 441 };
+
+    static constexpr uint32_t ScaleLength(uint32_t length, uint32_t sampleRate) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(length) * sampleRate / 44100) + 1;
+    }
+    static constexpr uint32_t GetMemorySize(uint32_t sampleRate) {
+        uint32_t size = 0;
+        for (auto length : kCombLengths) {
+            size += ScaleLength(length, sampleRate) + ScaleLength(length + kStereoSpread, sampleRate);
+        }
+        for (auto length : kAllpassLengths) {
+            size += ScaleLength(length, sampleRate) + ScaleLength(length + kStereoSpread, sampleRate);
+        }
+        return size;
+    }
+
+    Reverb(SynthParams& params)
+        : params_(params) {}
+
+    void Init(uint32_t sampleRate, EffectArena& arena);
+    void Process(float* left, float* right, uint32_t numSamples);
+    void Reset();
+private:
+    struct Channel {
+        std::array<DelayLine, kNumCombs> combs;
+        std::array<float, kNumCombs> combStores{};
+        std::array<DelayLine, kNumAllpasses> allpasses;
+
+        float Process(float input, float feedback, float damp);
+    };
+
+    SynthParams& params_;
+    Channel left_;
+    Channel right_;
+    bool valid_{};
+};
+
+}
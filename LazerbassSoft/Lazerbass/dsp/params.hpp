@@ -38,6 +38,67 @@ static constexpr const char* kLFOTypeNames[] = {
     "noise"
 };
 
+enum class EnvelopeMode {
+    kAR = 0, // attack之后直接release
+    kADSR,
+    kAHDSR,  // attack之后保持hold的时间再decay
+    kCount
+};
+static constexpr const char* kEnvelopeModeNames[] = {
+    "AR",
+    "ADSR",
+    "AHDSR"
+};
+
+/* 可以在Tick之间按kAudioRateBlock个采样更新调制的参数 */
+enum class AudioRateTarget {
+    kPitch = 0,     // oscillor.pitch
+    kBeating,       // partialBeating.amount
+    kPhaseShift,    // periodFilter.phaseShift
+    kCount
+};
+static constexpr const char* kAudioRateTargetNames[] = {
+    "pitch",
+    "beating",
+    "phaseShift"
+};
+
+enum class PanMode {
+    kAlternate = 0, // 奇偶分音分到两边
+    kSpread,        // 奇偶分到两边, 越高的分音越宽
+    kRandom,        // 每个分音固定的随机位置
+    kCount
+};
+static constexpr const char* kPanModeNames[] = {
+    "alternate",
+    "spread",
+    "random"
+};
+
+enum class Oversample {
+    kX1 = 0,
+    kX2,
+    kX4,
+    kCount
+};
+static constexpr const char* kOversampleNames[] = {
+    "1x",
+    "2x",
+    "4x"
+};
+
+enum class TickSchedule {
+    kBlock = 0,     // Tick时一次算完
+    kSlice,         // 分摊到上一个Tick周期的子块
+    kPipeline,      // 预计算任务提前一个Tick周期计算
+    kCount
+};
+static constexpr const char* kTickScheduleNames[] = {
+    "block",
+    "slice",
+    "pipeline"
+};
+
 enum class ModulatorId {
     kLfo1 = 0,
     kLfo2,
@@ -46,11 +107,23 @@ enum class ModulatorId {
     kAmpEnv,
     kEnv1,
     kEnv2,
+    kModSequence,
+    kMacro1,
+    kMacro2,
+    kMacro3,
+    kMacro4,
+    kVelocity,
+    kKeyTrack,
+    kChannelPressure,
+    kPolyPressure,
     kCount
 };
 
 struct SynthParams {
-    uint32_t bpm = 120;
+    static constexpr int32_t kMaxNumOscs = 6;
+
+    uint32_t bpm = 120;        // 内部时钟的速度
+    float tempo = 120.0f;      // 实际的速度, 跟随MIDI时钟时是估计的速度, 音频任务每个Tick更新
 
     struct {
 //                                          | name            |  min  |  max  |   step      |   default   | altMul
@@ -91,9 +164,10 @@ struct SynthParams {
     struct {
 //                                          | name            |  min  |  max  |   step      |   default   | altMul
         EnumParamDesc<OscillatorType> type  { "type",                                           OscillatorType::kFullSaw };
-        IntParamDesc numPartials            { "numPartials",    2,      256,                    256,        8 }; // mul is 2
-        IntParamDesc number                 { "number",         2,      6,                      2,          1 };
+        IntParamDesc numPartials            { "numPartials",    2,      1024,                   256,        8 }; // mul is 2, 超过256个时用反FFT合成
+        IntParamDesc number                 { "number",         2,      kMaxNumOscs,            2,          1 };
         FloatParamDesc transport            { "transport",      -24.0f, 24.0f,      0.01f,      0.0f,       25 };
+        FloatParamDesc pitch                { "pitch",          -12.0f, 12.0f,      0.01f,      0.0f,       25 }; // 全局音高偏移(半音), 颤音的调制目标
         FloatParamDesc fundamental          { "fundamental",    0.0f,   1.0f,       0.01f,      1.0f,       10 };
         FloatParamDesc beating              { "beating",        0.0f,   16.0f,      0.01f,      0.0f,       25 };
         FloatParamDesc pluseWidth           { "pluseWidth",     0.0f,   1.0f,       0.01f,      1.0f,       10 };
@@ -118,9 +192,9 @@ struct SynthParams {
     struct {
 //                                          | name            |  min  |  max  |   step      |   default   | altMul
         BoolParamDesc enable                { "enable",                                         false };
-        FloatParamDesc brightness           { "brightness",     0.0f,   1.0f,       0.01f,      1.0f,       10 };
-        FloatParamDesc key                  { "key",            0.0f,   1.0f,       0.01f,      1.0f,       10 };
-        FloatParamDesc floor                { "floor",          0.0f,   1.0f,       0.01f,      1.0f,       10 };
+        FloatParamDesc brightness           { "brightness",     0.0f,   1.0f,       0.01f,      1.0f,       10 }; // 截止频率
+        FloatParamDesc key                  { "key",            0.0f,   1.0f,       0.01f,      1.0f,       10 }; // 截止频率跟随音高
+        FloatParamDesc floor                { "floor",          0.0f,   1.0f,       0.01f,      1.0f,       10 }; // 最大衰减, 1表示剔除分音
     } filter;
 
     struct {
@@ -135,6 +209,79 @@ struct SynthParams {
         FloatParamDesc pinch                { "pinch",          -1.0f,  1.0f,       0.01f,      0.0f,       10 };
     } periodFilter;
 
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc enable                { "enable",                                         false };
+        EnumParamDesc<PanMode> mode         { "mode",                                           PanMode::kAlternate };
+        FloatParamDesc width                { "width",          0.0f,   1.0f,       0.01f,      1.0f,       10 };
+        FloatParamDesc center               { "center",         -1.0f,  1.0f,       0.01f,      0.0f,       10 };
+    } pan;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc enable                { "enable",                                         false };
+        FloatParamDesc drive                { "drive",          0.0f,   1.0f,       0.01f,      0.3f,       10 }; // 0~36dB
+        FloatParamDesc tone                 { "tone",           0.0f,   1.0f,       0.01f,      0.7f,       10 };
+        FloatParamDesc mix                  { "mix",            0.0f,   1.0f,       0.01f,      1.0f,       10 };
+        EnumParamDesc<Oversample> oversample { "oversample",                                    Oversample::kX2 }; // 波形整形的过采样倍数
+    } distortion;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc enable                { "enable",                                         false };
+        FloatParamDesc rate                 { "rate",           0.05f,  5.0f,       0.01f,      0.5f,       10 }; // hz
+        FloatParamDesc depth                { "depth",          0.0f,   1.0f,       0.01f,      0.5f,       10 };
+        FloatParamDesc mix                  { "mix",            0.0f,   1.0f,       0.01f,      0.5f,       10 };
+    } chorus;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc enable                { "enable",                                         false };
+        FloatParamDesc time                 { "time",           10.0f,  400.0f,     1.0f,       250.0f,     10 }; // ms
+        FloatParamDesc feedback             { "feedback",       0.0f,   0.95f,      0.01f,      0.4f,       10 };
+        FloatParamDesc mix                  { "mix",            0.0f,   1.0f,       0.01f,      0.3f,       10 };
+    } delay;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc enable                { "enable",                                         false };
+        FloatParamDesc size                 { "size",           0.0f,   1.0f,       0.01f,      0.5f,       10 };
+        FloatParamDesc damping              { "damping",        0.0f,   1.0f,       0.01f,      0.5f,       10 };
+        FloatParamDesc mix                  { "mix",            0.0f,   1.0f,       0.01f,      0.25f,      10 };
+    } reverb;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc glide                 { "glide",                                          false };
+        FloatParamDesc time                 { "time",           1.0f,   2000.0f,    1.0f,       100.0f,     10 }; // ms, 滑到新音符的时间
+        BoolParamDesc legato                { "legato",                                         false }; // 按住时的新音符不重新触发
+        IntParamDesc bendRange              { "bendRange",      0,      24,                     2,          1 }; // 半音
+    } voice;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        FloatParamDesc volume               { "volume",         0.0f,   1.0f,       0.01f,      1.0f,       10 };
+    } master;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        FloatParamDesc macro1               { "macro1",         0.0f,   1.0f,       0.01f,      0.0f,       10 };
+        FloatParamDesc macro2               { "macro2",         0.0f,   1.0f,       0.01f,      0.0f,       10 };
+        FloatParamDesc macro3               { "macro3",         0.0f,   1.0f,       0.01f,      0.0f,       10 };
+        FloatParamDesc macro4               { "macro4",         0.0f,   1.0f,       0.01f,      0.0f,       10 };
+    } macro;
+
+    struct {
+//                                          | name            |  min  |  max  |   step      |   default   | altMul
+        BoolParamDesc smooth                { "smooth",                                         false }; // 逐采样插值增益和频率
+        IntParamDesc controlRate            { "ctrlRate",       100,    2000,                   200,        50 }; // Tick频率hz
+        EnumParamDesc<TickSchedule> schedule { "schedule",                                      TickSchedule::kBlock }; // 分音计算的调度方式
+        BoolParamDesc multirate             { "multirate",                                      true }; // 低频分音降采样渲染
+        BoolParamDesc audioPitch            { "audioPitch",                                     false }; // 音频速率的调制, 打开时按smooth渲染
+        BoolParamDesc audioBeating          { "audioBeating",                                   false };
+        BoolParamDesc audioPhase            { "audioPhase",                                     false };
+    } render;
+
     struct LfoParamDesc {
         const char* const name;
 //                                          | name            |  min  |  max  |   step      |   default   | altMul
@@ -151,7 +298,7 @@ struct SynthParams {
     LfoParamDesc lfo2 { .name = "lfo2" };
     LfoParamDesc lfo3 { .name = "lfo3" };
     LfoParamDesc lfo4 { .name = "lfo4" };
-    static constexpr float GetLfoFrequency(uint32_t bpm, LfoParamDesc& desc, float rate) {
+    static constexpr float GetLfoFrequency(float bpm, LfoParamDesc& desc, float rate) {
         float baseFreq = 0.0f;
         if (desc.bpm.value) {
             float mul0 = rate * 4.0f; // 2^0 ~ 2^4
@@ -159,7 +306,7 @@ struct SynthParams {
                 mul0 = std::round(mul0);
             }
             float div = std::exp2(mul0);
-            float freq = 60.0f / bpm;
+            float freq = bpm / 60.0f; // 每拍1~16个周期
             baseFreq = freq * div;
         }
         else {
@@ -204,9 +351,15 @@ struct SynthParams {
         const char* const name;
 //                                          | name            |  min  |  max  |   step      |   default   | altMul
         BoolParamDesc invert                { "invert",                                         false };
+        BoolParamDesc vca                   { "vca",                                            false }; // 只有ampEnv使用, 逐采样控制音量
+        EnumParamDesc<EnvelopeMode> mode    { "mode",                                           EnvelopeMode::kAR };
         FloatParamDesc attack               { "attack",         0.0f,   1.0f,       0.005f,     0.5f,       20 };
+        FloatParamDesc hold                 { "hold",           0.0f,   1.0f,       0.005f,     0.0f,       20 };
+        FloatParamDesc decay                { "decay",          0.0f,   1.0f,       0.005f,     0.5f,       20 };
+        FloatParamDesc sustain              { "sustain",        0.0f,   1.0f,       0.01f,      0.7f,       10 };
         FloatParamDesc peak                 { "peak",           0.0f,   1.0f,       0.01f,      1.0f,       10 };
         FloatParamDesc release              { "release",        0.0f,   1.0f,       0.005f,     0.5f,       20 };
+        FloatParamDesc curve                { "curve",          0.0f,   1.0f,       0.01f,      0.0f,       10 }; // 0接近直线, 1指数
     };
     EnvParamDesc ampEnv { .name = "ampEnv" };
     EnvParamDesc env1 { .name = "env1" };
@@ -13,6 +13,8 @@ void GuiDispatch::Init(void* audioSem, dsp::SynthParams& params, dsp::Lazerbass&
 
     auto& display = bsp::Oled::GetDisplay();
     SetMessageRect(display.getDrawAera().ReduceRatio(0.2f, 0.2f));
+
+    GuiObjs::preset.Init();
 }
 
 void GuiDispatch::Update() {
@@ -28,6 +30,8 @@ void GuiDispatch::Update() {
     }
 
     DrawMessage(display);
+    GuiObjs::sequencer.UpdateLeds();
+    GuiObjs::macro.UpdateLeds();
 }
 
 void GuiDispatch::DrawMessage(OLEDDisplay &display)
@@ -107,6 +111,14 @@ void GuiDispatch::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
 }
 
 void GuiDispatch::EnterParamModulations(dsp::FloatParamDesc& targetParam) {
+    // 按住步进键时是参数锁
+    if (GuiObjs::sequencer.LockHeldStep(targetParam)) {
+        return;
+    }
+    // 宏学习中加入宏
+    if (GuiObjs::macro.LearnParam(targetParam)) {
+        return;
+    }
     GuiObjs::paramModulations.SetTargetParam(targetParam);
     SetObj(GuiObjs::paramModulations);
 }
@@ -197,35 +209,87 @@ void GuiDispatch::PagePreEvent(bsp::ControlIO::ButtonEvent e) {
     case kPeriodFilter:
         targetObjShouldBe = &GuiObjs::periodFilter;
         break;
+    case kFilter:
+        targetObjShouldBe = &GuiObjs::filter;
+        break;
+    case kAttenuation:
+        targetObjShouldBe = &GuiObjs::attenuation;
+        break;
+    case kPan:
+        targetObjShouldBe = &GuiObjs::pan;
+        break;
+    case kDistortion:
+        targetObjShouldBe = &GuiObjs::distortion;
+        break;
+    case kChrous:
+        targetObjShouldBe = &GuiObjs::chorus;
+        break;
+    case kDelay:
+        targetObjShouldBe = &GuiObjs::delay;
+        break;
+    case kReverb:
+        targetObjShouldBe = &GuiObjs::reverb;
+        break;
+    case kMaster:
+        targetObjShouldBe = &GuiObjs::master;
+        break;
+    case kGlide:
+    case kLegato:
+        // 在Glide页面再按legato键切换legato
+        targetObjShouldBe = &GuiObjs::glide;
+        break;
+    case kMODSequence:
+        targetObjShouldBe = &GuiObjs::sequencer;
+        break;
+    case kMarco:
+        // 在其他页面按MARCO时结束学习, 在宏页面按时切换学习
+        if (obj_ != &GuiObjs::macro) {
+            GuiObjs::macro.StopLearn();
+        }
+        targetObjShouldBe = &GuiObjs::macro;
+        break;
+    case kPreset:
+        targetObjShouldBe = &GuiObjs::preset;
+        break;
+    case kPlay:
+    case kStop:
+    case kRecord:
+        // 传输键和步进键在任何页面都直接生效, 不切换页面
+        GuiObjs::sequencer.TransportEvent(e);
+        return;
     case kLFO1:
         targetObjShouldBe = &GuiObjs::lfo;
-        GuiObjs::lfo.SetTargetLfoParam(params_->lfo1);
+        GuiObjs::lfo.SetTargetLfoParam(params_->lfo1, dsp::ModulatorId::kLfo1);
         break;
     case kLFO2:
         targetObjShouldBe = &GuiObjs::lfo;
-        GuiObjs::lfo.SetTargetLfoParam(params_->lfo2);
+        GuiObjs::lfo.SetTargetLfoParam(params_->lfo2, dsp::ModulatorId::kLfo2);
         break;
     case kLFO3:
         targetObjShouldBe = &GuiObjs::lfo;
-        GuiObjs::lfo.SetTargetLfoParam(params_->lfo3);
+        GuiObjs::lfo.SetTargetLfoParam(params_->lfo3, dsp::ModulatorId::kLfo3);
         break;
     case kLFO4:
         targetObjShouldBe = &GuiObjs::lfo;
-        GuiObjs::lfo.SetTargetLfoParam(params_->lfo4);
+        GuiObjs::lfo.SetTargetLfoParam(params_->lfo4, dsp::ModulatorId::kLfo4);
         break;
     case kEnvelop1:
         targetObjShouldBe = &GuiObjs::envelope;
-        GuiObjs::envelope.SetTargetEnvParam(params_->env1);
+        GuiObjs::envelope.SetTargetEnvParam(params_->env1, bsp::ControlIO::LedId::kEnvelop1AR);
         break;
     case kEnvelop2:
         targetObjShouldBe = &GuiObjs::envelope;
-        GuiObjs::envelope.SetTargetEnvParam(params_->env2);
+        GuiObjs::envelope.SetTargetEnvParam(params_->env2, bsp::ControlIO::LedId::kEnvelop2AR);
         break;
     case kAmpEnvelop:
         targetObjShouldBe = &GuiObjs::envelope;
-        GuiObjs::envelope.SetTargetEnvParam(params_->ampEnv);
+        GuiObjs::envelope.SetTargetEnvParam(params_->ampEnv, bsp::ControlIO::LedId::kAMPEnvelopAR);
         break;
     default:
+        if (Sequencer::IsStepKey(e.id) || Sequencer::IsNoteKey(e.id)) {
+            GuiObjs::sequencer.StepEvent(e);
+            return;
+        }
         break;
     }
 
@@ -7,10 +7,22 @@
 #include "obj/Dispersion.hpp"
 #include "obj/OscPhase.hpp"
 #include "obj/PeriodFilter.hpp"
+#include "obj/Filter.hpp"
+#include "obj/Attenuation.hpp"
+#include "obj/Pan.hpp"
+#include "obj/Distortion.hpp"
+#include "obj/Chorus.hpp"
+#include "obj/Delay.hpp"
+#include "obj/Reverb.hpp"
 #include "obj/ParamModulations.hpp"
 #include "obj/LazerbassLogo.hpp"
 #include "obj/LFO.hpp"
 #include "obj/Envelope.hpp"
+#include "obj/Master.hpp"
+#include "obj/Glide.hpp"
+#include "obj/Sequencer.hpp"
+#include "obj/Macro.hpp"
+#include "obj/Preset.hpp"
 
 namespace gui {
 
@@ -22,10 +34,22 @@ struct GuiObjs {
     inline static Dispersion dispersion;
     inline static OscPhase oscPhase;
     inline static PeriodFilter periodFilter;
+    inline static Filter filter;
+    inline static Attenuation attenuation;
+    inline static Pan pan;
+    inline static Distortion distortion;
+    inline static Chorus chorus;
+    inline static Delay delay;
+    inline static Reverb reverb;
     inline static LazerbassLogo lazerbassLogo;
     inline static ParamModulations paramModulations;
     inline static LFO lfo;
     inline static Envelope envelope;
+    inline static Master master;
+    inline static Glide glide;
+    inline static Sequencer sequencer;
+    inline static Macro macro;
+    inline static Preset preset;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Attenuation.hpp"
+
+namespace gui {
+
+void Attenuation::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Attenuation");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.attenuation.enable.name, params.attenuation.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.attenuation.balance.name, params.attenuation.balance.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.attenuation.parttern.name, params.attenuation.parttern.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.attenuation.symmetry.name, params.attenuation.symmetry.Get());
+}
+
+void Attenuation::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.attenuation.enable.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kAttenuation, params.attenuation.enable.Get());
+        break;
+    case kReset2:
+        params.attenuation.balance.Reset();
+        break;
+    case kReset3:
+        params.attenuation.parttern.Reset();
+        break;
+    case kReset4:
+        params.attenuation.symmetry.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.attenuation.symmetry);
+        break;
+    default:
+        break;
+    }
+}
+
+void Attenuation::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.attenuation.enable.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kAttenuation, params.attenuation.enable.Get());
+        break;
+    case kEncoder2:
+        params.attenuation.balance.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.attenuation.parttern.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.attenuation.symmetry.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include "gui/GuiDispatch.hpp"
+
+namespace gui {
+
+struct Attenuation : public GuiObj {
+    void Draw(OLEDDisplay& display) override;
+    void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
+    void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Chorus.hpp"
+
+namespace gui {
+
+void Chorus::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Chorus");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.chorus.enable.name, params.chorus.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}hz", params.chorus.rate.name, params.chorus.rate.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.chorus.depth.name, params.chorus.depth.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.chorus.mix.name, params.chorus.mix.Get());
+}
+
+void Chorus::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.chorus.enable.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kChrous, params.chorus.enable.Get());
+        break;
+    case kReset2:
+        params.chorus.rate.Reset();
+        break;
+    case kMod2:
+        gGuiDispatch.EnterParamModulations(params.chorus.rate);
+        break;
+    case kReset3:
+        params.chorus.depth.Reset();
+        break;
+    case kMod3:
+        gGuiDispatch.EnterParamModulations(params.chorus.depth);
+        break;
+    case kReset4:
+        params.chorus.mix.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.chorus.mix);
+        break;
+    default:
+        break;
+    }
+}
+
+void Chorus::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.chorus.enable.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kChrous, params.chorus.enable.Get());
+        break;
+    case kEncoder2:
+        params.chorus.rate.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.chorus.depth.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.chorus.mix.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Delay.hpp"
+
+namespace gui {
+
+void Delay::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Delay");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.delay.enable.name, params.delay.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}ms", params.delay.time.name, params.delay.time.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.delay.feedback.name, params.delay.feedback.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.delay.mix.name, params.delay.mix.Get());
+}
+
+void Delay::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.delay.enable.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kDelay, params.delay.enable.Get());
+        break;
+    case kReset2:
+        params.delay.time.Reset();
+        break;
+    case kMod2:
+        gGuiDispatch.EnterParamModulations(params.delay.time);
+        break;
+    case kReset3:
+        params.delay.feedback.Reset();
+        break;
+    case kMod3:
+        gGuiDispatch.EnterParamModulations(params.delay.feedback);
+        break;
+    case kReset4:
+        params.delay.mix.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.delay.mix);
+        break;
+    default:
+        break;
+    }
+}
+
+void Delay::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.delay.enable.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kDelay, params.delay.enable.Get());
+        break;
+    case kEncoder2:
+        params.delay.time.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.delay.feedback.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.delay.mix.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "Distortion.hpp"
+#include "gui/PageSpliter.hpp"
+
+namespace gui {
+
+static PageSpliter sp {
+    std::array {
+        // ---------------------------------------- Page 0 ----------------------------------------
+        PageObj {
+            [](OLEDDisplay& display, Rectange& rect) {
+                auto& params = gGuiDispatch.GetParams();
+
+                auto box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.distortion.enable.name, params.distortion.enable.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.distortion.drive.name, params.distortion.drive.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.distortion.tone.name, params.distortion.tone.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.distortion.mix.name, params.distortion.mix.Get());
+            },
+            [](bsp::ControlIO::ButtonEvent e) {
+                using enum bsp::ControlIO::ButtonId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (e.id) {
+                case kReset1:
+                    params.distortion.enable.Reset();
+                    bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kDistortion, params.distortion.enable.Get());
+                    break;
+                case kReset2:
+                    params.distortion.drive.Reset();
+                    break;
+                case kMod2:
+                    gGuiDispatch.EnterParamModulations(params.distortion.drive);
+                    break;
+                case kReset3:
+                    params.distortion.tone.Reset();
+                    break;
+                case kMod3:
+                    gGuiDispatch.EnterParamModulations(params.distortion.tone);
+                    break;
+                case kReset4:
+                    params.distortion.mix.Reset();
+                    break;
+                case kMod4:
+                    gGuiDispatch.EnterParamModulations(params.distortion.mix);
+                    break;
+                default:
+                    break;
+                }
+            },
+            [](bsp::ControlIO::EncoderId id, int32_t dvalue) {
+                using enum bsp::ControlIO::EncoderId;
+
+                auto& params = gGuiDispatch.GetParams();
+                auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+                switch (id) {
+                case kEncoder1:
+                    params.distortion.enable.Add(dvalue);
+                    bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kDistortion, params.distortion.enable.Get());
+                    break;
+                case kEncoder2:
+                    params.distortion.drive.Add(dvalue, isAltDown);
+                    break;
+                case kEncoder3:
+                    params.distortion.tone.Add(dvalue, isAltDown);
+                    break;
+                case kEncoder4:
+                    params.distortion.mix.Add(dvalue, isAltDown);
+                    break;
+                default:
+                    break;
+                }
+            }
+        },
+        // ---------------------------------------- Page 1 ----------------------------------------
+        PageObj {
+            [](OLEDDisplay& display, Rectange& rect) {
+                auto& params = gGuiDispatch.GetParams();
+
+                auto box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.distortion.oversample.name, params.distortion.oversample.GetName(dsp::kOversampleNames));
+            },
+            [](bsp::ControlIO::ButtonEvent e) {
+                using enum bsp::ControlIO::ButtonId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (e.id) {
+                case kReset1:
+                    params.distortion.oversample.Reset();
+                    break;
+                default:
+                    break;
+                }
+            },
+            [](bsp::ControlIO::EncoderId id, int32_t dvalue) {
+                using enum bsp::ControlIO::EncoderId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (id) {
+                case kEncoder1:
+                    params.distortion.oversample.Add(dvalue);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+};
+
+void Distortion::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Distortion");
+    display.setColor(kOledWHITE);
+
+    sp.Draw(display, rect);
+}
+
+void Distortion::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    switch (e.id) {
+    case kUp:
+        sp.PrevPage();
+        break;
+    case kDown:
+        sp.NextPage();
+        break;
+    default:
+        sp.BtnEvent(e);
+        break;
+    }
+}
+
+void Distortion::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    sp.EncoderEvent(id, dvalue);
+}
+
+}
@@ -3,54 +3,124 @@
 
 namespace gui {
 
+static void DrawTimeSlider(OLEDDisplay& display, Rectange box, const dsp::FloatParamDesc& param) {
+    float time = dsp::SynthParams::EnvVal01ToTime(param.Get());
+    if (time > 1.0f) {
+        styles::DrawFormatSlider(display, box, box.w * param.Get(), "{}: {}s", param.name, std::round(time));
+    }
+    else {
+        styles::DrawFormatSlider(display, box, box.w * param.Get(), "{}: {}ms", param.name, time * 1000.0f);
+    }
+}
+
 void Envelope::Draw(OLEDDisplay& display) {
     auto rect = display.getDrawAera();
     auto box = rect.RemoveFromTop(12).WithHeight(10);
 
     styles::DrawTitleBar(display, box, targetEnvParam_->name);
 
-    box = rect.RemoveFromTop(12).Reduce(3, 1).WithWidth(40);
-    styles::DrawButton(display, box, targetEnvParam_->invert.Get(), "invert");
+    if (page_ == 0) {
+        box = rect.RemoveFromTop(12).Reduce(3, 1).WithWidth(40);
+        styles::DrawButton(display, box, targetEnvParam_->invert.Get(), "invert");
 
-    box = rect.RemoveFromTop(12).WithHeight(10);
-    float time = dsp::SynthParams::EnvVal01ToTime(targetEnvParam_->attack.Get());
-    if (time > 1.0f) {
-        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->attack.Get(), "{}: {}s", targetEnvParam_->attack.name, std::round(time));
-    }
-    else {
-        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->attack.Get(), "{}: {}ms", targetEnvParam_->attack.name, time * 1000.0f);
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        DrawTimeSlider(display, box, targetEnvParam_->attack);
+
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        DrawTimeSlider(display, box, targetEnvParam_->release);
+
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->peak.Get(), "{}: {}", targetEnvParam_->peak.name, targetEnvParam_->peak.Get());
     }
+    else if (page_ == 1) {
+        box = rect.RemoveFromTop(12).Reduce(3, 1);
+        display.setColor(kOledWHITE);
+        display.drawRect(box.x, box.y, box.w, box.h);
+        display.drawString(box.x, box.y, targetEnvParam_->mode.GetName(dsp::kEnvelopeModeNames));
 
-    box = rect.RemoveFromTop(12).WithHeight(10);
-    time = dsp::SynthParams::EnvVal01ToTime(targetEnvParam_->release.Get());
-    if (time > 1.0f) {
-        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->release.Get(), "{}: {}s", targetEnvParam_->release.name, std::round(time));
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        DrawTimeSlider(display, box, targetEnvParam_->decay);
+
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->sustain.Get(), "{}: {}", targetEnvParam_->sustain.name, targetEnvParam_->sustain.Get());
+
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->curve.Get(), "{}: {}", targetEnvParam_->curve.name, targetEnvParam_->curve.Get());
     }
     else {
-        styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->release.Get(), "{}: {}ms", targetEnvParam_->release.name, time * 1000.0f);
-    }
+        // vca只对ampEnv有效
+        box = rect.RemoveFromTop(12).Reduce(3, 1).WithWidth(40);
+        styles::DrawButton(display, box, targetEnvParam_->vca.Get(), "vca");
 
-    box = rect.RemoveFromTop(12).WithHeight(10);
-    styles::DrawFormatSlider(display, box, box.w * targetEnvParam_->peak.Get(), "{}: {}", targetEnvParam_->peak.name, targetEnvParam_->peak.Get());
+        box = rect.RemoveFromTop(12).WithHeight(10);
+        DrawTimeSlider(display, box, targetEnvParam_->hold);
+    }
 }
 
 void Envelope::BtnEvent(bsp::ControlIO::ButtonEvent e) {
     using enum bsp::ControlIO::ButtonId;
 
     switch (e.id) {
-    case kReset1:
-        targetEnvParam_->invert.Reset();
+    case kUp:
+        if (page_ > 0) {
+            --page_;
+        }
         break;
-    case kReset2:
-        targetEnvParam_->attack.Reset();
-        break;
-    case kReset3:
-        targetEnvParam_->release.Reset();
-        break;
-    case kReset4:
-        targetEnvParam_->peak.Reset();
+    case kDown:
+        if (page_ < kMaxPageIndex) {
+            ++page_;
+        }
         break;
     default:
+        if (page_ == 0) {
+            switch (e.id) {
+            case kReset1:
+                targetEnvParam_->invert.Reset();
+                break;
+            case kReset2:
+                targetEnvParam_->attack.Reset();
+                break;
+            case kReset3:
+                targetEnvParam_->release.Reset();
+                break;
+            case kReset4:
+                targetEnvParam_->peak.Reset();
+                break;
+            default:
+                break;
+            }
+        }
+        else if (page_ == 1) {
+            switch (e.id) {
+            case kReset1:
+                targetEnvParam_->mode.Reset();
+                bsp::ControlIO::SetLed(arLed_, targetEnvParam_->mode.Get() == dsp::EnvelopeMode::kAR);
+                break;
+            case kReset2:
+                targetEnvParam_->decay.Reset();
+                break;
+            case kReset3:
+                targetEnvParam_->sustain.Reset();
+                break;
+            case kReset4:
+                targetEnvParam_->curve.Reset();
+                break;
+            default:
+                break;
+            }
+        }
+        else {
+            switch (e.id) {
+            case kReset1:
+                targetEnvParam_->vca.Reset();
+                break;
+            case kReset2:
+                targetEnvParam_->hold.Reset();
+                break;
+            default:
+                break;
+            }
+        }
         break;
     }
 }
@@ -60,19 +130,50 @@ void Envelope::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
 
     auto isAltDown = bsp::ControlIO::IsAltKeyDown();
 
-    switch (id) {
-    case kEncoder1:
-        targetEnvParam_->invert.Add(dvalue);
-        break;
-    case kEncoder2:
-        targetEnvParam_->attack.Add(dvalue, isAltDown);
-        break;
-    case kEncoder3:
-        targetEnvParam_->release.Add(dvalue, isAltDown);
-        break;
-    case kEncoder4:
-        targetEnvParam_->peak.Add(dvalue, isAltDown);
-        break;
+    if (page_ == 0) {
+        switch (id) {
+        case kEncoder1:
+            targetEnvParam_->invert.Add(dvalue);
+            break;
+        case kEncoder2:
+            targetEnvParam_->attack.Add(dvalue, isAltDown);
+            break;
+        case kEncoder3:
+            targetEnvParam_->release.Add(dvalue, isAltDown);
+            break;
+        case kEncoder4:
+            targetEnvParam_->peak.Add(dvalue, isAltDown);
+            break;
+        }
+    }
+    else if (page_ == 1) {
+        switch (id) {
+        case kEncoder1:
+            targetEnvParam_->mode.Add(dvalue);
+            bsp::ControlIO::SetLed(arLed_, targetEnvParam_->mode.Get() == dsp::EnvelopeMode::kAR);
+            break;
+        case kEncoder2:
+            targetEnvParam_->decay.Add(dvalue, isAltDown);
+            break;
+        case kEncoder3:
+            targetEnvParam_->sustain.Add(dvalue, isAltDown);
+            break;
+        case kEncoder4:
+            targetEnvParam_->curve.Add(dvalue, isAltDown);
+            break;
+        }
+    }
+    else {
+        switch (id) {
+        case kEncoder1:
+            targetEnvParam_->vca.Add(dvalue);
+            break;
+        case kEncoder2:
+            targetEnvParam_->hold.Add(dvalue, isAltDown);
+            break;
+        default:
+            break;
+        }
     }
 }
 
@@ -10,9 +10,15 @@ public:
     void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
     void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
 
-    void SetTargetEnvParam(dsp::SynthParams::EnvParamDesc& targetLfoParam) { targetEnvParam_ = &targetLfoParam; }
+    void SetTargetEnvParam(dsp::SynthParams::EnvParamDesc& targetEnvParam, bsp::ControlIO::LedId arLed) {
+        targetEnvParam_ = &targetEnvParam;
+        arLed_ = arLed;
+    }
 private:
     dsp::SynthParams::EnvParamDesc* targetEnvParam_{};
+    bsp::ControlIO::LedId arLed_{};
+    int32_t page_{};
+    static constexpr int32_t kMaxPageIndex = 2;
 };
 
 }
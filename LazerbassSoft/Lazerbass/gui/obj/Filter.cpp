@@ -0,0 +1,87 @@
+#include "Filter.hpp"
+
+namespace gui {
+
+void Filter::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Filter");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.filter.enable.name, params.filter.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.filter.brightness.name, params.filter.brightness.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.filter.key.name, params.filter.key.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.filter.floor.name, params.filter.floor.Get());
+}
+
+void Filter::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.filter.enable.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kFilter, params.filter.enable.Get());
+        break;
+    case kReset2:
+        params.filter.brightness.Reset();
+        break;
+    case kMod2:
+        gGuiDispatch.EnterParamModulations(params.filter.brightness);
+        break;
+    case kReset3:
+        params.filter.key.Reset();
+        break;
+    case kMod3:
+        gGuiDispatch.EnterParamModulations(params.filter.key);
+        break;
+    case kReset4:
+        params.filter.floor.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.filter.floor);
+        break;
+    default:
+        break;
+    }
+}
+
+void Filter::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.filter.enable.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kFilter, params.filter.enable.Get());
+        break;
+    case kEncoder2:
+        params.filter.brightness.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.filter.key.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.filter.floor.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "Glide.hpp"
+
+namespace gui {
+
+void Glide::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Glide");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.voice.glide.name, params.voice.glide.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}ms", params.voice.time.name, params.voice.time.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.voice.legato.name, params.voice.legato.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.voice.bendRange.name, params.voice.bendRange.Get());
+}
+
+void Glide::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.voice.glide.Reset();
+        break;
+    case kReset2:
+        params.voice.time.Reset();
+        break;
+    case kReset3:
+        params.voice.legato.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kLegato, params.voice.legato.Get());
+        break;
+    case kReset4:
+        params.voice.bendRange.Reset();
+        break;
+    case kLegato:
+        // 面板上的legato键直接切换
+        params.voice.legato.Add(params.voice.legato.Get() ? -1 : 1);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kLegato, params.voice.legato.Get());
+        break;
+    default:
+        break;
+    }
+}
+
+void Glide::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.voice.glide.Add(dvalue);
+        break;
+    case kEncoder2:
+        params.voice.time.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.voice.legato.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kLegato, params.voice.legato.Get());
+        break;
+    case kEncoder4:
+        params.voice.bendRange.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
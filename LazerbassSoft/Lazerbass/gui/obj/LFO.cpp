@@ -10,7 +10,6 @@ namespace gui {
 void LFO::Draw(OLEDDisplay& display) {
     auto rect = display.getDrawAera();
     auto box = rect.RemoveFromTop(10);
-    auto& params = gGuiDispatch.GetParams();
 
     styles::DrawTitleBar(display, box, targetLfoParam_->name);
 
@@ -50,7 +49,7 @@ void LFO::Draw(OLEDDisplay& display) {
             }
         }
         else {
-            display.FormatString(box.x, box.y, "rate: {:3} hz", dsp::SynthParams::GetLfoFrequency(params.bpm, *targetLfoParam_, targetLfoParam_->rate.Get()));
+            display.FormatString(box.x, box.y, "rate: {:3} hz", gGuiDispatch.GetSynth().GetLfoRate(lfoId_));
         }
 
         int16_t fillWidth = static_cast<int16_t>(val01 * box.w);
@@ -10,9 +10,13 @@ public:
     void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
     void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
 
-    void SetTargetLfoParam(dsp::SynthParams::LfoParamDesc& targetLfoParam) { targetLfoParam_ = &targetLfoParam; }
+    void SetTargetLfoParam(dsp::SynthParams::LfoParamDesc& targetLfoParam, dsp::ModulatorId lfoId) {
+        targetLfoParam_ = &targetLfoParam;
+        lfoId_ = lfoId;
+    }
 private:
     dsp::SynthParams::LfoParamDesc* targetLfoParam_{};
+    dsp::ModulatorId lfoId_{};
     int32_t page_{};
     static constexpr int32_t kMaxPageIndex = 1;
 };
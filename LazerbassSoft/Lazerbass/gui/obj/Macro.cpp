@@ -0,0 +1,218 @@
+#include "Macro.hpp"
+
+#include "gui/Styles.hpp"
+
+namespace gui {
+
+dsp::ModulatorDesc Macro::GetSelectedMacro() {
+    auto id = static_cast<int32_t>(dsp::ModulatorId::kMacro1) + static_cast<int32_t>(selected_);
+    return gGuiDispatch.GetSynth().GetModulatorDesc(static_cast<dsp::ModulatorId>(id));
+}
+
+/* 目标就是以这个宏为源的link, 每次从调制矩阵里重新取, 其他页面增删link后也是对的 */
+uint32_t Macro::RefreshTargets() {
+    auto& modulationBank = gGuiDispatch.GetSynth().GetModulationBank();
+    numTargets_ = modulationBank.GetLinkOfModulator(GetSelectedMacro(), std::span(targets_));
+    targetPos_ = numTargets_ == 0 ? 0 : dsp::ClampUncheck(targetPos_, 0, static_cast<int32_t>(numTargets_) - 1);
+    return numTargets_;
+}
+
+void Macro::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+    auto& modulationBank = gGuiDispatch.GetSynth().GetModulationBank();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Macro {} {}", selected_ + 1, learning_ ? "learn" : "");
+    display.setColor(kOledWHITE);
+
+    if (page_ == 0) {
+        dsp::ModulationLinkHandle links[dsp::ModulationBank::kMaxNumModulations];
+        for (uint32_t i = 0; i < dsp::Macros::kNumMacros; ++i) {
+            const auto& knob = dsp::Macros::GetKnob(params, i);
+            auto id = static_cast<dsp::ModulatorId>(static_cast<int32_t>(dsp::ModulatorId::kMacro1) + static_cast<int32_t>(i));
+            auto numLinks = modulationBank.GetLinkOfModulator(gGuiDispatch.GetSynth().GetModulatorDesc(id), std::span(links));
+            box = rect.RemoveFromTop(12);
+            styles::DrawFormatSlider(display, box, box.w * knob.Get(), "{}: {}  x{}", knob.name, knob.Get(), numLinks);
+        }
+        return;
+    }
+
+    RefreshTargets();
+    box = rect.RemoveFromTop(12);
+    if (numTargets_ == 0) {
+        display.drawString(box.x, box.y, "no target, MARCO to learn");
+        return;
+    }
+
+    const auto* link = targets_[targetPos_];
+    const auto* param = link->targetParam;
+    display.FormatString(box.x, box.y, "{} of {}: {}", targetPos_ + 1, numTargets_, param->name);
+
+    box = rect.RemoveFromTop(12);
+    styles::DrawFormatSlider(display, box, box.w * (link->offset + 1) / 2, "from: {}", param->GetFloatValue(link->offset));
+
+    const float to = link->offset + link->amount;
+    box = rect.RemoveFromTop(12);
+    styles::DrawFormatSlider(display, box, box.w * (to + 1) / 2, "to: {}", param->GetFloatValue(to));
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "curve: {}  {}", dsp::kModulationCurveNames[static_cast<int32_t>(link->curve)], link->enable ? "" : "off");
+}
+
+void Macro::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto& modulationBank = gGuiDispatch.GetSynth().GetModulationBank();
+
+    switch (e.id) {
+    case kUp:
+        if (page_ > 0) {
+            --page_;
+        }
+        return;
+    case kDown:
+        if (page_ < kMaxPageIndex) {
+            ++page_;
+        }
+        return;
+    case kMarco:
+        learning_ = !learning_;
+        if (learning_) {
+            gGuiDispatch.ShowMessage("press MOD of params to add", 1000);
+        }
+        return;
+    default:
+        break;
+    }
+
+    if (page_ == 0) {
+        switch (e.id) {
+        case kReset1:
+            params.macro.macro1.Reset();
+            break;
+        case kReset2:
+            params.macro.macro2.Reset();
+            break;
+        case kReset3:
+            params.macro.macro3.Reset();
+            break;
+        case kReset4:
+            params.macro.macro4.Reset();
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    if (RefreshTargets() == 0) {
+        return;
+    }
+
+    auto* link = targets_[targetPos_];
+    switch (e.id) {
+    case kDelete:
+        modulationBank.RemoveLink(link);
+        RefreshTargets();
+        return;
+    case kReset2:
+        link->amount += link->offset;
+        link->offset = 0.0f;
+        break;
+    case kReset3:
+        link->amount = kDefaultTo - link->offset;
+        break;
+    case kReset4:
+        link->curve = dsp::ModulationCurve::kLinear;
+        break;
+    default:
+        return;
+    }
+    modulationBank.Compile();
+}
+
+void Macro::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsAltKeyDown();
+
+    if (page_ == 0) {
+        const auto macro = static_cast<uint32_t>(id);
+        dsp::Macros::GetKnob(params, macro).Add(dvalue, isAltDown);
+        selected_ = macro;
+        return;
+    }
+
+    if (id == kEncoder1 && isAltDown) {
+        selected_ = static_cast<uint32_t>(dsp::ClampUncheck(static_cast<int32_t>(selected_) + dvalue, 0, static_cast<int32_t>(dsp::Macros::kNumMacros) - 1));
+        targetPos_ = 0;
+        return;
+    }
+
+    if (RefreshTargets() == 0) {
+        return;
+    }
+
+    auto* link = targets_[targetPos_];
+    const float step = isAltDown ? 0.1f : 0.01f;
+    switch (id) {
+    case kEncoder1:
+        targetPos_ = dsp::ClampUncheck(targetPos_ + dvalue, 0, static_cast<int32_t>(numTargets_) - 1);
+        return;
+    case kEncoder2: {
+        // 改变起点时终点不动
+        const float to = link->offset + link->amount;
+        link->offset = std::round(dsp::ClampUncheck(link->offset + dvalue * step, -1.0f, 1.0f) * 100) / 100.0f;
+        link->amount = to - link->offset;
+        break;
+    }
+    case kEncoder3: {
+        const float to = std::round(dsp::ClampUncheck(link->offset + link->amount + dvalue * step, -1.0f, 1.0f) * 100) / 100.0f;
+        link->amount = to - link->offset;
+        break;
+    }
+    case kEncoder4: {
+        auto curve = static_cast<int32_t>(link->curve) + dvalue;
+        curve = dsp::ClampUncheck(curve, 0, static_cast<int32_t>(dsp::ModulationCurve::kCount) - 1);
+        link->curve = static_cast<dsp::ModulationCurve>(curve);
+        break;
+    }
+    default:
+        return;
+    }
+    gGuiDispatch.GetSynth().GetModulationBank().Compile();
+}
+
+bool Macro::LearnParam(dsp::FloatParamDesc& param) {
+    if (!learning_) {
+        return false;
+    }
+
+    auto& modulationBank = gGuiDispatch.GetSynth().GetModulationBank();
+    bool existed = false;
+    auto* link = modulationBank.AddNewLink(GetSelectedMacro(), &param, existed);
+    if (existed) {
+        gGuiDispatch.ShowMessage("param already in macro", 1000);
+    }
+    else if (link == nullptr) {
+        gGuiDispatch.ShowMessage("num of link has reached max", 1000);
+    }
+    else {
+        link->amount = kDefaultTo;
+        modulationBank.Compile();
+        gGuiDispatch.ShowMessage("param added to macro", 1000);
+    }
+    return true;
+}
+
+void Macro::UpdateLeds() {
+    bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kMarco, learning_);
+}
+
+}
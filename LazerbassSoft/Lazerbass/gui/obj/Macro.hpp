@@ -0,0 +1,43 @@
+#pragma once
+#include "gui/GuiDispatch.hpp"
+#include "dsp/Macros.hpp"
+
+namespace gui {
+
+/**
+ * @brief 宏页面
+ *        第0页: 4个编码器直接调4个宏旋钮
+ *        第1页: 编辑选中的宏的目标, 每个目标的范围from~to和曲线, DELETE删除目标
+ *        在宏页面再按MARCO进入学习: 之后在任何页面按参数的MOD键, 参数加入选中的宏, 再按MARCO结束
+ */
+class Macro : public GuiObj {
+public:
+    void Draw(OLEDDisplay& display) override;
+    void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
+    void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
+
+    /**
+     * @brief 学习中把参数加入选中的宏, 返回是否处理了
+     */
+    bool LearnParam(dsp::FloatParamDesc& param);
+    void StopLearn() { learning_ = false; }
+    /**
+     * @brief 刷新MARCO键的LED, 每一帧调用
+     */
+    void UpdateLeds();
+private:
+    static constexpr int32_t kMaxPageIndex = 1;
+    static constexpr float kDefaultTo = 0.5f;   // 新目标的范围是0~kDefaultTo
+
+    dsp::ModulatorDesc GetSelectedMacro();
+    uint32_t RefreshTargets();
+
+    uint32_t selected_{};
+    int32_t page_{};
+    int32_t targetPos_{};
+    bool learning_{};
+    dsp::ModulationLinkHandle targets_[dsp::ModulationBank::kMaxNumModulations]{};
+    uint32_t numTargets_{};
+};
+
+}
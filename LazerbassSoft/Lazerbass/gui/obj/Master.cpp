@@ -0,0 +1,172 @@
+#include "Master.hpp"
+#include "gui/PageSpliter.hpp"
+
+namespace gui {
+
+static PageSpliter sp {
+    std::array {
+        // ---------------------------------------- Page 0 ----------------------------------------
+        PageObj {
+            [](OLEDDisplay& display, Rectange& rect) {
+                auto& params = gGuiDispatch.GetParams();
+
+                auto box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.smooth.name, params.render.smooth.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}hz", params.render.controlRate.name, params.render.controlRate.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.schedule.name, params.render.schedule.GetName(dsp::kTickScheduleNames));
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.master.volume.name, params.master.volume.Get());
+            },
+            [](bsp::ControlIO::ButtonEvent e) {
+                using enum bsp::ControlIO::ButtonId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (e.id) {
+                case kReset1:
+                    params.render.smooth.Reset();
+                    break;
+                case kReset2:
+                    params.render.controlRate.Reset();
+                    break;
+                case kReset3:
+                    params.render.schedule.Reset();
+                    break;
+                case kReset4:
+                    params.master.volume.Reset();
+                    break;
+                case kMod4:
+                    gGuiDispatch.EnterParamModulations(params.master.volume);
+                    break;
+                default:
+                    break;
+                }
+            },
+            [](bsp::ControlIO::EncoderId id, int32_t dvalue) {
+                using enum bsp::ControlIO::EncoderId;
+
+                auto& params = gGuiDispatch.GetParams();
+                auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+                switch (id) {
+                case kEncoder1:
+                    params.render.smooth.Add(dvalue);
+                    break;
+                case kEncoder2:
+                    params.render.controlRate.Add(dvalue, isAltDown);
+                    break;
+                case kEncoder3:
+                    params.render.schedule.Add(dvalue);
+                    break;
+                case kEncoder4:
+                    params.master.volume.Add(dvalue, isAltDown);
+                    break;
+                default:
+                    break;
+                }
+            }
+        },
+        // ---------------------------------------- Page 1 ----------------------------------------
+        PageObj {
+            [](OLEDDisplay& display, Rectange& rect) {
+                auto& params = gGuiDispatch.GetParams();
+
+                auto box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.multirate.name, params.render.multirate.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.audioPitch.name, params.render.audioPitch.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.audioBeating.name, params.render.audioBeating.Get());
+
+                box = rect.RemoveFromTop(12);
+                display.FormatString(box.x, box.y, "{}: {}", params.render.audioPhase.name, params.render.audioPhase.Get());
+            },
+            [](bsp::ControlIO::ButtonEvent e) {
+                using enum bsp::ControlIO::ButtonId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (e.id) {
+                case kReset1:
+                    params.render.multirate.Reset();
+                    break;
+                case kReset2:
+                    params.render.audioPitch.Reset();
+                    break;
+                case kReset3:
+                    params.render.audioBeating.Reset();
+                    break;
+                case kReset4:
+                    params.render.audioPhase.Reset();
+                    break;
+                default:
+                    break;
+                }
+            },
+            [](bsp::ControlIO::EncoderId id, int32_t dvalue) {
+                using enum bsp::ControlIO::EncoderId;
+
+                auto& params = gGuiDispatch.GetParams();
+
+                switch (id) {
+                case kEncoder1:
+                    params.render.multirate.Add(dvalue);
+                    break;
+                case kEncoder2:
+                    params.render.audioPitch.Add(dvalue);
+                    break;
+                case kEncoder3:
+                    params.render.audioBeating.Add(dvalue);
+                    break;
+                case kEncoder4:
+                    params.render.audioPhase.Add(dvalue);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+};
+
+void Master::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Master");
+    display.setColor(kOledWHITE);
+
+    sp.Draw(display, rect);
+}
+
+void Master::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    switch (e.id) {
+    case kUp:
+        sp.PrevPage();
+        break;
+    case kDown:
+        sp.NextPage();
+        break;
+    default:
+        sp.BtnEvent(e);
+        break;
+    }
+}
+
+void Master::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    sp.EncoderEvent(id, dvalue);
+}
+
+}
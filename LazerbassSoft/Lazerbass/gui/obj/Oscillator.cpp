@@ -155,6 +155,9 @@ static PageSpliter sp {
                 else {
                     d.FormatString(box.x, box.y, "NO SETTING HERE");
                 }
+
+                box = r.RemoveFromTop(12);
+                d.FormatString(box.x, box.y, "{}: {}", param.oscillor.pitch.name, param.oscillor.pitch.Get());
             },
             [](bsp::ControlIO::ButtonEvent e) {
                 using enum bsp::ControlIO::ButtonId;
@@ -174,6 +177,12 @@ static PageSpliter sp {
                         gGuiDispatch.EnterParamModulations(params.oscillor.fundamental);
                     }
                     break;
+                case kReset2:
+                    params.oscillor.pitch.Reset();
+                    break;
+                case kMod2:
+                    gGuiDispatch.EnterParamModulations(params.oscillor.pitch);
+                    break;
                 default:
                     break;
                 }
@@ -192,6 +201,9 @@ static PageSpliter sp {
                         params.oscillor.fundamental.Add(dvalue, isAltDown);
                     }
                     break;
+                case kEncoder2:
+                    params.oscillor.pitch.Add(dvalue, isAltDown);
+                    break;
                 default:
                     break;
                 }
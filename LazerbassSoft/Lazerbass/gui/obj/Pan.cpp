@@ -0,0 +1,82 @@
+#include "Pan.hpp"
+
+namespace gui {
+
+void Pan::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Pan");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.pan.enable.name, params.pan.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.pan.mode.name, params.pan.mode.GetName(dsp::kPanModeNames));
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.pan.width.name, params.pan.width.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.pan.center.name, params.pan.center.Get());
+}
+
+void Pan::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.pan.enable.Reset();
+        break;
+    case kReset2:
+        params.pan.mode.Reset();
+        break;
+    case kReset3:
+        params.pan.width.Reset();
+        break;
+    case kMod3:
+        gGuiDispatch.EnterParamModulations(params.pan.width);
+        break;
+    case kReset4:
+        params.pan.center.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.pan.center);
+        break;
+    default:
+        break;
+    }
+}
+
+void Pan::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.pan.enable.Add(dvalue);
+        break;
+    case kEncoder2:
+        params.pan.mode.Add(dvalue);
+        break;
+    case kEncoder3:
+        params.pan.width.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.pan.center.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
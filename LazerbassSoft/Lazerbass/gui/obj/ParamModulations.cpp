@@ -16,6 +16,12 @@ static struct ModulatorChoose : public GuiObj {
 
         display.setColor(kOledWHITE);
         aera = aera.Reduce(1, 1);
+        // MIDI的调制器没有按键, EC1选择, MOD1添加
+        auto box = aera.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "mod1: {}", GetMidiModulator().name);
+        // 宏也没有单独的按键, EC2选择, MARCO添加
+        box = aera.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "macro: {}", GetMacro().name);
         display.drawStringMaxWidth(aera.x, aera.y, aera.w, "press a modulator key.  DELETE is go back");
     }
 
@@ -50,7 +56,15 @@ static struct ModulatorChoose : public GuiObj {
         case kAmpEnvelop:
             modulatorDesc = synth.GetModulatorDesc(ModulatorId::kAmpEnv);
             break;
-        // case kMODSequence:
+        case kMod1:
+            modulatorDesc = GetMidiModulator();
+            break;
+        case kMODSequence:
+            modulatorDesc = synth.GetModulatorDesc(ModulatorId::kModSequence);
+            break;
+        case kMarco:
+            modulatorDesc = GetMacro();
+            break;
         case kDelete:
             gGuiDispatch.RemoveOverlay(handle_);
             gGuiDispatch.EnableAutoSwitchPage();
@@ -74,23 +88,46 @@ static struct ModulatorChoose : public GuiObj {
                 gGuiDispatch.ShowMessage("num of link has reached max", 1000);
             }
             else {
-                {
-                    AudioLockGuide lockGuide{ gGuiDispatch.GetAudioLock() };
-                    paramModulations_->AddLink(link);
-                }
+                paramModulations_->AddLink(link);
             }
         }
         gGuiDispatch.RemoveOverlay(handle_);
         gGuiDispatch.EnableAutoSwitchPage();
     }
 
-    void EncoderEvent(bsp::ControlIO::EncoderId /*id*/, int32_t /*dvalue*/) override {}
+    void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override {
+        if (id == bsp::ControlIO::EncoderId::kEncoder1) {
+            midiPick_ = dsp::ClampUncheck(midiPick_ + dvalue, 0, kNumMidiPicks - 1);
+        }
+        else if (id == bsp::ControlIO::EncoderId::kEncoder2) {
+            macroPick_ = dsp::ClampUncheck(macroPick_ + dvalue, 0, static_cast<int32_t>(dsp::Macros::kNumMacros) - 1);
+        }
+    }
+
+    dsp::ModulatorDesc GetMacro() {
+        auto id = static_cast<int32_t>(dsp::ModulatorId::kMacro1) + macroPick_;
+        return gGuiDispatch.GetSynth().GetModulatorDesc(static_cast<dsp::ModulatorId>(id));
+    }
+
+    /* 先是velocity, key, aftertouch, polyAT, 然后是CC1~127 */
+    dsp::ModulatorDesc GetMidiModulator() {
+        auto& synth = gGuiDispatch.GetSynth();
+        if (midiPick_ < kNumMidiNotes) {
+            return synth.GetModulatorDesc(static_cast<dsp::ModulatorId>(static_cast<int32_t>(dsp::ModulatorId::kVelocity) + midiPick_));
+        }
+        return synth.GetControllerModulatorDesc(static_cast<uint32_t>(midiPick_ - kNumMidiNotes + 1));
+    }
 
     void SetHandle(GuiDispatch::OverlayObjHandle handle) { handle_ = handle; }
     void SetParent(ParamModulations* parent) { paramModulations_ = parent; }
 
+    static constexpr int32_t kNumMidiNotes = static_cast<int32_t>(dsp::ModulatorId::kCount) - static_cast<int32_t>(dsp::ModulatorId::kVelocity);
+    static constexpr int32_t kNumMidiPicks = kNumMidiNotes + dsp::MidiModulators::kNumControllers;
+
     GuiDispatch::OverlayObjHandle handle_ = nullptr;
     ParamModulations* paramModulations_ = nullptr;
+    int32_t midiPick_ = 0;
+    int32_t macroPick_ = 0;
 } modulatorChoose;
 
 // --------------------------------------------------------------------------------
@@ -128,7 +165,14 @@ void ParamModulations::Draw(OLEDDisplay& display) {
         right.Reduced(2, 1);
 
         styles::DrawOnOffButton(display, left, link->enable, "enable", "disable");
-        styles::DrawOnOffButton(display, right, link->symmetric, "symmetric", "asymmetric");
+        if (bsp::ControlIO::IsButtonDown(bsp::ControlIO::ButtonId::kMod4)) {
+            // alt时右边显示曲线
+            auto* curveName = dsp::kModulationCurveNames[static_cast<int32_t>(link->curve)];
+            styles::DrawOnOffButton(display, right, link->curve != dsp::ModulationCurve::kLinear, curveName, curveName);
+        }
+        else {
+            styles::DrawOnOffButton(display, right, link->symmetric, "symmetric", "asymmetric");
+        }
 
         display.setColor(kOledWHITE);
         left.Expand(1, 1);
@@ -162,10 +206,8 @@ void ParamModulations::BtnEvent(bsp::ControlIO::ButtonEvent e) {
             auto link = links_[listPos_];
             std::swap(link, links_[numLinks_ - 1]);
             numLinks_--;
-            {
-                AudioLockGuide audioLock{ gGuiDispatch.GetAudioLock() };
-                modulationBank.RemoveLink(link);
-            }
+            // 调制矩阵编译后无锁交给音频任务
+            modulationBank.RemoveLink(link);
             if (listPos_ >= numLinks_) {
                 listPos_ = numLinks_ - 1;
             }
@@ -189,11 +231,17 @@ void ParamModulations::BtnEvent(bsp::ControlIO::ButtonEvent e) {
             link->enable = true;
             break;
         case kReset4:
-            link->symmetric = false;
+            if (bsp::ControlIO::IsButtonDown(kMod4)) {
+                link->curve = dsp::ModulationCurve::kLinear;
+            }
+            else {
+                link->symmetric = false;
+            }
             break;
         default:
             break;
         }
+        modulationBank.Compile();
     }
 }
 
@@ -229,11 +277,19 @@ void ParamModulations::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue
         link->enable = dvalue > 0;
         break;
     case kEncoder4:
-        link->symmetric = dvalue > 0;
+        if (isAltDown) {
+            auto curve = static_cast<int32_t>(link->curve) + dvalue;
+            curve = dsp::ClampUncheck(curve, 0, static_cast<int32_t>(dsp::ModulationCurve::kCount) - 1);
+            link->curve = static_cast<dsp::ModulationCurve>(curve);
+        }
+        else {
+            link->symmetric = dvalue > 0;
+        }
         break;
     default:
         break;
     }
+    gGuiDispatch.GetSynth().GetModulationBank().Compile();
 }
 
 void ParamModulations::SetTargetParam(dsp::FloatParamDesc& targetParam) {
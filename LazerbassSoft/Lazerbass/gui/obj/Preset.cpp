@@ -0,0 +1,138 @@
+#include "Preset.hpp"
+#include <algorithm>
+#include "mcu/Memory.hpp"
+#include "bsp/QspiFlash.hpp"
+#include "preset/PresetCodec.hpp"
+#include "preset/FlashPresetStore.hpp"
+
+namespace gui {
+
+static bsp::QspiFlash flash_;
+static preset::FlashPresetStore store_{ flash_ };
+_BSS_SRAMD1 static preset::PresetCodec codec_;
+_BSS_SRAMD1 alignas(4) static uint8_t buffer_[preset::PresetCodec::kMaxSize];
+static_assert(preset::PresetCodec::kMaxSize <= preset::FlashPresetStore::kMaxDataSize);
+
+void Preset::Init() {
+    codec_.Init(gGuiDispatch.GetSynth());
+    mounted_ = flash_.Init() && store_.Mount();
+    if (!mounted_) {
+        gGuiDispatch.ShowMessage("preset storage not available", 1000);
+        return;
+    }
+    if (store_.GetSize(0) != 0) {
+        Load(0);
+    }
+}
+
+bool Preset::Load(uint32_t slot) {
+    const uint32_t size = store_.Read(slot, buffer_);
+    if (size == 0) {
+        gGuiDispatch.ShowMessage("empty slot", 1000);
+        return false;
+    }
+
+    auto result = codec_.Decode(std::span(buffer_, size));
+    if (result != preset::PresetCodec::Result::kOk) {
+        gGuiDispatch.ShowMessage(preset::PresetCodec::kResultNames[static_cast<int32_t>(result)], 1000);
+        return false;
+    }
+
+    {
+        AudioLockGuide guide{ gGuiDispatch.GetAudioLock() };
+        codec_.Apply();
+    }
+    gGuiDispatch.ShowMessage(codec_.GetNumSkipped() == 0 ? "preset loaded" : "loaded, some items skipped", 1000);
+    return true;
+}
+
+bool Preset::Save(uint32_t slot) {
+    // 音序器在音频任务中改写锁住的参数, 复制值要持有音频锁; link只在GUI任务中修改, 编码不需要锁
+    {
+        AudioLockGuide guide{ gGuiDispatch.GetAudioLock() };
+        codec_.Capture();
+    }
+    const uint32_t size = codec_.Encode(buffer_);
+    if (size == 0 || !store_.Write(slot, std::span(buffer_, size))) {
+        gGuiDispatch.ShowMessage("save failed", 1000);
+        return false;
+    }
+    gGuiDispatch.ShowMessage("preset saved", 1000);
+    return true;
+}
+
+void Preset::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Preset {}", slot_ + 1);
+    display.setColor(kOledWHITE);
+
+    if (!mounted_) {
+        box = rect.RemoveFromTop(12);
+        display.drawString(box.x, box.y, "storage not available");
+        return;
+    }
+
+    const uint32_t size = store_.GetSize(slot_);
+    box = rect.RemoveFromTop(12);
+    if (size == 0) {
+        display.drawString(box.x, box.y, "empty");
+    }
+    else {
+        display.FormatString(box.x, box.y, "stored: {} bytes", size);
+    }
+
+    box = rect.RemoveFromTop(12);
+    display.drawString(box.x, box.y, "PRESET: load");
+    box = rect.RemoveFromTop(12);
+    display.drawString(box.x, box.y, "ALT+PRESET: save");
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "free: {}K", store_.GetFreeBytes() / 1024);
+}
+
+void Preset::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    if (!mounted_) {
+        return;
+    }
+
+    auto isAltDown = bsp::ControlIO::IsAltKeyDown();
+    switch (e.id) {
+    case kPreset:
+        if (isAltDown) {
+            Save(slot_);
+        }
+        else {
+            Load(slot_);
+        }
+        break;
+    case kDelete:
+        if (isAltDown && store_.Erase(slot_)) {
+            gGuiDispatch.ShowMessage("preset erased", 1000);
+        }
+        break;
+    case kUp:
+        slot_ = slot_ == 0 ? 0 : slot_ - 1;
+        break;
+    case kDown:
+        slot_ = std::min(slot_ + 1, preset::PresetStore::kNumSlots - 1);
+        break;
+    default:
+        break;
+    }
+}
+
+void Preset::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    if (id == kEncoder1) {
+        slot_ = static_cast<uint32_t>(dsp::ClampUncheck(static_cast<int32_t>(slot_) + dvalue, 0, static_cast<int32_t>(preset::PresetStore::kNumSlots) - 1));
+    }
+}
+
+}
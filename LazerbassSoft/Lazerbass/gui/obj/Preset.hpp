@@ -0,0 +1,29 @@
+#pragma once
+#include "gui/GuiDispatch.hpp"
+
+namespace gui {
+
+/**
+ * @brief 预设页面
+ *        编码器1选择槽位, PRESET加载, ALT+PRESET保存, ALT+DELETE清空
+ *        加载时在GUI任务中读取和解码, 只有写参数和替换link时持有音频锁
+ */
+class Preset : public GuiObj {
+public:
+    /**
+     * @brief 挂载存储, 有槽位0时加载它, 在GuiDispatch::Init中调用
+     */
+    void Init();
+
+    void Draw(OLEDDisplay& display) override;
+    void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
+    void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
+private:
+    bool Load(uint32_t slot);
+    bool Save(uint32_t slot);
+
+    uint32_t slot_{};
+    bool mounted_{};
+};
+
+}
@@ -0,0 +1,87 @@
+#include "Reverb.hpp"
+
+namespace gui {
+
+void Reverb::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& params = gGuiDispatch.GetParams();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Reverb");
+    display.setColor(kOledWHITE);
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.reverb.enable.name, params.reverb.enable.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.reverb.size.name, params.reverb.size.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.reverb.damping.name, params.reverb.damping.Get());
+
+    box = rect.RemoveFromTop(12);
+    display.FormatString(box.x, box.y, "{}: {}", params.reverb.mix.name, params.reverb.mix.Get());
+}
+
+void Reverb::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& params = gGuiDispatch.GetParams();
+
+    switch (e.id) {
+    case kReset1:
+        params.reverb.enable.Reset();
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kReverb, params.reverb.enable.Get());
+        break;
+    case kReset2:
+        params.reverb.size.Reset();
+        break;
+    case kMod2:
+        gGuiDispatch.EnterParamModulations(params.reverb.size);
+        break;
+    case kReset3:
+        params.reverb.damping.Reset();
+        break;
+    case kMod3:
+        gGuiDispatch.EnterParamModulations(params.reverb.damping);
+        break;
+    case kReset4:
+        params.reverb.mix.Reset();
+        break;
+    case kMod4:
+        gGuiDispatch.EnterParamModulations(params.reverb.mix);
+        break;
+    default:
+        break;
+    }
+}
+
+void Reverb::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& params = gGuiDispatch.GetParams();
+    auto isAltDown = bsp::ControlIO::IsButtonDown(bsp::ControlIO::kAltKey);
+
+    switch (id) {
+    case kEncoder1:
+        params.reverb.enable.Add(dvalue);
+        bsp::ControlIO::SetLed(bsp::ControlIO::LedId::kReverb, params.reverb.enable.Get());
+        break;
+    case kEncoder2:
+        params.reverb.size.Add(dvalue, isAltDown);
+        break;
+    case kEncoder3:
+        params.reverb.damping.Add(dvalue, isAltDown);
+        break;
+    case kEncoder4:
+        params.reverb.mix.Add(dvalue, isAltDown);
+        break;
+    default:
+        break;
+    }
+}
+
+}
\ No newline at end of file
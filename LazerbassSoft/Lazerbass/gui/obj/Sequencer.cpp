@@ -0,0 +1,292 @@
+#include "Sequencer.hpp"
+
+namespace gui {
+
+using ButtonId = bsp::ControlIO::ButtonId;
+using LedId = bsp::ControlIO::LedId;
+
+static constexpr ButtonId kStepKeys[] = {
+    ButtonId::kSeq0, ButtonId::kSeq1, ButtonId::kSeq2, ButtonId::kSeq3,
+    ButtonId::kSeq4, ButtonId::kSeq5, ButtonId::kSeq6, ButtonId::kSeq7,
+    ButtonId::kSeq8, ButtonId::kSeq9, ButtonId::kSeq10, ButtonId::kSeq11,
+    ButtonId::kSeq12, ButtonId::kSeq13, ButtonId::kSeq14, ButtonId::kSeq15,
+};
+static_assert(std::size(kStepKeys) == dsp::Sequencer::kNumSteps);
+
+// Seq16~23是一个八度的白键
+static constexpr ButtonId kNoteKeys[] = {
+    ButtonId::kSeq16, ButtonId::kSeq17, ButtonId::kSeq18, ButtonId::kSeq19,
+    ButtonId::kSeq20, ButtonId::kSeq21, ButtonId::kSeq22, ButtonId::kSeq23,
+};
+static constexpr int32_t kNoteKeyOffsets[] = { 0, 2, 4, 5, 7, 9, 11, 12 };
+static_assert(std::size(kNoteKeys) == std::size(kNoteKeyOffsets));
+
+static constexpr const char* kNoteNames[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+uint32_t Sequencer::StepIndex(ButtonId id) {
+    for (uint32_t i = 0; i < std::size(kStepKeys); ++i) {
+        if (kStepKeys[i] == id) {
+            return i;
+        }
+    }
+    return kNoStep;
+}
+
+uint32_t Sequencer::NoteKeyIndex(ButtonId id) {
+    for (uint32_t i = 0; i < std::size(kNoteKeys); ++i) {
+        if (kNoteKeys[i] == id) {
+            return i;
+        }
+    }
+    return kNoStep;
+}
+
+dsp::Sequencer::Step& Sequencer::GetSelectedStep() {
+    return gGuiDispatch.GetSynth().GetSequencer().GetPattern().steps[selected_];
+}
+
+void Sequencer::SelectStep(uint32_t step) {
+    selected_ = step % dsp::Sequencer::kNumSteps;
+    gGuiDispatch.GetSynth().GetSequencer().SetRecordStep(selected_);
+}
+
+void Sequencer::Draw(OLEDDisplay& display) {
+    auto rect = display.getDrawAera();
+    auto box = rect.RemoveFromTop(12);
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+    auto& params = gGuiDispatch.GetParams();
+    const auto& step = GetSelectedStep();
+
+    display.setColor(kOledWHITE);
+    display.fillRect(box.x, box.y, box.w, box.h);
+    display.setColor(kOledBLACK);
+    display.FormatString(box.x, box.y, "Sequencer {} {}", sequencer.IsPlaying() ? "play" : "stop", sequencer.IsRecording() ? "rec" : "");
+    display.setColor(kOledWHITE);
+
+    if (page_ == 0) {
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "step {}: {}  locks: {}", selected_ + 1, step.active ? "on" : "off", step.numLocks);
+
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "note: {}{}", kNoteNames[step.note % 12], step.note / 12 - 1);
+
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "velocity: {}", step.velocity);
+
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "gate: {}%", step.gate);
+    }
+    else {
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "mod: {}", step.mod);
+
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "length: {}", sequencer.GetPattern().length);
+
+        box = rect.RemoveFromTop(12);
+        auto& clock = gGuiDispatch.GetSynth().GetMidiClock();
+        if (clock.IsLocked()) {
+            display.FormatString(box.x, box.y, "bpm: ext {:.1f}", clock.GetBpm());
+        }
+        else {
+            display.FormatString(box.x, box.y, "bpm: {}", params.bpm);
+        }
+
+        box = rect.RemoveFromTop(12);
+        display.FormatString(box.x, box.y, "octave: {}", octave_);
+    }
+}
+
+void Sequencer::BtnEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+    auto& step = GetSelectedStep();
+
+    switch (e.id) {
+    case kUp:
+        if (page_ > 0) {
+            --page_;
+        }
+        break;
+    case kDown:
+        if (page_ < kMaxPageIndex) {
+            ++page_;
+        }
+        break;
+    default:
+        if (page_ == 0) {
+            switch (e.id) {
+            case kReset1: {
+                AudioLockGuide guide{ gGuiDispatch.GetAudioLock() };
+                sequencer.ClearParamLocks(selected_);
+                break;
+            }
+            case kReset2:
+                step.note = dsp::Sequencer::kDefaultNote;
+                break;
+            case kReset3:
+                step.velocity = dsp::Sequencer::kDefaultVelocity;
+                break;
+            case kReset4:
+                step.gate = dsp::Sequencer::kDefaultGate;
+                break;
+            default:
+                break;
+            }
+        }
+        else {
+            switch (e.id) {
+            case kReset1:
+                step.mod = 0.0f;
+                break;
+            case kReset2:
+                sequencer.GetPattern().length = dsp::Sequencer::kNumSteps;
+                break;
+            case kReset3:
+                gGuiDispatch.GetParams().bpm = 120;
+                break;
+            case kReset4:
+                octave_ = 3;
+                break;
+            default:
+                break;
+            }
+        }
+        break;
+    }
+}
+
+void Sequencer::EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) {
+    using enum bsp::ControlIO::EncoderId;
+
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+    auto& step = GetSelectedStep();
+    auto isAltDown = bsp::ControlIO::IsAltKeyDown();
+
+    if (page_ == 0) {
+        switch (id) {
+        case kEncoder1:
+            SelectStep(static_cast<uint32_t>(dsp::ClampUncheck(static_cast<int32_t>(selected_) + dvalue, 0, static_cast<int32_t>(dsp::Sequencer::kNumSteps) - 1)));
+            break;
+        case kEncoder2:
+            step.note = static_cast<uint8_t>(dsp::ClampUncheck(step.note + dvalue * (isAltDown ? 12 : 1), 0, 127));
+            break;
+        case kEncoder3:
+            step.velocity = static_cast<uint8_t>(dsp::ClampUncheck(step.velocity + dvalue * (isAltDown ? 10 : 1), 1, 127));
+            break;
+        case kEncoder4:
+            step.gate = static_cast<uint8_t>(dsp::ClampUncheck(step.gate + dvalue * (isAltDown ? 10 : 1), 1, 100));
+            break;
+        }
+    }
+    else {
+        switch (id) {
+        case kEncoder1:
+            step.mod = dsp::ClampUncheck(step.mod + dvalue * (isAltDown ? 0.1f : 0.01f), 0.0f, 1.0f);
+            break;
+        case kEncoder2: {
+            auto& pattern = sequencer.GetPattern();
+            pattern.length = static_cast<uint32_t>(dsp::ClampUncheck(static_cast<int32_t>(pattern.length) + dvalue, 1, static_cast<int32_t>(dsp::Sequencer::kNumSteps)));
+            break;
+        }
+        case kEncoder3: {
+            auto& params = gGuiDispatch.GetParams();
+            params.bpm = static_cast<uint32_t>(dsp::ClampUncheck(static_cast<int32_t>(params.bpm) + dvalue * (isAltDown ? 10 : 1),
+                                                                 dsp::Sequencer::kMinBpm, dsp::Sequencer::kMaxBpm));
+            break;
+        }
+        case kEncoder4:
+            octave_ = dsp::ClampUncheck(octave_ + dvalue, 0, kMaxOctave);
+            break;
+        }
+    }
+}
+
+void Sequencer::TransportEvent(bsp::ControlIO::ButtonEvent e) {
+    using enum bsp::ControlIO::ButtonId;
+
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+
+    switch (e.id) {
+    case kPlay:
+        sequencer.Play();
+        break;
+    case kStop:
+        sequencer.Stop();
+        break;
+    case kRecord:
+        sequencer.SetRecord(!sequencer.IsRecording());
+        break;
+    default:
+        break;
+    }
+}
+
+/* 按下即切换, 按住加参数锁时这一步总是打开 */
+void Sequencer::StepEvent(bsp::ControlIO::ButtonEvent e) {
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+
+    auto stepIdx = StepIndex(e.id);
+    if (stepIdx != kNoStep) {
+        SelectStep(stepIdx);
+        auto& step = GetSelectedStep();
+        step.active = !step.active;
+        return;
+    }
+
+    auto keyIdx = NoteKeyIndex(e.id);
+    if (keyIdx != kNoStep) {
+        auto& step = GetSelectedStep();
+        step.note = static_cast<uint8_t>(dsp::ClampUncheck(octave_ * 12 + kNoteKeyOffsets[keyIdx], 0, 127));
+        step.active = true;
+        // 停止时录音, 写完前进一步
+        if (sequencer.IsRecording() && !sequencer.IsPlaying()) {
+            SelectStep((selected_ + 1) % sequencer.GetPattern().length);
+        }
+    }
+}
+
+bool Sequencer::LockHeldStep(dsp::FloatParamDesc& param) {
+    for (uint32_t i = 0; i < std::size(kStepKeys); ++i) {
+        if (!bsp::ControlIO::IsButtonDown(kStepKeys[i])) {
+            continue;
+        }
+
+        auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+        bool ok = false;
+        {
+            AudioLockGuide guide{ gGuiDispatch.GetAudioLock() };
+            ok = sequencer.AddParamLock(i, param);
+        }
+        if (ok) {
+            sequencer.GetPattern().steps[i].active = true;
+            gGuiDispatch.ShowMessage("param locked on step", 1000);
+        }
+        else {
+            gGuiDispatch.ShowMessage("num of locks has reached max", 1000);
+        }
+        return true;
+    }
+    return false;
+}
+
+/* 打开的步亮, 播放中的步反转 */
+void Sequencer::UpdateLeds() {
+    auto& sequencer = gGuiDispatch.GetSynth().GetSequencer();
+    const auto& pattern = sequencer.GetPattern();
+    const bool playing = sequencer.IsPlaying();
+    const uint32_t playingStep = sequencer.GetPlayingStep();
+
+    for (uint32_t i = 0; i < dsp::Sequencer::kNumSteps; ++i) {
+        bool on = pattern.steps[i].active;
+        if (playing && i == playingStep) {
+            on = !on;
+        }
+        bsp::ControlIO::SetLed(static_cast<uint32_t>(LedId::kSeq0) + i, on);
+    }
+    bsp::ControlIO::SetLed(LedId::kPlay, playing);
+    bsp::ControlIO::SetLed(LedId::kRecord, sequencer.IsRecording());
+}
+
+}
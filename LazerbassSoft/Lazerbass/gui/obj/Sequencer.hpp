@@ -0,0 +1,46 @@
+#pragma once
+#include "gui/GuiDispatch.hpp"
+#include "dsp/Sequencer.hpp"
+
+namespace gui {
+
+/**
+ * @brief 音序器页面, 传输键和Seq键在任何页面都直接生效
+ *        Seq0~15: 选择并开关一步, Seq16~23: 一个八度的白键, 写入选中的步
+ *        按住Seq0~15再按某个参数的MOD键: 把参数现在的值锁到这一步
+ */
+class Sequencer : public GuiObj {
+public:
+    void Draw(OLEDDisplay& display) override;
+    void BtnEvent(bsp::ControlIO::ButtonEvent e) override;
+    void EncoderEvent(bsp::ControlIO::EncoderId id, int32_t dvalue) override;
+
+    void TransportEvent(bsp::ControlIO::ButtonEvent e);
+    void StepEvent(bsp::ControlIO::ButtonEvent e);
+    /**
+     * @brief 有Seq0~15按住时把参数锁到那一步, 返回是否锁了
+     */
+    bool LockHeldStep(dsp::FloatParamDesc& param);
+    /**
+     * @brief 刷新Play/Record和步进的LED, 每一帧调用
+     */
+    void UpdateLeds();
+
+    static bool IsStepKey(bsp::ControlIO::ButtonId id) { return StepIndex(id) != kNoStep; }
+    static bool IsNoteKey(bsp::ControlIO::ButtonId id) { return NoteKeyIndex(id) != kNoStep; }
+private:
+    static constexpr uint32_t kNoStep = UINT32_MAX;
+    static constexpr int32_t kMaxPageIndex = 1;
+    static constexpr int32_t kMaxOctave = 9;
+
+    static uint32_t StepIndex(bsp::ControlIO::ButtonId id);
+    static uint32_t NoteKeyIndex(bsp::ControlIO::ButtonId id);
+    dsp::Sequencer::Step& GetSelectedStep();
+    void SelectStep(uint32_t step);
+
+    uint32_t selected_{};
+    int32_t page_{};
+    int32_t octave_{ 3 };
+};
+
+}
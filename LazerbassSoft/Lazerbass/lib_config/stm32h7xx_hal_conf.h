@@ -78,7 +78,7 @@
 #define HAL_PCD_MODULE_ENABLED
 #define HAL_PWR_MODULE_ENABLED
 // #define HAL_PSSI_MODULE_ENABLED
-// #define HAL_QSPI_MODULE_ENABLED
+#define HAL_QSPI_MODULE_ENABLED
 // #define HAL_RAMECC_MODULE_ENABLED
 #define HAL_RCC_MODULE_ENABLED
 // #define HAL_RNG_MODULE_ENABLED
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <numbers>
 
@@ -20,30 +21,65 @@
 
 _NOINIT_SRAMD1 static StackType_t _audioStack[8192];
 static StaticTask_t _audioTcb;
-static dsp::Lazerbass bass_;
-static StereoSample _buffer[bsp::PCM5102::kBlockSize];
+_BSS_SRAMD1 static dsp::Lazerbass::PartialTable _partialTables[dsp::Lazerbass::kNumPartialTables];
+_BSS_SRAMD2 static float _effectMemory[dsp::EffectChain::kArenaSize];
+_BSS_DTCM static dsp::Lazerbass bass_{ _partialTables, _effectMemory };
+_BSS_DTCM static bsp::PCM5102::Sample _buffer[bsp::PCM5102::kBlockSize];
 static StaticSemaphore_t audioLock_;
 static SemaphoreHandle_t audioLockHandle_ = NULL;
 
+static StaticSemaphore_t precomputeSem_;
+static SemaphoreHandle_t precomputeSemHandle_ = NULL;
+
 static uint32_t audioTickCounter = 0;
+static uint32_t audioCycleCounter = 0;
+static uint32_t effectCycleCounters[dsp::EffectChain::kNumEffects]{};
+static uint32_t audioRateCycleCounters[static_cast<uint32_t>(dsp::AudioRateTarget::kCount)]{};
 static void AudioTask(void*) {
     bsp::PCM5102::Init();
     bsp::PCM5102::Start();
 
     bass_.Init(bsp::PCM5102::kSampleRate, 200);
+    bass_.SetCpuClock(bsp::Time::GetCpuClock());
     
     for (;;) {
         auto buf = bsp::PCM5102::GetNextBlock();
-
-        xSemaphoreTake(audioLockHandle_, portMAX_DELAY);
+        bass_.BeginBlock(bsp::Time::GetCycles());
 
         bsp::Time::ClearCounter();
+        uint32_t cycles = 0;
 
-        bass_.Process(std::span{_buffer, std::size(_buffer)});
+        /* 按Tick分块渲染, 只在渲染时持有锁, 有预计算请求时唤醒预计算任务
+         * 预计算任务优先级更低, 在音频任务等待DMA时运行, 来不及时Tick继续使用上一张表
+         */
+        uint32_t samplePos = 0;
+        while (samplePos < std::size(_buffer)) {
+            uint32_t numSamples = std::min<uint32_t>(bass_.GetSamplesToNextTick(), std::size(_buffer) - samplePos);
 
-        audioTickCounter = bsp::Time::GetTick();
+            xSemaphoreTake(audioLockHandle_, portMAX_DELAY);
+            uint32_t cycleBegin = bsp::Time::GetCycles();
+            bass_.Process(std::span{_buffer + samplePos, numSamples});
+            cycles += bsp::Time::GetCycles() - cycleBegin;
+            bool requested = bass_.IsPipelineRequested();
+            xSemaphoreGive(audioLockHandle_);
 
-        xSemaphoreGive(audioLockHandle_);
+            if (requested) {
+                xSemaphoreGive(precomputeSemHandle_);
+            }
+            samplePos += numSamples;
+        }
+
+        audioCycleCounter = cycles;
+        auto& effects = bass_.GetEffectChain();
+        for (uint32_t i = 0; i < dsp::EffectChain::kNumEffects; ++i) {
+            effectCycleCounters[i] = effects.GetCycles(static_cast<dsp::EffectChain::EffectId>(i));
+        }
+        effects.ClearCycles();
+        for (uint32_t i = 0; i < std::size(audioRateCycleCounters); ++i) {
+            audioRateCycleCounters[i] = bass_.GetAudioRateCycles(static_cast<dsp::AudioRateTarget>(i));
+        }
+        bass_.ClearAudioRateCycles();
+        audioTickCounter = bsp::Time::GetTick();
 
         std::copy_n(_buffer, std::size(_buffer), buf.begin());
     }
@@ -51,12 +87,40 @@ static void AudioTask(void*) {
     bsp::PCM5102::Stop();
     bsp::PCM5102::DeInit();
 }
+
+_NOINIT_SRAMD1 static StackType_t _precomputeStack[1024];
+static StaticTask_t _precomputeTcb;
+static void PrecomputeTask(void*) {
+    for (;;) {
+        xSemaphoreTake(precomputeSemHandle_, portMAX_DELAY);
+        bass_.RunPipeline();
+    }
+}
  
 _NOINIT_SRAMD1 static StackType_t _testStack[1024];
 static StaticTask_t _testTcb;
 static void TestTask(void*) {
     for (;;) {
         bsp::DebugIO::Write("[debug] audio task take %dms\n\r", bsp::Time::Tick2Ms(audioTickCounter));
+        bsp::DebugIO::Write("[debug] %s kernel %d cycles per block, %d cycles per sample at %dhz %dbit\n\r",
+                            bass_.IsIfftBackend() ? "ifft" : bass_.GetParams().render.smooth.Get() ? "smooth" : "plain", audioCycleCounter,
+                            audioCycleCounter / bsp::PCM5102::kBlockSize, bsp::PCM5102::kSampleRate, bsp::PCM5102::kBitDepth);
+        bsp::DebugIO::Write("[debug] %s schedule\n\r",
+                            bass_.GetParams().render.schedule.GetName(dsp::kTickScheduleNames));
+        bsp::DebugIO::Write("[debug] multirate %d partials at fs/2 or fs/4\n\r",
+                            bass_.GetNumDecimatedPartials());
+        bsp::DebugIO::Write("[debug] fx %s %d %s %d %s %d %s %d cycles per block\n\r",
+                            dsp::EffectChain::kEffectNames[0], effectCycleCounters[0],
+                            dsp::EffectChain::kEffectNames[1], effectCycleCounters[1],
+                            dsp::EffectChain::kEffectNames[2], effectCycleCounters[2],
+                            dsp::EffectChain::kEffectNames[3], effectCycleCounters[3]);
+        bsp::DebugIO::Write("[debug] distortion %s oversample %d cycles per sample\n\r",
+                            bass_.GetParams().distortion.oversample.GetName(dsp::kOversampleNames),
+                            effectCycleCounters[dsp::EffectChain::kDistortion] / bsp::PCM5102::kBlockSize);
+        bsp::DebugIO::Write("[debug] audio-rate %s %d %s %d %s %d cycles per block\n\r",
+                            dsp::kAudioRateTargetNames[0], audioRateCycleCounters[0],
+                            dsp::kAudioRateTargetNames[1], audioRateCycleCounters[1],
+                            dsp::kAudioRateTargetNames[2], audioRateCycleCounters[2]);
         vTaskDelay(pdMS_TO_TICKS(5000));
     }
 }
@@ -104,10 +168,42 @@ static void UsbTask(void*) {
     for (;;) {
         bsp::USBMidi::WaitForNextBlock();
 
-        xSemaphoreTake(audioLockHandle_, portMAX_DELAY);
+        /* 音符改变音符栈, 需要音频锁, 控制器, 触后和弯音只写原子变量, 不持有锁
+         * 实时消息带上USB中断里记录的到达时间放进队列, 一个USB包里的消息时间相同, 抖动由MidiClock滤掉
+         */
+        bool locked = false;
         for (auto* e = bsp::USBMidi::GetNextEvent();
              e != nullptr;
              e = bsp::USBMidi::GetNextEvent()) {
+            if (e->IsRealtime()) {
+                bass_.MidiRealtime(e->GetStatus(), 0, e->cycles);
+                continue;
+            }
+            if (e->IsSongPosition()) {
+                bass_.MidiRealtime(e->GetStatus(), e->GetSongPosition(), e->cycles);
+                continue;
+            }
+            if (e->IsControlChange()) {
+                bass_.ControlChange(e->GetController(), e->GetControllerValue());
+                continue;
+            }
+            if (e->IsChannelPressure()) {
+                bass_.ChannelPressure(e->GetChannelPressure());
+                continue;
+            }
+            if (e->IsPolyPressure()) {
+                bass_.PolyPressure(e->GetNote(), e->GetPolyPressure());
+                continue;
+            }
+            if (e->IsPitchBend()) {
+                bass_.SetPitchBend((static_cast<float>(e->GetPitchBend()) - 8192.0f) / 8192.0f);
+                continue;
+            }
+
+            if (!locked && (e->IsNoteOn() || e->IsNoteOff())) {
+                xSemaphoreTake(audioLockHandle_, portMAX_DELAY);
+                locked = true;
+            }
             if (e->IsNoteOn()) {
                 bass_.NoteOn(e->GetNote(), e->GetVelocity() / 127.0f);
                 bsp::DebugIO::Write("[midi] note on: %d\n\r", e->GetNote());
@@ -117,7 +213,9 @@ static void UsbTask(void*) {
                 bsp::DebugIO::Write("[midi] note off: %d\n\r", e->GetNote());
             }
         }
-        xSemaphoreGive(audioLockHandle_);
+        if (locked) {
+            xSemaphoreGive(audioLockHandle_);
+        }
     }
 }
 
@@ -137,8 +235,11 @@ static void AppMain(void*) {
 
     audioLockHandle_ = xSemaphoreCreateBinaryStatic(&audioLock_);
     xSemaphoreGive(audioLockHandle_);
+    precomputeSemHandle_ = xSemaphoreCreateBinaryStatic(&precomputeSem_);
 
-    xTaskCreateStatic(AudioTask, "audio", std::size(_audioStack), nullptr, 0, _audioStack, &_audioTcb);
+    // 没有时间片轮转, 同优先级时DMA就绪后要等正在运行的任务阻塞, 音频任务高一级, 立即抢占
+    xTaskCreateStatic(AudioTask, "audio", std::size(_audioStack), nullptr, 1, _audioStack, &_audioTcb);
+    xTaskCreateStatic(PrecomputeTask, "precompute", std::size(_precomputeStack), nullptr, 0, _precomputeStack, &_precomputeTcb);
     xTaskCreateStatic(TestTask, "test", std::size(_testStack), nullptr, 0, _testStack, &_testTcb);
     xTaskCreateStatic(BspTask, "control", std::size(_bspStack), nullptr, 0, _bspStack, &_bspTcb);
     xTaskCreateStatic(UsbTask, "usb", std::size(_usbStack), nullptr, 0, _usbStack, &_usbTcb);
@@ -156,6 +257,8 @@ int main()
 {
     MCUInit();
     MCUMemory::SRAM_D1_Init();
+    MCUMemory::_SramD2_Init();
+    MCUMemory::_ItcmRam_Init();
     MCUMemory::DMA_MPU_Init();
     
     bsp::DebugIO{}.Init().SetLed(false, false, false);
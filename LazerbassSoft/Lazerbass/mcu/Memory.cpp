@@ -26,6 +26,9 @@ void MCUMemory::SRAM_D1_Init(void) {
 }
 
 void MCUMemory::_SramD2_Init(void) {
+    __HAL_RCC_D2SRAM1_CLK_ENABLE();
+    __HAL_RCC_D2SRAM2_CLK_ENABLE();
+    __HAL_RCC_D2SRAM3_CLK_ENABLE();
     auto* pstart = &_specify_sramd2_bss_start;
     auto* pend = &_specify_sramd2_bss_end;
     for (auto* p = pstart; p < pend; ++p) *p = 0;
@@ -68,6 +71,28 @@ void MCUMemory::DMA_MPU_Init(void) {
     dmaRegion.Number = MPU_REGION_NUMBER1;
     dmaRegion.Size = MPU_REGION_SIZE_4KB;
     HAL_MPU_ConfigRegion(&dmaRegion);
-    
+
+    // QSPI flash, 整个256M窗口禁止访问, 防止预取读到芯片以外或者擦写中的QSPI
+    MPU_Region_InitTypeDef qspiRegion;
+    qspiRegion.Enable = MPU_REGION_ENABLE;
+    qspiRegion.BaseAddress = 0x90000000;
+    qspiRegion.Size = MPU_REGION_SIZE_256MB;
+    qspiRegion.AccessPermission = MPU_REGION_NO_ACCESS;
+    qspiRegion.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    qspiRegion.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    qspiRegion.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    qspiRegion.Number = MPU_REGION_NUMBER2;
+    qspiRegion.TypeExtField = MPU_TEX_LEVEL0;
+    qspiRegion.SubRegionDisable = 0x00;
+    qspiRegion.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    HAL_MPU_ConfigRegion(&qspiRegion);
+
+    // 芯片的8M只读, 不缓存, 擦写后不需要维护D-cache
+    qspiRegion.Size = MPU_REGION_SIZE_8MB;
+    qspiRegion.AccessPermission = MPU_REGION_PRIV_RO_URO;
+    qspiRegion.TypeExtField = MPU_TEX_LEVEL1;
+    qspiRegion.Number = MPU_REGION_NUMBER3;
+    HAL_MPU_ConfigRegion(&qspiRegion);
+
     HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
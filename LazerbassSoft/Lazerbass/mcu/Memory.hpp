@@ -5,6 +5,9 @@
 #define _BSS_SRAMD3 __attribute__ ((section (".sramd3.zero")))
 #define _CODE_ITCM __attribute__ ((section (".itcmram.code")))
 
+// 音频渲染的热数据, 放在DTCM开头, 大小受链接脚本的_Dtcm_Hot_Budget限制
+#define _BSS_DTCM __attribute__ ((section (".bss.dtcm_hot")))
+
 #define _DATA_SRAMD1 __attribute__ ((section (".sramd1.nonzero")))
 #define _DATA_SRAMD2 __attribute__ ((section (".sramd2.nonzero")))
 #define _DATA_SRAMD3 __attribute__ ((section (".sramd3.nonzero")))
@@ -0,0 +1,80 @@
+#ifndef STM32H750xx
+#include "FilePresetStore.hpp"
+#include <cstdio>
+
+namespace preset {
+
+std::string FilePresetStore::GetPath(uint32_t slot) const {
+    char name[16];
+    std::snprintf(name, sizeof(name), "/slot%02u.lzbp", static_cast<unsigned>(slot));
+    return dir_ + name;
+}
+
+bool FilePresetStore::Mount() {
+    for (uint32_t slot = 0; slot < kNumSlots; ++slot) {
+        sizes_[slot] = 0;
+        std::FILE* file = std::fopen(GetPath(slot).c_str(), "rb");
+        if (file == nullptr) {
+            continue;
+        }
+        if (std::fseek(file, 0, SEEK_END) == 0) {
+            long size = std::ftell(file);
+            sizes_[slot] = size > 0 ? static_cast<uint32_t>(size) : 0;
+        }
+        std::fclose(file);
+    }
+    return true;
+}
+
+uint32_t FilePresetStore::GetSize(uint32_t slot) const {
+    return slot < kNumSlots ? sizes_[slot] : 0;
+}
+
+uint32_t FilePresetStore::Read(uint32_t slot, std::span<uint8_t> out) {
+    const uint32_t size = GetSize(slot);
+    if (size == 0 || out.size() < size) {
+        return 0;
+    }
+    std::FILE* file = std::fopen(GetPath(slot).c_str(), "rb");
+    if (file == nullptr) {
+        return 0;
+    }
+    const size_t read = std::fread(out.data(), 1, size, file);
+    std::fclose(file);
+    return read == size ? size : 0;
+}
+
+bool FilePresetStore::Write(uint32_t slot, std::span<const uint8_t> data) {
+    if (slot >= kNumSlots) {
+        return false;
+    }
+    if (data.empty()) {
+        return Erase(slot);
+    }
+
+    const std::string path = GetPath(slot);
+    const std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (std::fclose(file) != 0 || !written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    sizes_[slot] = static_cast<uint32_t>(data.size());
+    return true;
+}
+
+bool FilePresetStore::Erase(uint32_t slot) {
+    if (slot >= kNumSlots) {
+        return false;
+    }
+    std::remove(GetPath(slot).c_str());
+    sizes_[slot] = 0;
+    return true;
+}
+
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef STM32H750xx
+#include <array>
+#include <string>
+#include "PresetStore.hpp"
+
+namespace preset {
+
+/**
+ * @brief 主机上的存储, 每个槽位一个文件(dir/slotNN.lzbp), 用于调试和在电脑上整理预设
+ *        写入临时文件后改名, 写入中途退出不会损坏原来的文件
+ */
+class FilePresetStore : public PresetStore {
+public:
+    explicit FilePresetStore(std::string dir) : dir_(std::move(dir)) {}
+
+    bool Mount() override;
+    uint32_t GetSize(uint32_t slot) const override;
+    uint32_t Read(uint32_t slot, std::span<uint8_t> out) override;
+    bool Write(uint32_t slot, std::span<const uint8_t> data) override;
+    bool Erase(uint32_t slot) override;
+
+private:
+    std::string GetPath(uint32_t slot) const;
+
+    std::string dir_;
+    std::array<uint32_t, kNumSlots> sizes_{};
+};
+
+}
+#endif
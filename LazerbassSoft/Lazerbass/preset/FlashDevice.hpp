@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+namespace preset {
+
+/**
+ * @brief 按扇区擦除的NOR flash, 可以直接按地址读取(内存映射)
+ *        擦除后是0xff, 每个kProgramUnit在擦除之前只编程一次
+ */
+class FlashDevice {
+public:
+    static constexpr uint32_t kProgramUnit = 32;
+
+    virtual ~FlashDevice() = default;
+
+    virtual const uint8_t* GetBase() const = 0;
+    virtual uint32_t GetSectorSize() const = 0;
+    virtual uint32_t GetNumSectors() const = 0;
+
+    /**
+     * @param offset 相对GetBase(), kProgramUnit对齐
+     * @param data 长度是kProgramUnit的整数倍
+     */
+    virtual bool Program(uint32_t offset, std::span<const uint8_t> data) = 0;
+    virtual bool EraseSector(uint32_t sector) = 0;
+};
+
+}
@@ -0,0 +1,214 @@
+#include "FlashPresetStore.hpp"
+#include <algorithm>
+#include <cstring>
+#include "PresetCodec.hpp"
+
+namespace preset {
+
+static void Store32(uint8_t* p, uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+static uint32_t Load32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static bool IsErased(const uint8_t* p, uint32_t size) {
+    return std::all_of(p, p + size, [](uint8_t b) { return b == 0xff; });
+}
+
+bool FlashPresetStore::ReadSectorHeader(uint32_t sector, uint32_t& generation) const {
+    const uint8_t* p = GetSector(sector);
+    generation = Load32(p + 4);
+    return Load32(p) == kSectorMagic && Load32(p + 8) == ~generation;
+}
+
+bool FlashPresetStore::Mount() {
+    mounted_ = false;
+    const uint32_t numSectors = device_.GetNumSectors();
+    // 压缩时需要放下所有槽位最大的记录和一条新记录
+    const uint32_t worstCase = kHeaderSize + (kNumSlots + 1) * (kHeaderSize + AlignUp(kMaxDataSize));
+    if (numSectors < 2 || device_.GetSectorSize() < worstCase) {
+        return false;
+    }
+
+    bool found = false;
+    for (uint32_t i = 0; i < numSectors; ++i) {
+        uint32_t generation;
+        if (ReadSectorHeader(i, generation) && (!found || generation > generation_)) {
+            found = true;
+            activeSector_ = i;
+            generation_ = generation;
+        }
+    }
+
+    if (!found && !Format(0, 1)) {
+        return false;
+    }
+
+    ScanSector();
+    mounted_ = true;
+    return true;
+}
+
+/* 从头扫描活动扇区, 遇到擦除状态的记录头就是写入位置 */
+void FlashPresetStore::ScanSector() {
+    const uint8_t* sector = GetSector(activeSector_);
+    const uint32_t sectorSize = device_.GetSectorSize();
+    index_.fill({});
+
+    uint32_t offset = kHeaderSize;
+    while (offset + kHeaderSize <= sectorSize) {
+        const uint8_t* header = sector + offset;
+        if (IsErased(header, kHeaderSize)) {
+            break;
+        }
+
+        const uint32_t slot = Load32(header + 4) & 0xffff;
+        const uint32_t length = Load32(header + 8);
+        const uint32_t dataOffset = offset + kHeaderSize;
+        const bool valid = Load32(header) == kRecordMagic
+            && Load32(header + 16) == PresetCodec::Crc32(std::span(header, 16))
+            && slot < kNumSlots
+            && length <= kMaxDataSize
+            && dataOffset + AlignUp(length) <= sectorSize
+            && Load32(header + 12) == PresetCodec::Crc32(std::span(sector + dataOffset, length));
+        if (!valid) {
+            // 写入时掉电, 后面的空间不能再用
+            offset = sectorSize;
+            break;
+        }
+
+        index_[slot] = { dataOffset, length };
+        offset = dataOffset + AlignUp(length);
+    }
+    writeOffset_ = std::min(offset, sectorSize);
+}
+
+bool FlashPresetStore::WriteSectorHeader(uint32_t sector, uint32_t generation) {
+    std::fill(std::begin(word_), std::end(word_), 0xff);
+    Store32(word_, kSectorMagic);
+    Store32(word_ + 4, generation);
+    Store32(word_ + 8, ~generation);
+    return device_.Program(sector * device_.GetSectorSize(), word_);
+}
+
+bool FlashPresetStore::Format(uint32_t sector, uint32_t generation) {
+    if (!device_.EraseSector(sector) || !WriteSectorHeader(sector, generation)) {
+        return false;
+    }
+    activeSector_ = sector;
+    generation_ = generation;
+    return true;
+}
+
+uint32_t FlashPresetStore::GetSize(uint32_t slot) const {
+    return mounted_ && slot < kNumSlots ? index_[slot].length : 0;
+}
+
+uint32_t FlashPresetStore::Read(uint32_t slot, std::span<uint8_t> out) {
+    const uint32_t size = GetSize(slot);
+    if (size == 0 || out.size() < size) {
+        return 0;
+    }
+    std::memcpy(out.data(), GetSector(activeSector_) + index_[slot].offset, size);
+    return size;
+}
+
+bool FlashPresetStore::Write(uint32_t slot, std::span<const uint8_t> data) {
+    if (!mounted_ || slot >= kNumSlots || data.size() > kMaxDataSize) {
+        return false;
+    }
+    return Append(slot, data);
+}
+
+bool FlashPresetStore::Erase(uint32_t slot) {
+    if (!mounted_ || slot >= kNumSlots) {
+        return false;
+    }
+    if (index_[slot].length == 0) {
+        return true;
+    }
+    return Append(slot, {});
+}
+
+bool FlashPresetStore::Append(uint32_t slot, std::span<const uint8_t> data) {
+    const uint32_t need = kHeaderSize + AlignUp(static_cast<uint32_t>(data.size()));
+    if (writeOffset_ + need > device_.GetSectorSize() && !Compact()) {
+        return false;
+    }
+
+    uint32_t offset = writeOffset_;
+    const bool ok = AppendAt(activeSector_, offset, slot, data);
+    // 失败时已经写入的部分无法回收, 跳过
+    writeOffset_ = ok ? offset : device_.GetSectorSize();
+    if (ok) {
+        index_[slot] = { offset - AlignUp(static_cast<uint32_t>(data.size())), static_cast<uint32_t>(data.size()) };
+    }
+    return ok;
+}
+
+/* 先写记录头再写数据, 数据按kProgramUnit复制到对齐的缓冲区 */
+bool FlashPresetStore::AppendAt(uint32_t sector, uint32_t& offset, uint32_t slot, std::span<const uint8_t> data) {
+    const uint32_t base = sector * device_.GetSectorSize();
+    const uint32_t length = static_cast<uint32_t>(data.size());
+
+    std::fill(std::begin(word_), std::end(word_), 0xff);
+    Store32(word_, kRecordMagic);
+    Store32(word_ + 4, slot);
+    Store32(word_ + 8, length);
+    Store32(word_ + 12, PresetCodec::Crc32(data));
+    Store32(word_ + 16, PresetCodec::Crc32(std::span(word_, 16)));
+    if (!device_.Program(base + offset, word_)) {
+        return false;
+    }
+    offset += kHeaderSize;
+
+    for (uint32_t i = 0; i < length; i += FlashDevice::kProgramUnit) {
+        const uint32_t n = std::min(FlashDevice::kProgramUnit, length - i);
+        std::fill(std::begin(word_), std::end(word_), 0xff);
+        std::memcpy(word_, data.data() + i, n);
+        if (!device_.Program(base + offset, word_)) {
+            return false;
+        }
+        offset += FlashDevice::kProgramUnit;
+    }
+    return true;
+}
+
+/* 把每个槽位最新的记录复制到下一个扇区, 最后写扇区头使它生效 */
+bool FlashPresetStore::Compact() {
+    const uint32_t target = (activeSector_ + 1) % device_.GetNumSectors();
+    const uint32_t generation = generation_ + 1;
+    if (!device_.EraseSector(target)) {
+        return false;
+    }
+
+    const uint8_t* source = GetSector(activeSector_);
+    std::array<SlotIndex, kNumSlots> newIndex{};
+    uint32_t offset = kHeaderSize;
+    for (uint32_t slot = 0; slot < kNumSlots; ++slot) {
+        const auto& entry = index_[slot];
+        if (entry.length == 0) {
+            continue;
+        }
+        if (!AppendAt(target, offset, slot, std::span(source + entry.offset, entry.length))) {
+            return false;
+        }
+        newIndex[slot] = { offset - AlignUp(entry.length), entry.length };
+    }
+
+    if (!WriteSectorHeader(target, generation)) {
+        return false;
+    }
+
+    activeSector_ = target;
+    generation_ = generation;
+    writeOffset_ = offset;
+    index_ = newIndex;
+    return true;
+}
+
+}
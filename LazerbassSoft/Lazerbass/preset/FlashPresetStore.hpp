@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include "PresetStore.hpp"
+#include "FlashDevice.hpp"
+
+namespace preset {
+
+/**
+ * @brief 日志结构的flash存储
+ *        只有一个活动扇区, 写入总是追加新记录, 同一个槽位后面的记录覆盖前面的, 长度为0的记录表示清空
+ *        活动扇区写满时把每个槽位最新的记录复制到下一个扇区(轮流使用所有扇区, 擦除次数平均),
+ *        新扇区的头最后写, 压缩途中掉电时旧扇区仍然完整
+ *
+ *        扇区头 32字节: magic, generation, ~generation, 其余0xff; generation最大的有效扇区是活动扇区
+ *        记录头 32字节: magic, slot(u16), 保留(u16), length, 数据的crc32, 前16字节的crc32
+ *        数据按kProgramUnit补齐; 记录头或数据校验失败(写入时掉电)时把扇区当作写满, 下次写入时压缩
+ */
+class FlashPresetStore : public PresetStore {
+public:
+    static constexpr uint32_t kSectorMagic = 0x53425a4c; // "LZBS"
+    static constexpr uint32_t kRecordMagic = 0x52425a4c; // "LZBR"
+    static constexpr uint32_t kHeaderSize = FlashDevice::kProgramUnit;
+    static constexpr uint32_t kMaxDataSize = 3072;
+
+    explicit FlashPresetStore(FlashDevice& device) : device_(device) {}
+
+    bool Mount() override;
+    uint32_t GetSize(uint32_t slot) const override;
+    uint32_t Read(uint32_t slot, std::span<uint8_t> out) override;
+    bool Write(uint32_t slot, std::span<const uint8_t> data) override;
+    bool Erase(uint32_t slot) override;
+
+    uint32_t GetActiveSector() const { return activeSector_; }
+    uint32_t GetGeneration() const { return generation_; }
+    uint32_t GetFreeBytes() const { return device_.GetSectorSize() - writeOffset_; }
+
+private:
+    struct SlotIndex {
+        uint32_t offset; // 数据相对扇区开头的偏移
+        uint32_t length;
+    };
+
+    static constexpr uint32_t AlignUp(uint32_t size) {
+        return (size + FlashDevice::kProgramUnit - 1) & ~(FlashDevice::kProgramUnit - 1);
+    }
+
+    const uint8_t* GetSector(uint32_t sector) const {
+        return device_.GetBase() + sector * device_.GetSectorSize();
+    }
+    bool ReadSectorHeader(uint32_t sector, uint32_t& generation) const;
+    void ScanSector();
+    bool Append(uint32_t slot, std::span<const uint8_t> data);
+    bool AppendAt(uint32_t sector, uint32_t& offset, uint32_t slot, std::span<const uint8_t> data);
+    bool Compact();
+    bool WriteSectorHeader(uint32_t sector, uint32_t generation);
+    bool Format(uint32_t sector, uint32_t generation);
+
+    FlashDevice& device_;
+    uint32_t activeSector_{};
+    uint32_t generation_{};
+    uint32_t writeOffset_{};
+    bool mounted_{};
+    std::array<SlotIndex, kNumSlots> index_{};
+    alignas(4) uint8_t word_[FlashDevice::kProgramUnit]{};
+};
+
+}
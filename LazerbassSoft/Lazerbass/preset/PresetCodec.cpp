@@ -0,0 +1,443 @@
+#include "PresetCodec.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace preset {
+
+/* 调制器的id, 按ModulatorId的顺序, 改名字会让旧预设的link失效, 只能在末尾添加 */
+static constexpr const char* kModulatorKeys[] = {
+    "lfo1", "lfo2", "lfo3", "lfo4",
+    "ampEnv", "env1", "env2",
+    "modSequence",
+    "macro1", "macro2", "macro3", "macro4",
+    "velocity", "keyTrack", "channelPressure", "polyPressure",
+};
+static_assert(std::size(kModulatorKeys) == static_cast<uint32_t>(dsp::ModulatorId::kCount));
+
+/* crc32(0xedb88320), 按半字节查表 */
+static constexpr auto kCrcTable = [] {
+    std::array<uint32_t, 16> table{};
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t crc = i;
+        for (int32_t j = 0; j < 4; ++j) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+uint32_t PresetCodec::Crc32(std::span<const uint8_t> data) {
+    uint32_t crc = 0xffffffffu;
+    for (uint8_t byte : data) {
+        crc = kCrcTable[(crc ^ byte) & 0xf] ^ (crc >> 4);
+        crc = kCrcTable[(crc ^ (byte >> 4)) & 0xf] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+static void Put16(uint8_t*& p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p += 2;
+}
+
+static void Put32(uint8_t*& p, uint32_t value) {
+    Put16(p, value & 0xffff);
+    Put16(p, value >> 16);
+}
+
+static uint32_t Get16(const uint8_t*& p) {
+    uint32_t value = p[0] | (p[1] << 8);
+    p += 2;
+    return value;
+}
+
+static uint32_t Get32(const uint8_t*& p) {
+    uint32_t low = Get16(p);
+    return low | (Get16(p) << 16);
+}
+
+// --------------------------------------------------------------------------------
+// 参数表
+// --------------------------------------------------------------------------------
+template<class TDesc>
+void PresetCodec::AddParam(uint32_t groupHash, std::string_view key, TDesc& desc) {
+    ParamEntry entry{};
+    entry.id = Hash(key, Hash(".", groupHash));
+    if constexpr (std::is_same_v<TDesc, dsp::BoolParamDesc>) {
+        entry.reg = &desc.value;
+        entry.min = 0;
+        entry.max = 1;
+        entry.defaultValue = desc.defaultValue;
+        entry.kind = ParamKind::kBool;
+    }
+    else {
+        entry.reg = &desc.value;
+        entry.min = desc.min;
+        entry.max = desc.max;
+        entry.defaultValue = desc.defaultValue;
+        entry.kind = ParamKind::kInt;
+        if constexpr (std::is_same_v<TDesc, dsp::FloatParamDesc>) {
+            entry.floatDesc = &desc;
+        }
+    }
+    AddParam(entry);
+}
+
+void PresetCodec::AddParam(ParamEntry entry) {
+    if (numParams_ < kMaxParams) {
+        params_[numParams_++] = entry;
+    }
+}
+
+void PresetCodec::AddModulator(uint32_t id, dsp::ModulatorDesc desc) {
+    modulators_[numModulators_++] = { id, desc };
+}
+
+/* 参数的id是"组.参数"的hash, 名字是这里写死的, 不是界面上显示的名字 */
+void PresetCodec::Init(dsp::Lazerbass& synth) {
+    synth_ = &synth;
+    numParams_ = 0;
+    numModulators_ = 0;
+    auto& p = synth.GetParams();
+
+    AddParam({ .id = Hash("bpm"), .reg = &p.bpm, .floatDesc = nullptr,
+               .min = dsp::Sequencer::kMinBpm, .max = dsp::Sequencer::kMaxBpm, .defaultValue = 120, .kind = ParamKind::kUint });
+
+    uint32_t g = Hash("ratioAdd");
+    AddParam(g, "enable", p.ratioAdd.enable);
+    AddParam(g, "amount", p.ratioAdd.amount);
+    AddParam(g, "pattern", p.ratioAdd.parttern);
+
+    g = Hash("ratioMul");
+    AddParam(g, "enable", p.ratioMul.enable);
+    AddParam(g, "amount", p.ratioMul.amount);
+    AddParam(g, "pattern", p.ratioMul.parttern);
+
+    g = Hash("partialBeating");
+    AddParam(g, "enable", p.partialBeating.enable);
+    AddParam(g, "amount", p.partialBeating.amount);
+    AddParam(g, "pattern", p.partialBeating.parttern);
+
+    g = Hash("dispersion");
+    AddParam(g, "enable", p.dispersion.enable);
+    AddParam(g, "amount", p.dispersion.amount);
+    AddParam(g, "key", p.dispersion.key);
+    AddParam(g, "shape", p.dispersion.shape);
+
+    g = Hash("oscillator");
+    AddParam(g, "type", p.oscillor.type);
+    AddParam(g, "numPartials", p.oscillor.numPartials);
+    AddParam(g, "number", p.oscillor.number);
+    AddParam(g, "transport", p.oscillor.transport);
+    AddParam(g, "pitch", p.oscillor.pitch);
+    AddParam(g, "fundamental", p.oscillor.fundamental);
+    AddParam(g, "beating", p.oscillor.beating);
+    AddParam(g, "pulseWidth", p.oscillor.pluseWidth);
+
+    g = Hash("attenuation");
+    AddParam(g, "enable", p.attenuation.enable);
+    AddParam(g, "balance", p.attenuation.balance);
+    AddParam(g, "pattern", p.attenuation.parttern);
+    AddParam(g, "symmetry", p.attenuation.symmetry);
+
+    g = Hash("oscPhase");
+    AddParam(g, "enable", p.oscPhase.enable);
+    AddParam(g, "random", p.oscPhase.random);
+    AddParam(g, "pattern", p.oscPhase.parttern);
+    AddParam(g, "symmetry", p.oscPhase.symmetry);
+
+    g = Hash("filter");
+    AddParam(g, "enable", p.filter.enable);
+    AddParam(g, "brightness", p.filter.brightness);
+    AddParam(g, "key", p.filter.key);
+    AddParam(g, "floor", p.filter.floor);
+
+    g = Hash("periodFilter");
+    AddParam(g, "enable", p.periodFilter.enable);
+    AddParam(g, "stretch", p.periodFilter.stretch);
+    AddParam(g, "blocks", p.periodFilter.blocks);
+    AddParam(g, "apply", p.periodFilter.apply);
+    AddParam(g, "peak", p.periodFilter.peak);
+    AddParam(g, "cycle", p.periodFilter.cycle);
+    AddParam(g, "phaseShift", p.periodFilter.phaseShift);
+    AddParam(g, "pinch", p.periodFilter.pinch);
+
+    g = Hash("pan");
+    AddParam(g, "enable", p.pan.enable);
+    AddParam(g, "mode", p.pan.mode);
+    AddParam(g, "width", p.pan.width);
+    AddParam(g, "center", p.pan.center);
+
+    g = Hash("distortion");
+    AddParam(g, "enable", p.distortion.enable);
+    AddParam(g, "drive", p.distortion.drive);
+    AddParam(g, "tone", p.distortion.tone);
+    AddParam(g, "mix", p.distortion.mix);
+    AddParam(g, "oversample", p.distortion.oversample);
+
+    g = Hash("chorus");
+    AddParam(g, "enable", p.chorus.enable);
+    AddParam(g, "rate", p.chorus.rate);
+    AddParam(g, "depth", p.chorus.depth);
+    AddParam(g, "mix", p.chorus.mix);
+
+    g = Hash("delay");
+    AddParam(g, "enable", p.delay.enable);
+    AddParam(g, "time", p.delay.time);
+    AddParam(g, "feedback", p.delay.feedback);
+    AddParam(g, "mix", p.delay.mix);
+
+    g = Hash("reverb");
+    AddParam(g, "enable", p.reverb.enable);
+    AddParam(g, "size", p.reverb.size);
+    AddParam(g, "damping", p.reverb.damping);
+    AddParam(g, "mix", p.reverb.mix);
+
+    g = Hash("voice");
+    AddParam(g, "glide", p.voice.glide);
+    AddParam(g, "time", p.voice.time);
+    AddParam(g, "legato", p.voice.legato);
+    AddParam(g, "bendRange", p.voice.bendRange);
+
+    g = Hash("master");
+    AddParam(g, "volume", p.master.volume);
+
+    g = Hash("macro");
+    AddParam(g, "macro1", p.macro.macro1);
+    AddParam(g, "macro2", p.macro.macro2);
+    AddParam(g, "macro3", p.macro.macro3);
+    AddParam(g, "macro4", p.macro.macro4);
+
+    g = Hash("render");
+    AddParam(g, "smooth", p.render.smooth);
+    AddParam(g, "controlRate", p.render.controlRate);
+    AddParam(g, "schedule", p.render.schedule);
+    AddParam(g, "multirate", p.render.multirate);
+    AddParam(g, "audioPitch", p.render.audioPitch);
+    AddParam(g, "audioBeating", p.render.audioBeating);
+    AddParam(g, "audioPhase", p.render.audioPhase);
+
+    for (auto* lfo : { &p.lfo1, &p.lfo2, &p.lfo3, &p.lfo4 }) {
+        g = Hash(lfo->name);
+        AddParam(g, "bpm", lfo->bpm);
+        AddParam(g, "snap", lfo->snap);
+        AddParam(g, "restart", lfo->restart);
+        AddParam(g, "type", lfo->type);
+        AddParam(g, "rate", lfo->rate);
+        AddParam(g, "times", lfo->times);
+        AddParam(g, "dotTrip", lfo->dotTrip);
+        AddParam(g, "shape", lfo->shape);
+    }
+
+    for (auto* env : { &p.ampEnv, &p.env1, &p.env2 }) {
+        g = Hash(env->name);
+        AddParam(g, "invert", env->invert);
+        AddParam(g, "vca", env->vca);
+        AddParam(g, "mode", env->mode);
+        AddParam(g, "attack", env->attack);
+        AddParam(g, "hold", env->hold);
+        AddParam(g, "decay", env->decay);
+        AddParam(g, "sustain", env->sustain);
+        AddParam(g, "peak", env->peak);
+        AddParam(g, "release", env->release);
+        AddParam(g, "curve", env->curve);
+    }
+
+    std::sort(params_, params_ + numParams_, [](const ParamEntry& a, const ParamEntry& b) { return a.id < b.id; });
+
+    for (uint32_t i = 0; i < std::size(kModulatorKeys); ++i) {
+        AddModulator(Hash(kModulatorKeys[i]), synth.GetModulatorDesc(static_cast<dsp::ModulatorId>(i)));
+    }
+    for (uint32_t cc = 1; cc <= dsp::MidiModulators::kNumControllers; ++cc) {
+        // "cc1" ~ "cc127"
+        char key[5] = { 'c', 'c' };
+        uint32_t len = 2;
+        if (cc >= 100) {
+            key[len++] = static_cast<char>('0' + cc / 100);
+        }
+        if (cc >= 10) {
+            key[len++] = static_cast<char>('0' + cc / 10 % 10);
+        }
+        key[len++] = static_cast<char>('0' + cc % 10);
+        AddModulator(Hash(std::string_view(key, len)), synth.GetControllerModulatorDesc(cc));
+    }
+    std::sort(modulators_, modulators_ + numModulators_, [](const ModulatorEntry& a, const ModulatorEntry& b) { return a.id < b.id; });
+}
+
+const PresetCodec::ParamEntry* PresetCodec::FindParam(uint32_t id) const {
+    auto* end = params_ + numParams_;
+    auto* it = std::lower_bound(params_, end, id, [](const ParamEntry& e, uint32_t id) { return e.id < id; });
+    return it != end && it->id == id ? it : nullptr;
+}
+
+const PresetCodec::ParamEntry* PresetCodec::FindParam(const dsp::FloatParamDesc* desc) const {
+    auto* end = params_ + numParams_;
+    auto* it = std::find_if(params_, end, [desc](const ParamEntry& e) { return e.floatDesc == desc; });
+    return it != end ? it : nullptr;
+}
+
+const PresetCodec::ModulatorEntry* PresetCodec::FindModulator(uint32_t id) const {
+    auto* end = modulators_ + numModulators_;
+    auto* it = std::lower_bound(modulators_, end, id, [](const ModulatorEntry& e, uint32_t id) { return e.id < id; });
+    return it != end && it->id == id ? it : nullptr;
+}
+
+const PresetCodec::ModulatorEntry* PresetCodec::FindModulator(const float* outputReg) const {
+    auto* end = modulators_ + numModulators_;
+    auto* it = std::find_if(modulators_, end, [outputReg](const ModulatorEntry& e) { return e.desc.outputReg == outputReg; });
+    return it != end ? it : nullptr;
+}
+
+int32_t PresetCodec::ReadValue(const ParamEntry& entry) {
+    switch (entry.kind) {
+    case ParamKind::kBool:
+        return *static_cast<const bool*>(entry.reg) ? 1 : 0;
+    case ParamKind::kUint:
+        return static_cast<int32_t>(*static_cast<const uint32_t*>(entry.reg));
+    default:
+        return *static_cast<const int32_t*>(entry.reg);
+    }
+}
+
+// --------------------------------------------------------------------------------
+// 编码和解码
+// --------------------------------------------------------------------------------
+static int16_t QuantizeLink(float value) {
+    return static_cast<int16_t>(std::clamp(std::lround(value * PresetCodec::kLinkScale), -32767l, 32767l));
+}
+
+void PresetCodec::Capture() {
+    const auto& sequencer = synth_->GetSequencer();
+    for (uint32_t i = 0; i < numParams_; ++i) {
+        const auto& entry = params_[i];
+        captured_[i] = entry.floatDesc != nullptr ? sequencer.GetBaseValue(*entry.floatDesc) : ReadValue(entry);
+    }
+}
+
+uint32_t PresetCodec::Encode(std::span<uint8_t> out) const {
+    auto links = synth_->GetModulationBank().GetLinks();
+    const uint32_t size = kHeaderSize + numParams_ * kValueSize + static_cast<uint32_t>(links.size()) * kLinkSize;
+    if (out.size() < size) {
+        return 0;
+    }
+
+    uint8_t* p = out.data() + kHeaderSize;
+    for (uint32_t i = 0; i < numParams_; ++i) {
+        Put32(p, params_[i].id);
+        Put32(p, static_cast<uint32_t>(captured_[i]));
+    }
+
+    uint32_t numLinks = 0;
+    for (const auto* link : links) {
+        const auto* source = FindModulator(link->sourceModulator.outputReg);
+        const auto* target = FindParam(link->targetParam);
+        if (source == nullptr || target == nullptr) {
+            continue;
+        }
+        Put32(p, source->id);
+        Put32(p, target->id);
+        Put16(p, static_cast<uint16_t>(QuantizeLink(link->amount)));
+        Put16(p, static_cast<uint16_t>(QuantizeLink(link->offset)));
+        *p++ = static_cast<uint8_t>((link->enable ? 1 : 0) | (link->symmetric ? 2 : 0));
+        *p++ = static_cast<uint8_t>(link->curve);
+        ++numLinks;
+    }
+
+    const uint32_t used = static_cast<uint32_t>(p - out.data());
+    uint8_t* h = out.data();
+    Put32(h, kMagic);
+    Put16(h, kVersion);
+    Put16(h, numParams_);
+    Put16(h, numLinks);
+    Put16(h, 0);
+    Put32(h, Crc32(std::span(out.data() + kHeaderSize, used - kHeaderSize)));
+    return used;
+}
+
+/* 先全部恢复默认值, 再覆盖预设里有的; 不认识的id和找不到的调制器跳过 */
+PresetCodec::Result PresetCodec::Decode(std::span<const uint8_t> data) {
+    if (data.size() < kHeaderSize) {
+        return Result::kTooShort;
+    }
+
+    const uint8_t* p = data.data();
+    if (Get32(p) != kMagic) {
+        return Result::kBadMagic;
+    }
+    if (Get16(p) > kVersion) {
+        return Result::kNewerVersion;
+    }
+    const uint32_t numValues = Get16(p);
+    const uint32_t numLinks = Get16(p);
+    Get16(p);
+    const uint32_t crc = Get32(p);
+    const uint32_t size = kHeaderSize + numValues * kValueSize + numLinks * kLinkSize;
+    if (data.size() < size) {
+        return Result::kTooShort;
+    }
+    if (Crc32(data.subspan(kHeaderSize, size - kHeaderSize)) != crc) {
+        return Result::kBadCrc;
+    }
+
+    numSkipped_ = 0;
+    for (uint32_t i = 0; i < numParams_; ++i) {
+        staged_[i] = params_[i].defaultValue;
+    }
+    for (uint32_t i = 0; i < numValues; ++i) {
+        const uint32_t id = Get32(p);
+        const auto value = static_cast<int32_t>(Get32(p));
+        const auto* entry = FindParam(id);
+        if (entry == nullptr) {
+            ++numSkipped_;
+            continue;
+        }
+        staged_[entry - params_] = std::clamp(value, entry->min, entry->max);
+    }
+
+    numStagedLinks_ = 0;
+    for (uint32_t i = 0; i < numLinks; ++i) {
+        const auto* source = FindModulator(Get32(p));
+        const auto* target = FindParam(Get32(p));
+        const auto amount = static_cast<int16_t>(Get16(p));
+        const auto offset = static_cast<int16_t>(Get16(p));
+        const uint8_t flags = *p++;
+        const uint8_t curve = *p++;
+        if (source == nullptr || target == nullptr || target->floatDesc == nullptr || numStagedLinks_ >= kMaxLinks) {
+            ++numSkipped_;
+            continue;
+        }
+        auto& link = stagedLinks_[numStagedLinks_++];
+        link.enable = flags & 1;
+        link.symmetric = flags & 2;
+        link.amount = amount / kLinkScale;
+        link.offset = offset / kLinkScale;
+        link.curve = curve < static_cast<uint8_t>(dsp::ModulationCurve::kCount) ? static_cast<dsp::ModulationCurve>(curve) : dsp::ModulationCurve::kLinear;
+        link.sourceModulator = source->desc;
+        link.targetParam = target->floatDesc;
+    }
+    return Result::kOk;
+}
+
+void PresetCodec::Apply() {
+    for (uint32_t i = 0; i < numParams_; ++i) {
+        const auto& entry = params_[i];
+        switch (entry.kind) {
+        case ParamKind::kBool:
+            *static_cast<bool*>(entry.reg) = staged_[i] != 0;
+            break;
+        case ParamKind::kUint:
+            *static_cast<uint32_t*>(entry.reg) = static_cast<uint32_t>(staged_[i]);
+            break;
+        default:
+            *static_cast<int32_t*>(entry.reg) = staged_[i];
+            break;
+        }
+    }
+    synth_->GetModulationBank().LoadLinks(std::span(stagedLinks_, numStagedLinks_));
+    // 锁之前的值属于旧的预设, 下一步恢复时会覆盖刚加载的值
+    synth_->GetSequencer().DropLocks();
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "dsp/Lazerbass.hpp"
+
+namespace preset {
+
+/**
+ * @brief 预设的二进制格式, 小端, 所有参数的值和调制link
+ *        参数和调制器用稳定的id(名字的FNV-1a)保存, 不保存指针, 增删参数后旧的预设仍然可以读取:
+ *        不认识的id跳过, 预设里没有的参数用默认值
+ *
+ *        header  16字节: magic, version(u16), numValues(u16), numLinks(u16), 保留(u16), payload的crc32
+ *        value    8字节: id(u32), value(i32)
+ *        link    14字节: source id(u32), target id(u32), amount(i16), offset(i16), flags(u8), curve(u8)
+ *                        amount和offset的单位是1/kLinkScale, flags: bit0 enable, bit1 symmetric
+ *
+ *        加载分两步: Decode在GUI任务中把数据解码到暂存区(按id查表, 限制范围),
+ *        Apply持有音频锁时只是复制暂存区, 可以在两个音频block之间完成
+ */
+class PresetCodec {
+public:
+    static constexpr uint32_t kMagic = 0x50425a4c; // "LZBP"
+    static constexpr uint16_t kVersion = 1;
+    static constexpr uint32_t kHeaderSize = 16;
+    static constexpr uint32_t kValueSize = 8;
+    static constexpr uint32_t kLinkSize = 14;
+    static constexpr float kLinkScale = 10000.0f;
+    static constexpr uint32_t kMaxParams = 160;
+    static constexpr uint32_t kMaxLinks = dsp::ModulationBank::kMaxNumModulations;
+    static constexpr uint32_t kMaxSize = kHeaderSize + kMaxParams * kValueSize + kMaxLinks * kLinkSize;
+
+    enum class Result {
+        kOk = 0,
+        kTooShort,
+        kBadMagic,
+        kNewerVersion,
+        kBadCrc,
+        kCount
+    };
+    static constexpr const char* kResultNames[] = { "ok", "too short", "not a preset", "newer version", "crc error" };
+
+    /**
+     * @brief 建立id到参数和调制器的表, 在使用其他函数之前调用一次
+     */
+    void Init(dsp::Lazerbass& synth);
+
+    /**
+     * @brief 复制现在的参数值, 被音序器参数锁改写的参数取锁之前的值, 持有音频锁时调用
+     */
+    void Capture();
+
+    /**
+     * @brief 编码Capture复制的参数值和现在的link, 在编辑link的任务中调用
+     * @return 写入的字节数, 缓冲区不够时返回0
+     */
+    uint32_t Encode(std::span<uint8_t> out) const;
+
+    /**
+     * @brief 解码到暂存区, 不改变合成器
+     */
+    Result Decode(std::span<const uint8_t> data);
+
+    /**
+     * @brief 把暂存区写到合成器, 丢掉音序器等待恢复的锁, 持有音频锁时调用
+     */
+    void Apply();
+
+    uint32_t GetNumParams() const { return numParams_; }
+    uint32_t GetNumModulators() const { return numModulators_; }
+    uint32_t GetNumDecodedLinks() const { return numStagedLinks_; }
+    uint32_t GetNumSkipped() const { return numSkipped_; }
+
+    static constexpr uint32_t Hash(std::string_view str, uint32_t hash = 2166136261u) {
+        for (char c : str) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+    static uint32_t Crc32(std::span<const uint8_t> data);
+
+private:
+    enum class ParamKind : uint8_t {
+        kInt = 0,   // Int/Float/EnumParamDesc的value
+        kBool,
+        kUint
+    };
+
+    struct ParamEntry {
+        uint32_t id;
+        void* reg;
+        dsp::FloatParamDesc* floatDesc; // 可以作为调制目标的参数
+        int32_t min;
+        int32_t max;
+        int32_t defaultValue;
+        ParamKind kind;
+    };
+
+    struct ModulatorEntry {
+        uint32_t id;
+        dsp::ModulatorDesc desc;
+    };
+
+    template<class TDesc>
+    void AddParam(uint32_t groupHash, std::string_view key, TDesc& desc);
+    void AddParam(ParamEntry entry);
+    void AddModulator(uint32_t id, dsp::ModulatorDesc desc);
+
+    const ParamEntry* FindParam(uint32_t id) const;
+    const ParamEntry* FindParam(const dsp::FloatParamDesc* desc) const;
+    const ModulatorEntry* FindModulator(uint32_t id) const;
+    const ModulatorEntry* FindModulator(const float* outputReg) const;
+    static int32_t ReadValue(const ParamEntry& entry);
+
+    dsp::Lazerbass* synth_{};
+
+    // 按id排序, 二分查找
+    ParamEntry params_[kMaxParams]{};
+    uint32_t numParams_{};
+    ModulatorEntry modulators_[static_cast<uint32_t>(dsp::ModulatorId::kCount) + dsp::MidiModulators::kNumControllers]{};
+    uint32_t numModulators_{};
+
+    // 保存时复制的值, 和params_一一对应
+    int32_t captured_[kMaxParams]{};
+
+    // 暂存区, 和params_一一对应
+    int32_t staged_[kMaxParams]{};
+    dsp::ModulationLink stagedLinks_[kMaxLinks]{};
+    uint32_t numStagedLinks_{};
+    uint32_t numSkipped_{};
+};
+
+}
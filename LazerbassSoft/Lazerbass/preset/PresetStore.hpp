@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+namespace preset {
+
+/**
+ * @brief 预设的存储, 按槽位保存编码后的数据, 不关心内容
+ */
+class PresetStore {
+public:
+    static constexpr uint32_t kNumSlots = 32;
+
+    virtual ~PresetStore() = default;
+
+    /**
+     * @brief 扫描存储建立索引, 在使用其他函数之前调用
+     * @return 存储不可用时返回false
+     */
+    virtual bool Mount() = 0;
+
+    /**
+     * @return 槽位的数据大小, 空的槽位返回0
+     */
+    virtual uint32_t GetSize(uint32_t slot) const = 0;
+
+    /**
+     * @brief 读取槽位的数据
+     * @return 读取的字节数, 空的槽位或缓冲区不够时返回0
+     */
+    virtual uint32_t Read(uint32_t slot, std::span<uint8_t> out) = 0;
+
+    /**
+     * @brief 写入槽位, 覆盖原来的数据
+     */
+    virtual bool Write(uint32_t slot, std::span<const uint8_t> data) = 0;
+
+    /**
+     * @brief 清空槽位
+     */
+    virtual bool Erase(uint32_t slot) = 0;
+};
+
+}
@@ -0,0 +1,168 @@
+/**
+ * 包络每一段的时间在各种控制频率下都要和参数一致
+ * 按Tick运行和逐采样运行, 跳过Tick再补上, 中途改变控制频率, 结果都不能差超过两个Tick
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "dsp/Envelope.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kUpdateRates[] { 100, 200, 1000, 2000 };
+static constexpr float kMaxTime = 20.0f;
+static constexpr float kRelativeError = 0.01f;
+
+enum class RunMode { kTick, kPerSample, kSkip };
+
+/* 每一段结束的时刻(秒), 没有到达时为kMaxTime */
+struct Timing {
+    float attackEnd{ kMaxTime };
+    float holdEnd{ kMaxTime };
+    float decayEnd{ kMaxTime };
+    float releaseEnd{ kMaxTime };
+};
+
+struct Config {
+    EnvelopeMode mode;
+    RunMode run;
+    uint32_t updateRate;
+    float switchTime{ kMaxTime }; // 这个时刻把控制频率改成switchRate
+    uint32_t switchRate{};
+};
+
+static constexpr uint32_t kSkipTicks = 7; // 每次Tick之前跳过的Tick数
+
+static void SetupParams(SynthParams::EnvParamDesc& env, EnvelopeMode mode) {
+    env.mode.value = static_cast<int32_t>(mode);
+    env.peak.value = 8000;
+    env.attack.value = 5000;  // 约1.0秒
+    env.hold.value = 4000;    // 约0.6秒
+    env.decay.value = 6000;   // 约1.6秒
+    env.sustain.value = 0;    // decay从peak走到0, 时间就是参数的时间
+    env.release.value = 3000; // 约0.35秒
+}
+
+static Timing Run(const Config& config) {
+    SynthParams params;
+    auto& envParams = params.ampEnv;
+    SetupParams(envParams, config.mode);
+    const float peak = envParams.peak.Get();
+
+    Envelope env(envParams, params);
+    uint32_t updateRate = config.updateRate;
+    env.Init(kSampleRate, updateRate);
+    env.SetPerSample(config.run == RunMode::kPerSample);
+    env.GotoAttackState();
+
+    static float gains[kSampleRate];
+    Timing timing;
+    float time = 0.0f;
+    uint32_t tickCount = 0;
+    bool switched = false;
+    float lastOut = 0.0f;
+    while (time < kMaxTime) {
+        if (!switched && time >= config.switchTime) {
+            switched = true;
+            updateRate = config.switchRate;
+            env.SetUpdateRate(kSampleRate, updateRate);
+        }
+
+        ++tickCount;
+        time += 1.0f / updateRate;
+        float maxOut = 0.0f;
+        if (config.run == RunMode::kPerSample) {
+            uint32_t numSamples = kSampleRate / updateRate;
+            env.Render(gains, numSamples);
+            maxOut = *std::max_element(gains, gains + numSamples);
+        }
+        else if (config.run == RunMode::kSkip && tickCount % (kSkipTicks + 1) != 0) {
+            env.Skip();
+            continue;
+        }
+        else {
+            env.Tick();
+        }
+
+        // AR模式到达peak之后马上release, 逐采样时看整个block, 跳过Tick时看有没有开始下降
+        float out = *env.GetOutputReg();
+        maxOut = std::max(maxOut, out);
+        if (timing.attackEnd == kMaxTime) {
+            if (maxOut >= peak || out < lastOut) {
+                timing.attackEnd = time;
+            }
+            lastOut = out;
+        }
+        else if (config.mode == EnvelopeMode::kAR) {
+            if (env.IsIdle()) {
+                timing.releaseEnd = time;
+                break;
+            }
+        }
+        else if (timing.holdEnd == kMaxTime) {
+            if (out < peak) {
+                timing.holdEnd = time;
+            }
+        }
+        else if (out <= 0.0f) {
+            timing.decayEnd = time;
+            break;
+        }
+    }
+    return timing;
+}
+
+static int numFailed = 0;
+
+static void Check(const char* name, const Config& config, float measured, float expected) {
+    // 跳过Tick时只能在补上的那个Tick看到输出, 两端各差kSkipTicks + 1个Tick
+    float numTicks = config.run == RunMode::kSkip ? 2.0f + kSkipTicks + 1 : 2.0f;
+    uint32_t minRate = std::min(config.updateRate, config.switchRate ? config.switchRate : config.updateRate);
+    float tolerance = numTicks / minRate + expected * kRelativeError;
+    if (std::abs(measured - expected) > tolerance) {
+        std::printf("FAIL %-7s ctrl %4u run %d switch %4u: measured %.4fs expected %.4fs\n",
+                    name, config.updateRate, static_cast<int>(config.run), config.switchRate, measured, expected);
+        ++numFailed;
+    }
+}
+
+int main() {
+    SynthParams params;
+    SetupParams(params.ampEnv, EnvelopeMode::kAHDSR);
+    const float attack = SynthParams::EnvVal01ToTime(params.ampEnv.attack.Get());
+    const float hold = SynthParams::EnvVal01ToTime(params.ampEnv.hold.Get());
+    const float decay = SynthParams::EnvVal01ToTime(params.ampEnv.decay.Get());
+    const float release = SynthParams::EnvVal01ToTime(params.ampEnv.release.Get());
+
+    uint32_t numChecked = 0;
+    for (uint32_t rate : kUpdateRates) {
+        for (auto run : { RunMode::kTick, RunMode::kPerSample, RunMode::kSkip }) {
+            Config ar{ EnvelopeMode::kAR, run, rate };
+            Timing t = Run(ar);
+            Check("attack", ar, t.attackEnd, attack);
+            Check("release", ar, t.releaseEnd - t.attackEnd, release);
+
+            Config ahdsr{ EnvelopeMode::kAHDSR, run, rate };
+            t = Run(ahdsr);
+            Check("attack", ahdsr, t.attackEnd, attack);
+            Check("hold", ahdsr, t.holdEnd - t.attackEnd, hold);
+            Check("decay", ahdsr, t.decayEnd - t.holdEnd, decay);
+
+            // attack中途和hold中途改变控制频率
+            for (uint32_t switchRate : kUpdateRates) {
+                for (float switchTime : { attack * 0.5f, attack + hold * 0.5f }) {
+                    Config sw{ EnvelopeMode::kAHDSR, run, rate, switchTime, switchRate };
+                    t = Run(sw);
+                    Check("attack", sw, t.attackEnd, attack);
+                    Check("hold", sw, t.holdEnd - t.attackEnd, hold);
+                    Check("decay", sw, t.decayEnd - t.holdEnd, decay);
+                    numChecked += 3;
+                }
+            }
+            numChecked += 5;
+        }
+    }
+    std::printf("%u checks, %d failed\n", numChecked, numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/**
+ * FlashPresetStore在内存模拟的flash上随机写入和清空槽位, 每轮在随机的操作处掉电:
+ * 那次编程只写进一半(另一半是乱码), 擦除只擦掉半个扇区, 之后所有操作失败
+ * 重新挂载后其他槽位必须完整, 掉电时正在写的槽位是旧的或新的数据
+ * 模拟的flash检查每个编程单元在擦除之前只编程一次, 不掉电的长时间写入检查各扇区的擦除次数
+ * FilePresetStore在临时目录里做一次写入, 读取和清空
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <vector>
+#include "preset/FilePresetStore.hpp"
+#include "preset/FlashPresetStore.hpp"
+
+using namespace preset;
+
+static constexpr uint32_t kNumRounds = 1000;
+static constexpr uint32_t kMaxOpsPerRound = 2000;
+static constexpr uint32_t kNumWrites = 20000;
+
+static int numFailed = 0;
+
+static void CheckTrue(const char* name, bool value) {
+    std::printf("%s %s\n", value ? "ok  " : "FAIL", name);
+    if (!value) {
+        ++numFailed;
+    }
+}
+
+/* 内存里的NOR flash, 剩余操作数用完时掉电 */
+class RamFlash : public FlashDevice {
+public:
+    static constexpr uint32_t kSectorSize = 128 * 1024;
+    static constexpr uint32_t kNumSectors = 2;
+    static constexpr uint32_t kNumUnits = kSectorSize * kNumSectors / kProgramUnit;
+    static constexpr uint32_t kUnitsPerSector = kSectorSize / kProgramUnit;
+
+    RamFlash() : memory_(kSectorSize * kNumSectors, 0xff), programmed_(kNumUnits) {}
+
+    const uint8_t* GetBase() const override { return memory_.data(); }
+    uint32_t GetSectorSize() const override { return kSectorSize; }
+    uint32_t GetNumSectors() const override { return kNumSectors; }
+
+    bool Program(uint32_t offset, std::span<const uint8_t> data) override {
+        for (uint32_t i = 0; i < data.size(); i += kProgramUnit) {
+            if (PowerCut()) {
+                for (uint32_t k = 0; k < kProgramUnit / 2; ++k) {
+                    memory_[offset + i + k] = data[i + k] ^ 0x5a;
+                }
+                return false;
+            }
+            const uint32_t unit = (offset + i) / kProgramUnit;
+            if (programmed_[unit]) {
+                ++numDoublePrograms_;
+            }
+            programmed_[unit] = true;
+            std::memcpy(&memory_[offset + i], &data[i], kProgramUnit);
+        }
+        return true;
+    }
+
+    bool EraseSector(uint32_t sector) override {
+        const uint32_t size = PowerCut() ? kSectorSize / 2 : kSectorSize;
+        std::fill_n(memory_.begin() + sector * kSectorSize, size, 0xff);
+        std::fill_n(programmed_.begin() + sector * kUnitsPerSector, size / kProgramUnit, false);
+        if (size != kSectorSize) {
+            return false;
+        }
+        ++numErases_[sector];
+        return true;
+    }
+
+    /**
+     * @param numOps 再进行多少次编程单元的写入或扇区擦除后掉电, 负数不掉电
+     */
+    void PowerOn(int32_t numOps) {
+        budget_ = numOps;
+        powerLost_ = false;
+    }
+    bool IsPowerLost() const { return powerLost_; }
+    uint32_t GetNumDoublePrograms() const { return numDoublePrograms_; }
+    uint32_t GetNumErases(uint32_t sector) const { return numErases_[sector]; }
+
+private:
+    bool PowerCut() {
+        if (powerLost_ || budget_ == 0) {
+            powerLost_ = true;
+            return true;
+        }
+        if (budget_ > 0) {
+            --budget_;
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> memory_;
+    std::vector<bool> programmed_;
+    int32_t budget_{ -1 };
+    bool powerLost_{};
+    uint32_t numDoublePrograms_{};
+    uint32_t numErases_[kNumSectors]{};
+};
+
+static std::vector<uint8_t> ReadSlot(PresetStore& store, uint32_t slot) {
+    std::vector<uint8_t> data(store.GetSize(slot));
+    if (!data.empty() && store.Read(slot, data) != data.size()) {
+        data.clear();
+    }
+    return data;
+}
+
+static void TestPowerCuts() {
+    RamFlash flash;
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> expected(PresetStore::kNumSlots);
+    std::vector<uint8_t> data;
+    uint32_t numWrites = 0;
+    bool mounted = true;
+    bool intact = true;
+    bool resolved = true;
+    bool failsOnlyOnCut = true;
+
+    for (uint32_t round = 0; round < kNumRounds && mounted && intact && resolved && failsOnlyOnCut; ++round) {
+        // 上电, 挂载后所有槽位是上一轮结束时的内容
+        flash.PowerOn(-1);
+        FlashPresetStore store(flash);
+        mounted = store.Mount();
+        for (uint32_t slot = 0; slot < PresetStore::kNumSlots && mounted; ++slot) {
+            if (ReadSlot(store, slot) != expected[slot]) {
+                std::printf("round %u: slot %u lost\n", round, slot);
+                intact = false;
+            }
+        }
+
+        // 写到掉电为止, 十分之一的操作是清空
+        flash.PowerOn(std::uniform_int_distribution<int32_t>(1, kMaxOpsPerRound)(rng));
+        uint32_t slot = 0;
+        for (;;) {
+            slot = rng() % PresetStore::kNumSlots;
+            if (rng() % 10 == 0) {
+                data.clear();
+                if (!store.Erase(slot)) {
+                    break;
+                }
+            }
+            else {
+                data.resize(std::uniform_int_distribution<uint32_t>(1, FlashPresetStore::kMaxDataSize)(rng));
+                std::generate(data.begin(), data.end(), [&rng] { return static_cast<uint8_t>(rng()); });
+                if (!store.Write(slot, data)) {
+                    break;
+                }
+                ++numWrites;
+            }
+            expected[slot] = data;
+        }
+        if (!flash.IsPowerLost()) {
+            std::printf("round %u: write failed with power on\n", round);
+            failsOnlyOnCut = false;
+        }
+
+        // 掉电时正在写的槽位
+        flash.PowerOn(-1);
+        FlashPresetStore probe(flash);
+        mounted = probe.Mount();
+        const auto after = ReadSlot(probe, slot);
+        if (after == data) {
+            expected[slot] = data;
+        }
+        else if (after != expected[slot]) {
+            std::printf("round %u: slot %u is neither old nor new\n", round, slot);
+            resolved = false;
+        }
+    }
+
+    std::printf("%u writes, erases per sector %u %u\n", numWrites, flash.GetNumErases(0), flash.GetNumErases(1));
+    CheckTrue("writes fail only on power cut", failsOnlyOnCut);
+    CheckTrue("mount after power cut", mounted);
+    CheckTrue("other slots intact", intact);
+    CheckTrue("interrupted slot old or new", resolved);
+    CheckTrue("each unit programmed once per erase", flash.GetNumDoublePrograms() == 0);
+}
+
+/* 不掉电时压缩轮流使用扇区, 擦除次数最多差1 (掉电打断的压缩会重新擦除同一个扇区) */
+static void TestWear() {
+    RamFlash flash;
+    std::mt19937 rng(2);
+    FlashPresetStore store(flash);
+    store.Mount();
+    std::vector<uint8_t> data(FlashPresetStore::kMaxDataSize);
+    bool written = true;
+    for (uint32_t i = 0; i < kNumWrites && written; ++i) {
+        std::generate(data.begin(), data.end(), [&rng] { return static_cast<uint8_t>(rng()); });
+        written = store.Write(rng() % PresetStore::kNumSlots, data);
+    }
+    const uint32_t erases0 = flash.GetNumErases(0);
+    const uint32_t erases1 = flash.GetNumErases(1);
+    std::printf("%u writes of %u bytes, erases per sector %u %u\n", kNumWrites, FlashPresetStore::kMaxDataSize, erases0, erases1);
+    CheckTrue("endurance writes", written);
+    CheckTrue("sectors wear evenly", std::max(erases0, erases1) - std::min(erases0, erases1) <= 1);
+    CheckTrue("endurance programs once per erase", flash.GetNumDoublePrograms() == 0);
+}
+
+static void TestFileStore() {
+    const auto dir = std::filesystem::temp_directory_path() / "lazerbass_preset_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    const std::vector<uint8_t> data = { 1, 2, 3, 4, 5, 6, 7 };
+    FilePresetStore writer(dir.string());
+    CheckTrue("file mount", writer.Mount());
+    CheckTrue("file write", writer.Write(3, data));
+
+    FilePresetStore reader(dir.string());
+    reader.Mount();
+    CheckTrue("file read", ReadSlot(reader, 3) == data);
+    CheckTrue("file erase", reader.Erase(3));
+
+    FilePresetStore erased(dir.string());
+    erased.Mount();
+    CheckTrue("file erased", erased.GetSize(3) == 0);
+    std::filesystem::remove_all(dir);
+}
+
+int main() {
+    TestPowerCuts();
+    TestWear();
+    TestFileStore();
+    return numFailed == 0 ? 0 : 1;
+}
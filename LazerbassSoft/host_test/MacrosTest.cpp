@@ -0,0 +1,113 @@
+/**
+ * 一个宏驱动四个参数, 每个目标的范围和曲线不同(包括负的范围), 其中一个参数还有LFO的link叠加
+ * 平滑收敛后调制值和闭式解 offset + amount * curve(knob) 比较
+ * 旋钮跳变后第一个Tick的输出是平滑系数, 删除宏的link后参数回到0
+ */
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include "dsp/Lazerbass.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kTickSize = kSampleRate / kUpdateRate;
+static constexpr uint32_t kSettleTicks = kUpdateRate; // 1秒, 远大于平滑的时间常数
+
+static Lazerbass::PartialTable partialTables[Lazerbass::kNumPartialTables];
+static float effectMemory[EffectChain::kArenaSize];
+static int numFailed = 0;
+
+static void Check(const char* name, float value, float expected, float tolerance) {
+    bool ok = std::abs(value - expected) <= tolerance;
+    std::printf("%s %-24s %.6f expected %.6f\n", ok ? "ok  " : "FAIL", name, value, expected);
+    if (!ok) {
+        ++numFailed;
+    }
+}
+
+static float Curve(ModulationCurve curve, float x) {
+    switch (curve) {
+    case ModulationCurve::kExp:
+        return x * x;
+    case ModulationCurve::kLog:
+        return 1.0f - (1.0f - x) * (1.0f - x);
+    case ModulationCurve::kSCurve:
+        return x * x * (3.0f - 2.0f * x);
+    default:
+        return x;
+    }
+}
+
+int main() {
+    auto synth = std::make_unique<Lazerbass>(partialTables, effectMemory);
+    synth->Init(kSampleRate, kUpdateRate);
+    auto& p = synth->GetParams();
+    auto& bank = synth->GetModulationBank();
+    const auto macro = synth->GetModulatorDesc(ModulatorId::kMacro1);
+    const auto lfo = synth->GetModulatorDesc(ModulatorId::kLfo1);
+
+    struct Target {
+        const char* name;
+        FloatParamDesc* param;
+        float from;
+        float to;
+        ModulationCurve curve;
+    };
+    const Target targets[] = {
+        { "brightness", &p.filter.brightness, 0.0f, 0.8f, ModulationCurve::kExp },
+        { "volume", &p.master.volume, 0.0f, -0.5f, ModulationCurve::kLinear },
+        { "chorus mix", &p.chorus.mix, 0.2f, 0.6f, ModulationCurve::kSCurve },
+        { "reverb mix", &p.reverb.mix, -0.3f, 0.3f, ModulationCurve::kLog },
+    };
+    bool exist{};
+    for (const auto& t : targets) {
+        auto* link = bank.AddNewLink(macro, t.param, exist);
+        link->offset = t.from;
+        link->amount = t.to - t.from;
+        link->curve = t.curve;
+    }
+    constexpr float kLfoAmount = 0.1f;
+    bank.AddNewLink(lfo, &p.filter.brightness, exist)->amount = kLfoAmount;
+    bank.Compile();
+
+    StereoSample16 block[kTickSize];
+    auto runTicks = [&](uint32_t numTicks) {
+        for (uint32_t i = 0; i < numTicks; ++i) {
+            synth->Process(std::span<StereoSample16>{ block, kTickSize });
+        }
+    };
+
+    for (float knob : { 0.0f, 0.25f, 0.5f, 1.0f, 0.1f }) {
+        p.macro.macro1.value = static_cast<int32_t>(std::lround(knob * FloatParamDesc::kScale));
+        runTicks(kSettleTicks);
+        for (const auto& t : targets) {
+            float expected = t.from + (t.to - t.from) * Curve(t.curve, knob);
+            if (t.param == &p.filter.brightness) {
+                expected += kLfoAmount * *lfo.outputReg;
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "%.2f %s", knob, t.name);
+            Check(name, t.param->modulationValue, expected, 1e-5f);
+        }
+    }
+
+    // 0跳到1, 一个Tick后输出是平滑系数
+    p.macro.macro1.value = 0;
+    runTicks(kSettleTicks);
+    p.macro.macro1.value = static_cast<int32_t>(FloatParamDesc::kScale);
+    runTicks(1);
+    Check("step after 1 tick", *macro.outputReg, -std::expm1(-1.0f / (Macros::kSmoothTime * kUpdateRate)), 1e-5f);
+
+    bank.RemoveLinkOfModulator(macro);
+    runTicks(1);
+    Check("removed volume", p.master.volume.modulationValue, 0.0f, 0.0f);
+    Check("removed chorus mix", p.chorus.mix.modulationValue, 0.0f, 0.0f);
+    Check("removed reverb mix", p.reverb.mix.modulationValue, 0.0f, 0.0f);
+    Check("removed brightness", p.filter.brightness.modulationValue, kLfoAmount * *lfo.outputReg, 1e-6f);
+
+    return numFailed == 0 ? 0 : 1;
+}
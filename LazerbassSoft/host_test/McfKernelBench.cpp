@@ -0,0 +1,63 @@
+/**
+ * 普通和平滑两种MCF渲染每个采样的开销, 包括Tick的分音计算
+ * 频率保持不变时普通渲染只做正弦递推, 平滑渲染每个采样还要累加增益和系数的斜坡
+ * x86上用rdtsc计数, 其他平台用纳秒
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include "dsp/Lazerbass.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t Now() { return __rdtsc(); }
+static constexpr const char* kUnit = "cycles";
+#else
+static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static constexpr const char* kUnit = "ns";
+#endif
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kBlockSize = 256;
+static constexpr uint32_t kNumBlocks = 2000;
+static constexpr uint32_t kNumRuns = 5;
+
+static dsp::Lazerbass::PartialTable partialTables[dsp::Lazerbass::kNumPartialTables];
+static float effectMemory[dsp::EffectChain::kArenaSize];
+
+static double Run(bool smooth, uint32_t numPartials) {
+    auto synth = std::make_unique<dsp::Lazerbass>(partialTables, effectMemory);
+    synth->Init(kSampleRate, kUpdateRate);
+    auto& params = synth->GetParams();
+    params.oscillor.numPartials.value = static_cast<int32_t>(numPartials);
+    params.render.smooth.value = smooth;
+    params.render.multirate.value = false;
+    synth->NoteOn(36, 1.0f);
+
+    StereoSample16 block[kBlockSize];
+    // 取几次中最快的一次, 减少调度的干扰
+    uint64_t best = UINT64_MAX;
+    for (uint32_t run = 0; run < kNumRuns; ++run) {
+        uint64_t begin = Now();
+        for (uint32_t i = 0; i < kNumBlocks; ++i) {
+            synth->Process(std::span<StereoSample16>{ block, kBlockSize });
+        }
+        best = std::min(best, Now() - begin);
+    }
+    return static_cast<double>(best) / (kNumBlocks * kBlockSize);
+}
+
+int main() {
+    for (uint32_t numPartials : { 64u, 128u, 256u }) {
+        double plain = Run(false, numPartials);
+        double smooth = Run(true, numPartials);
+        std::printf("%3u partials: plain %7.1f, smooth %7.1f %s per sample (%.2fx), %.2f / %.2f per partial\n",
+                    numPartials, plain, smooth, kUnit, smooth / plain, plain / numPartials, smooth / numPartials);
+    }
+    return 0;
+}
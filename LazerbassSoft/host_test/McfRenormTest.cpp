@@ -0,0 +1,80 @@
+/**
+ * MCF长时间运行的振幅漂移
+ * LFO调制dispersion让频率每个Tick都变化, 每秒检查一次所有MCF分音的振幅误差,
+ * 不平滑时误差只来自舍入和频率切换, RenormalizeMcf不工作时5分钟就会超过1e-5;
+ * 平滑模式的系数斜坡在一个Tick内本身带来约5e-5的误差, 只检查不累积
+ * 参数: 每种渲染方式运行的秒数, 默认kDefaultSeconds
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <span>
+#include "dsp/Lazerbass.hpp"
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kMaxBlockSize = dsp::Lazerbass::kMaxBlockSize;
+static constexpr uint32_t kDefaultSeconds = 300;
+
+enum class Mode { kPlain, kSmooth, kMultirate };
+
+static dsp::Lazerbass::PartialTable partialTables[dsp::Lazerbass::kNumPartialTables];
+static float effectMemory[dsp::EffectChain::kArenaSize];
+
+static float Run(Mode mode, uint32_t seconds) {
+    auto synth = std::make_unique<dsp::Lazerbass>(partialTables, effectMemory);
+    synth->Init(kSampleRate, kUpdateRate);
+    auto& params = synth->GetParams();
+    params.oscillor.numPartials.value = 64;
+    params.oscillor.beating.value = 20000;
+    params.dispersion.enable.value = true;
+    params.dispersion.amount.value = 3000;
+    params.render.smooth.value = mode == Mode::kSmooth;
+    params.render.multirate.value = mode == Mode::kMultirate;
+
+    auto& bank = synth->GetModulationBank();
+    bool exist{};
+    auto* link = bank.AddNewLink(synth->GetModulatorDesc(dsp::ModulatorId::kLfo1), &params.dispersion.amount, exist);
+    link->amount = 0.5f;
+    bank.Compile();
+
+    synth->NoteOn(36, 1.0f);
+    // 按Tick分块, 每秒最后一块结束在Tick边界上, 平滑模式的斜坡这时已经走完
+    StereoSample16 block[kMaxBlockSize];
+    float worst = 0.0f;
+    for (uint32_t s = 0; s < seconds; ++s) {
+        uint32_t remain = kSampleRate;
+        while (remain > 0) {
+            uint32_t n = std::min({ synth->GetSamplesToNextTick(), kMaxBlockSize, remain });
+            synth->Process(std::span<StereoSample16>{ block, n });
+            remain -= n;
+        }
+        worst = std::max(worst, synth->GetMcfAmplitudeError());
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : kDefaultSeconds;
+
+    static constexpr struct {
+        Mode mode;
+        const char* name;
+        float maxError;
+    } kModes[] {
+        { Mode::kPlain, "plain", 5e-6f },
+        { Mode::kSmooth, "smooth", 1e-4f },
+        { Mode::kMultirate, "multirate", 5e-6f },
+    };
+    int numFailed = 0;
+    for (auto [mode, name, maxError] : kModes) {
+        float worst = Run(mode, seconds);
+        bool ok = worst < maxError;
+        std::printf("%s %-9s %us worst amplitude error %.2e\n", ok ? "ok  " : "FAIL", name, seconds, worst);
+        if (!ok) {
+            ++numFailed;
+        }
+    }
+    return numFailed == 0 ? 0 : 1;
+}
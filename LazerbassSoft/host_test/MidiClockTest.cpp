@@ -0,0 +1,166 @@
+/**
+ * MidiClock的速度和预测误差, 时间单位是48khz的采样
+ * 到达时间按USB的1ms帧取整(向后0~48个采样的抖动), 起点放在uint32回绕之前
+ * 稳定速度: 锁定后速度误差和预测下一个时钟的误差
+ * 速度渐变: 慢的渐变不失锁, 速度跟上; 快的渐变失锁后重新锁定
+ * 丢时钟: 重新开始估计但保留周期, 一拍后重新锁定
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include "dsp/MidiClock.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kFrameSamples = kSampleRate / 1000; // USB每1ms一帧
+static constexpr uint32_t kStartTime = 0xfff00000u;
+
+static int numFailed = 0;
+
+static void Check(const char* name, float value, float expected, float tolerance) {
+    bool ok = std::abs(value - expected) <= tolerance;
+    std::printf("%s %-28s %.3f expected %.3f\n", ok ? "ok  " : "FAIL", name, value, expected);
+    if (!ok) {
+        ++numFailed;
+    }
+}
+
+static void CheckTrue(const char* name, bool value) {
+    std::printf("%s %s\n", value ? "ok  " : "FAIL", name);
+    if (!value) {
+        ++numFailed;
+    }
+}
+
+/* 理想时间对齐到下一个USB帧 */
+static uint32_t Arrival(double ideal) {
+    return kStartTime + static_cast<uint32_t>(std::ceil(ideal / kFrameSamples)) * kFrameSamples;
+}
+
+static double Period(float bpm) {
+    return 60.0 * kSampleRate / (MidiClock::kClocksPerBeat * bpm);
+}
+
+struct Stats {
+    double sumSquare{};
+    uint32_t count{};
+
+    void Add(double err) {
+        sumSquare += err * err;
+        ++count;
+    }
+    float Rms() const { return count ? static_cast<float>(std::sqrt(sumSquare / count)) : 0.0f; }
+};
+
+/**
+ * @brief 按速度曲线发送时钟, 锁定后统计预测下一个时钟的误差
+ * @param dropEvery 每隔多少个时钟丢一个, 0不丢
+ * @return 锁定后是否一直没有失锁
+ */
+template<class BpmAt>
+static bool Run(MidiClock& clock, uint32_t numClocks, BpmAt bpmAt, uint32_t dropEvery, Stats& pred) {
+    double ideal = 0.0;
+    bool locked = false;
+    bool stayedLocked = true;
+    bool havePred = false;
+    double predicted = 0.0;
+    for (uint32_t i = 0; i < numClocks; ++i) {
+        if (i != 0) {
+            ideal += Period(bpmAt(i));
+        }
+        if (dropEvery != 0 && i % dropEvery == dropEvery - 1) {
+            havePred = false;
+            continue;
+        }
+        const uint32_t time = Arrival(ideal);
+        if (havePred) {
+            pred.Add(static_cast<double>(static_cast<int32_t>(time - kStartTime)) - predicted);
+        }
+        clock.Clock(time);
+        if (locked && !clock.IsLocked() && dropEvery == 0) {
+            stayedLocked = false;
+        }
+        locked = clock.IsLocked();
+        havePred = locked;
+        predicted = static_cast<int32_t>(time - kStartTime) + clock.GetTimeUntil(clock.GetPosition() + 1, time);
+    }
+    return stayedLocked;
+}
+
+int main() {
+    // 稳定速度, 抖动的标准差约14个采样, 预测误差应该接近抖动本身
+    for (float bpm : { 60.0f, 120.0f, 174.0f, 300.0f }) {
+        MidiClock clock;
+        clock.Init(kSampleRate);
+        clock.Start();
+        Stats pred;
+        bool stayedLocked = Run(clock, 64 * MidiClock::kClocksPerBeat, [bpm](uint32_t) { return bpm; }, 0, pred);
+        char name[64];
+        std::snprintf(name, sizeof(name), "steady %.0f bpm", bpm);
+        Check(name, clock.GetBpm(), bpm, bpm * 0.002f);
+        std::snprintf(name, sizeof(name), "steady %.0f pred rms", bpm);
+        Check(name, pred.Rms(), 0.0f, 0.5f * kFrameSamples);
+        std::snprintf(name, sizeof(name), "steady %.0f stays locked", bpm);
+        CheckTrue(name, stayedLocked);
+        CheckTrue("steady position", clock.GetPosition() == 64 * MidiClock::kClocksPerBeat - 1);
+    }
+
+    /* 16拍从120渐变到132, 再保持16拍
+     * 周期每个时钟变化约0.24个采样, 二阶环路的稳态滞后约为变化率/beta, 不到半个周期, 不会失锁
+     */
+    {
+        constexpr uint32_t kRampClocks = 16 * MidiClock::kClocksPerBeat;
+        auto bpmAt = [](uint32_t i) {
+            return i < kRampClocks ? 120.0f + 12.0f * static_cast<float>(i) / kRampClocks : 132.0f;
+        };
+        MidiClock clock;
+        clock.Init(kSampleRate);
+        Stats pred;
+        bool stayedLocked = Run(clock, kRampClocks, bpmAt, 0, pred);
+        CheckTrue("ramp stays locked", stayedLocked);
+        Check("ramp end bpm", clock.GetBpm(), 132.0f, 132.0f * 0.01f);
+        Check("ramp pred rms", pred.Rms(), 0.0f, 5.0f * kFrameSamples);
+
+        clock.Init(kSampleRate);
+        Stats settled;
+        Run(clock, 2 * kRampClocks, bpmAt, 0, settled);
+        Check("ramp settled bpm", clock.GetBpm(), 132.0f, 132.0f * 0.002f);
+    }
+
+    // 4拍从100跳到140, 滞后超过半个周期, 重新开始估计, 结束后一拍内重新锁定
+    {
+        constexpr uint32_t kRampClocks = 4 * MidiClock::kClocksPerBeat;
+        MidiClock clock;
+        clock.Init(kSampleRate);
+        Stats pred;
+        Run(clock, 3 * kRampClocks, [](uint32_t i) {
+            return i < kRampClocks ? 100.0f : i < 2 * kRampClocks ? 100.0f + 40.0f * static_cast<float>(i - kRampClocks) / kRampClocks : 140.0f;
+        }, 0, pred);
+        CheckTrue("fast ramp relocked", clock.IsLocked());
+        Check("fast ramp bpm", clock.GetBpm(), 140.0f, 140.0f * 0.005f);
+    }
+
+    // 每两拍丢一个时钟: 重新开始估计, 周期保留, 之后一拍内重新锁定
+    {
+        constexpr uint32_t kDropEvery = 2 * MidiClock::kClocksPerBeat;
+        MidiClock clock;
+        clock.Init(kSampleRate);
+        Stats pred;
+        Run(clock, 16 * kDropEvery, [](uint32_t) { return 128.0f; }, kDropEvery, pred);
+        Check("dropped bpm", clock.GetBpm(), 128.0f, 128.0f * 0.005f);
+        Check("dropped pred rms", pred.Rms(), 0.0f, 0.5f * kFrameSamples);
+        CheckTrue("dropped relocked", clock.IsLocked());
+
+        // 停止发送时钟, 超过两拍后失锁
+        const uint32_t last = Arrival(16 * kDropEvery * Period(128.0f));
+        const auto beat = static_cast<uint32_t>(Period(128.0f) * MidiClock::kClocksPerBeat);
+        clock.CheckTimeout(last + beat);
+        CheckTrue("timeout keeps lock after 1 beat", clock.IsLocked());
+        clock.CheckTimeout(last + 3 * beat);
+        CheckTrue("timeout unlocks after 3 beats", !clock.IsLocked());
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}
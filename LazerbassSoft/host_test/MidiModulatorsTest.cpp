@@ -0,0 +1,90 @@
+/**
+ * MIDI CC从另一个线程无锁写入, 音频线程的Tick按10ms的时间常数平滑
+ * 一个时间常数(200hz时2个Tick)后到0.632, 12个Tick后超过0.997
+ * 调制矩阵没有读取的CC不更新, 保持0
+ */
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include "dsp/MidiModulators.hpp"
+#include "dsp/ModulationBank.hpp"
+#include "dsp/params.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kLinkedController = 1;
+static constexpr uint32_t kUnlinkedController = 7;
+
+static SynthParams params;
+static ModulationBank bank;
+static MidiModulators midi;
+static int numFailed = 0;
+
+static void Check(const char* name, float value, float expected, float tolerance) {
+    bool ok = std::abs(value - expected) <= tolerance;
+    std::printf("%s %-16s %.4f expected %.4f\n", ok ? "ok  " : "FAIL", name, value, expected);
+    if (!ok) {
+        ++numFailed;
+    }
+}
+
+int main() {
+    midi.Init(kUpdateRate);
+    bool exist{};
+    auto* link = bank.AddNewLink(midi.GetControllerModulatorDesc(kLinkedController), &params.filter.brightness, exist);
+    link->amount = 1.0f;
+    bank.Compile();
+    bank.AcquireMatrix();
+
+    const float* linked = midi.GetControllerModulatorDesc(kLinkedController).outputReg;
+    const float* unlinked = midi.GetControllerModulatorDesc(kUnlinkedController).outputReg;
+
+    std::thread writer([] {
+        midi.ControlChange(kLinkedController, 127);
+        midi.ControlChange(kUnlinkedController, 127);
+    });
+    writer.join();
+
+    constexpr uint32_t kNote = 60;
+    for (uint32_t i = 0; i < 2; ++i) {
+        midi.Tick(bank, kNote);
+    }
+    Check("cc1 2 ticks", *linked, 1.0f - std::exp(-1.0f), 1e-3f);
+    for (uint32_t i = 2; i < 12; ++i) {
+        midi.Tick(bank, kNote);
+    }
+    Check("cc1 12 ticks", *linked, 1.0f - std::exp(-6.0f), 1e-3f);
+    Check("cc7 unlinked", *unlinked, 0.0f, 0.0f);
+
+    // 写入和Tick同时进行, 平滑的输出只能在两个写入值之间
+    std::atomic<bool> started{};
+    std::atomic<bool> stop{};
+    std::thread toggler([&started, &stop] {
+        for (uint32_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            midi.ControlChange(kLinkedController, (i & 1) ? 127 : 0);
+            started.store(true, std::memory_order_relaxed);
+        }
+    });
+    while (!started.load(std::memory_order_relaxed)) {
+    }
+    float lo = 1.0f;
+    float hi = 0.0f;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        midi.Tick(bank, kNote);
+        lo = std::min(lo, *linked);
+        hi = std::max(hi, *linked);
+    }
+    stop.store(true, std::memory_order_relaxed);
+    toggler.join();
+    bool inRange = lo >= 0.0f && hi <= 1.0f;
+    std::printf("%s concurrent range  %.4f ~ %.4f\n", inRange ? "ok  " : "FAIL", lo, hi);
+    if (!inRange) {
+        ++numFailed;
+    }
+    Check("cc7 unlinked", *unlinked, 0.0f, 0.0f);
+
+    return numFailed == 0 ? 0 : 1;
+}
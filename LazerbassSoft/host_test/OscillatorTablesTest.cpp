@@ -0,0 +1,122 @@
+/**
+ * 编译期振荡器表和原来运行时的生成代码逐位比较
+ * 运行时代码取beating=0, transport=0, 此时ratioBeating和oscRatio都是1
+ */
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include "dsp/OscillatorTables.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kNum = kOscillatorTableSize;
+
+struct RuntimeTable {
+    std::array<float, kNum> ratios{};
+    std::array<float, kNum> gains{};
+};
+
+static std::array<float, kNum * 2> sawGainTable;
+
+static RuntimeTable RuntimeFullSaw() {
+    RuntimeTable t;
+    std::copy_n(sawGainTable.cbegin(), kNum, t.gains.begin());
+    float ratioBeating = 1.0f;
+    for (uint32_t i = 0; i < kNum; i += 2) {
+        t.ratios[i] = i + 1.0f;
+        t.ratios[i + 1] = (i + 2.0f) * ratioBeating;
+    }
+    return t;
+}
+
+static RuntimeTable RuntimeDualSaw() {
+    RuntimeTable t;
+    uint32_t partialIdx = 0;
+    float ratioBeating = 1.0f;
+    for (uint32_t i = 0; i < kNum; i += 2) {
+        t.gains[i] = sawGainTable[partialIdx];
+        t.gains[i + 1] = sawGainTable[partialIdx];
+        t.ratios[i] = partialIdx + 1.0f;
+        t.ratios[i + 1] = (partialIdx + 1.0f) * ratioBeating;
+        ++partialIdx;
+    }
+    return t;
+}
+
+static RuntimeTable RuntimeFullSquare() {
+    RuntimeTable t;
+    float ratioBeating = 1.0f;
+    for (uint32_t i = 0; i < kNum; i += 2) {
+        t.gains[i] = sawGainTable[2 * i];
+        t.gains[i + 1] = sawGainTable[2 * i + 3];
+        t.ratios[i] = 2 * i + 1.0f;
+        t.ratios[i + 1] = (2 * i + 3.0f) * ratioBeating;
+    }
+    return t;
+}
+
+static RuntimeTable RuntimeDualSquare() {
+    RuntimeTable t;
+    uint32_t partialIdx = 0;
+    float ratioBeating = 1.0f;
+    for (uint32_t i = 0; i < kNum; i += 2) {
+        t.gains[i] = sawGainTable[partialIdx];
+        t.gains[i + 1] = sawGainTable[partialIdx];
+        t.ratios[i] = partialIdx + 1.0f;
+        t.ratios[i + 1] = (partialIdx + 1.0f) * ratioBeating;
+        partialIdx += 2;
+    }
+    return t;
+}
+
+static RuntimeTable RuntimeMulti(uint32_t numOsc, uint32_t harmonicStep) {
+    RuntimeTable t;
+    float oscRatio = 1.0f;
+    for (uint32_t i = 0; i < numOsc; ++i) {
+        uint32_t partialIdx = 0;
+        for (uint32_t j = i; j < kNum; j += numOsc) {
+            t.gains[j] = sawGainTable[partialIdx];
+            t.ratios[j] = (partialIdx + 1.0f) * oscRatio;
+            partialIdx += harmonicStep;
+        }
+    }
+    return t;
+}
+
+static int numFailed = 0;
+
+static void Compare(const char* name, const OscillatorTable& table, const RuntimeTable& ref) {
+    for (uint32_t i = 0; i < kNum; ++i) {
+        if (table.ratios[i] != ref.ratios[i] || table.gains[i] != ref.gains[i]) {
+            std::printf("FAIL %s[%u]: ratio %g/%g gain %g/%g\n", name, i,
+                        table.ratios[i], ref.ratios[i], table.gains[i], ref.gains[i]);
+            ++numFailed;
+            return;
+        }
+    }
+    std::printf("ok   %s\n", name);
+}
+
+int main() {
+    for (uint32_t i = 0; i < kNum * 2; ++i) {
+        sawGainTable[i] = 1.0f / (1.0f + i);
+        if (kSawGainTable[i] != sawGainTable[i]) {
+            std::printf("FAIL kSawGainTable[%u]\n", i);
+            ++numFailed;
+            break;
+        }
+    }
+
+    Compare("kFullSawTable", kFullSawTable, RuntimeFullSaw());
+    Compare("kDualSawTable", kDualSawTable, RuntimeDualSaw());
+    Compare("kFullSquareTable", kFullSquareTable, RuntimeFullSquare());
+    Compare("kDualSquareTable", kDualSquareTable, RuntimeDualSquare());
+    for (uint32_t numOsc = kMinNumOscs; numOsc <= static_cast<uint32_t>(SynthParams::kMaxNumOscs); ++numOsc) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "kMultiSawTables[%u]", numOsc);
+        Compare(name, kMultiSawTables[numOsc - kMinNumOscs], RuntimeMulti(numOsc, 1));
+        std::snprintf(name, sizeof(name), "kMultiSquareTables[%u]", numOsc);
+        Compare(name, kMultiSquareTables[numOsc - kMinNumOscs], RuntimeMulti(numOsc, 2));
+    }
+    return numFailed == 0 ? 0 : 1;
+}
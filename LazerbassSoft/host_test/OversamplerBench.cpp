@@ -0,0 +1,67 @@
+/**
+ * 失真效果在每种过采样倍数下每个采样的开销
+ * x86上用rdtsc计数, 其他平台用纳秒
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include "dsp/effect/Distortion.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t Now() { return __rdtsc(); }
+static constexpr const char* kUnit = "cycles";
+#else
+static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static constexpr const char* kUnit = "ns";
+#endif
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kBlockSize = 256;
+static constexpr uint32_t kNumBlocks = 4000;
+static constexpr uint32_t kNumRuns = 5;
+
+static dsp::SynthParams params;
+static dsp::Distortion distortion{ params };
+
+int main() {
+    float left[kBlockSize];
+    float right[kBlockSize];
+    float input[kBlockSize];
+    for (uint32_t i = 0; i < kBlockSize; ++i) {
+        input[i] = 0.5f * std::sin(2.0f * std::numbers::pi_v<float> * 5 * i / kBlockSize);
+    }
+
+    params.distortion.enable.value = true;
+    params.distortion.drive.value = params.distortion.drive.max;
+    distortion.Init(kSampleRate);
+
+    double baseline = 0.0;
+    for (auto factor : { dsp::Oversample::kX1, dsp::Oversample::kX2, dsp::Oversample::kX4 }) {
+        params.distortion.oversample.value = static_cast<int32_t>(factor);
+
+        // 取几次中最快的一次, 减少调度的干扰
+        uint64_t best = UINT64_MAX;
+        for (uint32_t run = 0; run < kNumRuns; ++run) {
+            uint64_t begin = Now();
+            for (uint32_t block = 0; block < kNumBlocks; ++block) {
+                std::copy_n(input, kBlockSize, left);
+                std::copy_n(input, kBlockSize, right);
+                distortion.Process(left, right, kBlockSize);
+            }
+            best = std::min(best, Now() - begin);
+        }
+
+        double perSample = static_cast<double>(best) / (kNumBlocks * kBlockSize);
+        if (factor == dsp::Oversample::kX1) {
+            baseline = perSample;
+        }
+        std::printf("distortion %s: %6.1f %s per stereo sample (%.2fx of 1x)\n",
+                    dsp::kOversampleNames[static_cast<int32_t>(factor)], perSample, kUnit, perSample / baseline);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * pipeline调度下预计算任务只能读PrepareTable拷贝的参数
+ * 在请求和RunPipeline之间改乱所有分音计算用到的参数(和GUI任务, Tick里的调制更新一样),
+ * RunPipeline之后改回来, 输出必须和没有改动时逐位相同
+ */
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <vector>
+#include "dsp/Lazerbass.hpp"
+
+using namespace dsp;
+
+static constexpr uint32_t kSampleRate = 32000;
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kBlockSize = 512;
+static constexpr uint32_t kNumBlocks = 60;
+
+static Lazerbass::PartialTable partialTables[Lazerbass::kNumPartialTables];
+static float effectMemory[EffectChain::kArenaSize];
+
+/* 分音计算用到的参数, scramble时换成另一组值并加上调制 */
+static void Configure(SynthParams& p, OscillatorType type, bool scramble) {
+    auto set = [scramble](FloatParamDesc& desc, float value, float other) {
+        desc.value = static_cast<int32_t>((scramble ? other : value) * FloatParamDesc::kScale);
+        if (scramble) {
+            desc.modulationValue = 0.3f;
+        }
+    };
+    auto setInt = [scramble](IntParamDesc& desc, int32_t value, int32_t other) {
+        desc.value = scramble ? other : value;
+    };
+
+    auto oscType = scramble ? (type == OscillatorType::kFullSaw ? OscillatorType::kMultiSquare : OscillatorType::kFullSaw) : type;
+    p.oscillor.type.value = static_cast<int32_t>(oscType);
+    setInt(p.oscillor.number, 3, 5);
+    set(p.oscillor.beating, 2.0f, 7.0f);
+    set(p.oscillor.transport, 3.0f, -5.0f);
+    set(p.oscillor.pluseWidth, 0.3f, 0.8f);
+    set(p.oscillor.fundamental, 1.0f, 0.2f);
+
+    p.dispersion.enable.value = !scramble;
+    set(p.dispersion.amount, 0.3f, -0.6f);
+    set(p.dispersion.key, 1.0f, 0.2f);
+    set(p.dispersion.shape, 0.0f, 0.7f);
+
+    p.ratioMul.enable.value = !scramble;
+    set(p.ratioMul.amount, 2.0f, -3.0f);
+    setInt(p.ratioMul.parttern, 6, 2);
+    p.ratioAdd.enable.value = scramble;
+    set(p.ratioAdd.amount, 0.3f, 4.0f);
+    setInt(p.ratioAdd.parttern, 4, 10);
+
+    p.partialBeating.enable.value = !scramble;
+    set(p.partialBeating.amount, 2.0f, 9.0f);
+    setInt(p.partialBeating.parttern, 8, 2);
+
+    p.attenuation.enable.value = !scramble;
+    setInt(p.attenuation.balance, 30, 90);
+    set(p.attenuation.symmetry, 0.2f, -0.8f);
+    setInt(p.attenuation.parttern, 4, 12);
+
+    p.periodFilter.enable.value = !scramble;
+    p.periodFilter.stretch.value = !scramble;
+    p.periodFilter.blocks.value = scramble;
+    set(p.periodFilter.peak, 0.3f, 0.9f);
+    set(p.periodFilter.apply, 1.0f, 0.1f);
+    set(p.periodFilter.cycle, 6.0f, 40.0f);
+    set(p.periodFilter.phaseShift, 0.0f, 0.5f);
+    set(p.periodFilter.pinch, 0.0f, 0.6f);
+
+    p.filter.enable.value = !scramble;
+    set(p.filter.brightness, 0.5f, 0.1f);
+    set(p.filter.key, 1.0f, 0.0f);
+    set(p.filter.floor, 0.5f, 1.0f);
+
+    p.pan.mode.value = static_cast<int32_t>(scramble ? PanMode::kRandom : PanMode::kSpread);
+    set(p.pan.width, 0.8f, 0.1f);
+    set(p.pan.center, 0.0f, -0.7f);
+
+    if (!scramble) {
+        // 没有连接调制的参数调制值为0, 连接的在下一个Tick重新写入
+        for (auto* desc : { &p.oscillor.transport, &p.oscillor.pluseWidth, &p.oscillor.fundamental,
+                            &p.dispersion.amount, &p.dispersion.key, &p.dispersion.shape,
+                            &p.ratioMul.amount, &p.ratioAdd.amount, &p.partialBeating.amount,
+                            &p.attenuation.symmetry, &p.periodFilter.peak, &p.periodFilter.apply,
+                            &p.periodFilter.cycle, &p.periodFilter.phaseShift, &p.periodFilter.pinch,
+                            &p.filter.brightness, &p.filter.key, &p.filter.floor,
+                            &p.pan.width, &p.pan.center }) {
+            desc->modulationValue = 0.0f;
+        }
+    }
+}
+
+static std::vector<StereoSample16> Render(OscillatorType type, bool stereo, bool scramble) {
+    auto synth = std::make_unique<Lazerbass>(partialTables, effectMemory);
+    synth->Init(kSampleRate, kUpdateRate);
+    auto& p = synth->GetParams();
+    p.render.schedule.value = static_cast<int32_t>(TickSchedule::kPipeline);
+    p.pan.enable.value = stereo;
+    Configure(p, type, false);
+
+    auto& bank = synth->GetModulationBank();
+    bool exist{};
+    auto* link = bank.AddNewLink(synth->GetModulatorDesc(ModulatorId::kLfo1), &p.oscillor.beating, exist);
+    link->amount = 0.2f;
+    bank.Compile();
+
+    synth->NoteOn(40, 1.0f);
+    std::vector<StereoSample16> out(kBlockSize * kNumBlocks);
+    for (uint32_t b = 0; b < kNumBlocks; ++b) {
+        if (b == kNumBlocks / 2) {
+            synth->NoteOn(52, 1.0f);
+        }
+        uint32_t pos = b * kBlockSize;
+        uint32_t end = pos + kBlockSize;
+        while (pos < end) {
+            uint32_t n = std::min(synth->GetSamplesToNextTick(), end - pos);
+            synth->Process(std::span<StereoSample16>{ out.data() + pos, n });
+            if (synth->IsPipelineRequested()) {
+                if (scramble) {
+                    Configure(p, type, true);
+                }
+                synth->RunPipeline();
+                if (scramble) {
+                    Configure(p, type, false);
+                }
+            }
+            pos += n;
+        }
+    }
+    return out;
+}
+
+int main() {
+    int numFailed = 0;
+    for (auto type : { OscillatorType::kFullSaw, OscillatorType::kMultiSquare, OscillatorType::kPwmSquare }) {
+        for (bool stereo : { false, true }) {
+            auto ref = Render(type, stereo, false);
+            auto out = Render(type, stereo, true);
+            auto diff = std::mismatch(ref.begin(), ref.end(), out.begin(), [](const auto& a, const auto& b) {
+                return a.left == b.left && a.right == b.right;
+            });
+            bool ok = diff.first == ref.end();
+            std::printf("%s type %d stereo %d", ok ? "ok  " : "FAIL", static_cast<int>(type), stereo);
+            if (!ok) {
+                std::printf(" first mismatch at sample %d", static_cast<int>(diff.first - ref.begin()));
+                ++numFailed;
+            }
+            std::printf("\n");
+        }
+    }
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/**
+ * 预设编码的往返: A的参数和link随机, 编码后解码到B再编码, 两次的字节必须相同
+ * 参数值通过改写编码里的value再解码到A来随机(Decode限制范围), link通过调制矩阵随机添加
+ * 另外检查不认识的id被跳过, crc错误, 更新的版本和太短的数据被拒绝
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include "preset/PresetCodec.hpp"
+
+using namespace preset;
+
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kUpdateRate = 200;
+static constexpr uint32_t kNumRounds = 500;
+
+static dsp::Lazerbass::PartialTable partialTablesA[dsp::Lazerbass::kNumPartialTables];
+static dsp::Lazerbass::PartialTable partialTablesB[dsp::Lazerbass::kNumPartialTables];
+static float effectMemoryA[dsp::EffectChain::kArenaSize];
+static float effectMemoryB[dsp::EffectChain::kArenaSize];
+static PresetCodec codecA;
+static PresetCodec codecB;
+static uint8_t bufferA[PresetCodec::kMaxSize];
+static uint8_t bufferB[PresetCodec::kMaxSize];
+static int numFailed = 0;
+
+static void CheckTrue(const char* name, bool value) {
+    std::printf("%s %s\n", value ? "ok  " : "FAIL", name);
+    if (!value) {
+        ++numFailed;
+    }
+}
+
+static void Store32(uint8_t* p, uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+static uint32_t Load32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/* 改写payload后重新计算header里的crc */
+static void UpdateCrc(uint8_t* data, uint32_t size) {
+    Store32(data + 12, PresetCodec::Crc32(std::span(data + PresetCodec::kHeaderSize, size - PresetCodec::kHeaderSize)));
+}
+
+static uint32_t Encode(PresetCodec& codec, uint8_t* out) {
+    codec.Capture();
+    return codec.Encode(std::span(out, PresetCodec::kMaxSize));
+}
+
+static void Randomize(PresetCodec& codec, dsp::Lazerbass& synth, std::mt19937& rng) {
+    // 参数: 编码现在的值, 把所有value换成随机数再解码回来
+    uint32_t size = Encode(codec, bufferA);
+    std::uniform_int_distribution<int32_t> small(-8, 8);
+    std::uniform_int_distribution<int32_t> large(-100000, 100000);
+    for (uint32_t i = 0; i < codec.GetNumParams(); ++i) {
+        uint8_t* value = bufferA + PresetCodec::kHeaderSize + i * PresetCodec::kValueSize + 4;
+        Store32(value, static_cast<uint32_t>(rng() & 1 ? small(rng) : large(rng)));
+    }
+    UpdateCrc(bufferA, size);
+    codec.Decode(std::span(bufferA, size));
+    codec.Apply();
+
+    // link: 随机的源(包括CC), 目标, 范围和曲线
+    auto& p = synth.GetParams();
+    dsp::FloatParamDesc* targets[] = {
+        &p.filter.brightness, &p.master.volume, &p.chorus.mix, &p.reverb.mix,
+        &p.oscillor.beating, &p.oscillor.transport, &p.oscillor.pluseWidth, &p.oscillor.pitch,
+    };
+    auto& bank = synth.GetModulationBank();
+    bank.RemoveAllLinks();
+    constexpr uint32_t kNumModulators = static_cast<uint32_t>(dsp::ModulatorId::kCount);
+    std::uniform_int_distribution<uint32_t> source(0, kNumModulators + dsp::MidiModulators::kNumControllers - 1);
+    std::uniform_real_distribution<float> amount(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    const uint32_t numLinks = std::uniform_int_distribution<uint32_t>(0, dsp::ModulationBank::kMaxNumModulations)(rng);
+    for (uint32_t i = 0; i < numLinks; ++i) {
+        const uint32_t m = source(rng);
+        const auto desc = m < kNumModulators
+            ? synth.GetModulatorDesc(static_cast<dsp::ModulatorId>(m))
+            : synth.GetControllerModulatorDesc(m - kNumModulators + 1);
+        bool exist{};
+        auto* link = bank.AddNewLink(desc, targets[rng() % std::size(targets)], exist);
+        if (link == nullptr || exist) {
+            continue;
+        }
+        link->amount = amount(rng);
+        link->offset = offset(rng);
+        link->enable = rng() & 1;
+        link->symmetric = rng() & 1;
+        link->curve = static_cast<dsp::ModulationCurve>(rng() % static_cast<uint32_t>(dsp::ModulationCurve::kCount));
+    }
+    bank.Compile();
+}
+
+int main() {
+    auto synthA = std::make_unique<dsp::Lazerbass>(partialTablesA, effectMemoryA);
+    auto synthB = std::make_unique<dsp::Lazerbass>(partialTablesB, effectMemoryB);
+    synthA->Init(kSampleRate, kUpdateRate);
+    synthB->Init(kSampleRate, kUpdateRate);
+    codecA.Init(*synthA);
+    codecB.Init(*synthB);
+
+    std::mt19937 rng(1);
+    bool roundTrip = true;
+    uint32_t maxLinks = 0;
+    for (uint32_t round = 0; round < kNumRounds && roundTrip; ++round) {
+        Randomize(codecA, *synthA, rng);
+        const uint32_t sizeA = Encode(codecA, bufferA);
+        const auto result = codecB.Decode(std::span(bufferA, sizeA));
+        codecB.Apply();
+        const uint32_t sizeB = Encode(codecB, bufferB);
+        roundTrip = result == PresetCodec::Result::kOk
+            && codecB.GetNumSkipped() == 0
+            && sizeA != 0
+            && sizeA == sizeB
+            && std::memcmp(bufferA, bufferB, sizeA) == 0
+            && synthA->GetModulationBank().GetLinks().size() == synthB->GetModulationBank().GetLinks().size();
+        maxLinks = std::max<uint32_t>(maxLinks, codecB.GetNumDecodedLinks());
+        if (!roundTrip) {
+            std::printf("round %u: %s, skipped %u, size %u vs %u\n", round, PresetCodec::kResultNames[static_cast<int>(result)],
+                        codecB.GetNumSkipped(), sizeA, sizeB);
+        }
+    }
+    CheckTrue("round trip", roundTrip);
+    CheckTrue("links up to the bank size", maxLinks > dsp::ModulationBank::kMaxNumModulations / 2);
+
+    // 不认识的参数id跳过, 这个参数回到默认值, 再编码时id是原来的
+    Randomize(codecA, *synthA, rng);
+    const uint32_t size = Encode(codecA, bufferA);
+    uint8_t* firstId = bufferA + PresetCodec::kHeaderSize;
+    Store32(firstId, Load32(firstId) ^ 0xffu);
+    UpdateCrc(bufferA, size);
+    CheckTrue("unknown id decodes", codecB.Decode(std::span(bufferA, size)) == PresetCodec::Result::kOk);
+    CheckTrue("unknown id skipped", codecB.GetNumSkipped() == 1);
+    codecB.Apply();
+    Encode(codecB, bufferB);
+    CheckTrue("unknown id re-encoded", Load32(bufferB + PresetCodec::kHeaderSize) == (Load32(firstId) ^ 0xffu));
+
+    bufferA[PresetCodec::kHeaderSize + 4] ^= 1;
+    CheckTrue("bad crc", codecB.Decode(std::span(bufferA, size)) == PresetCodec::Result::kBadCrc);
+    bufferA[4] = PresetCodec::kVersion + 1;
+    CheckTrue("newer version", codecB.Decode(std::span(bufferA, size)) == PresetCodec::Result::kNewerVersion);
+    bufferA[0] ^= 1;
+    CheckTrue("bad magic", codecB.Decode(std::span(bufferA, size)) == PresetCodec::Result::kBadMagic);
+    CheckTrue("too short", codecB.Decode(std::span(bufferA, PresetCodec::kHeaderSize - 1)) == PresetCodec::Result::kTooShort);
+    Encode(codecA, bufferA);
+    CheckTrue("truncated", codecB.Decode(std::span(bufferA, size - 1)) == PresetCodec::Result::kTooShort);
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#include "bsp/Time.hpp"
+#include <chrono>
+
+namespace bsp {
+
+/* 主机上没有DWT, 用纳秒代替周期数, 只有dsp里的计时统计使用 */
+uint32_t Time::GetCycles() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+}
@@ -0,0 +1,48 @@
+# TCM热区报告: cmake -DNM=arm-none-eabi-nm -DELF=Lazerbass.elf -P tcm_report.cmake
+# 热区的边界和预算都是链接脚本里的符号, 打印每个热区的占用和里面的符号(从大到小)
+
+execute_process(COMMAND ${NM} ${ELF} OUTPUT_VARIABLE all_symbols RESULT_VARIABLE res)
+if(NOT res EQUAL 0)
+    message(FATAL_ERROR "tcm_report: ${NM} failed")
+endif()
+
+execute_process(COMMAND ${NM} -S -C --size-sort -r ${ELF} OUTPUT_VARIABLE sized_symbols RESULT_VARIABLE res)
+if(NOT res EQUAL 0)
+    message(FATAL_ERROR "tcm_report: ${NM} failed")
+endif()
+# 去掉会破坏cmake列表的字符
+string(REPLACE ";" "," sized_symbols "${sized_symbols}")
+string(REPLACE "[" "(" sized_symbols "${sized_symbols}")
+string(REPLACE "]" ")" sized_symbols "${sized_symbols}")
+string(REPLACE "\n" ";" sized_symbols "${sized_symbols}")
+
+function(get_symbol name out)
+    if(NOT all_symbols MATCHES "([0-9a-fA-F]+) [A-Za-z] ${name}\n")
+        message(FATAL_ERROR "tcm_report: symbol ${name} not found")
+    endif()
+    math(EXPR value "0x${CMAKE_MATCH_1}")
+    set(${out} ${value} PARENT_SCOPE)
+endfunction()
+
+function(report title begin_name end_name budget_name)
+    get_symbol(${begin_name} begin)
+    get_symbol(${end_name} end)
+    get_symbol(${budget_name} budget)
+    math(EXPR used "${end} - ${begin}")
+    math(EXPR percent "${used} * 100 / ${budget}")
+    message("${title}: ${used} / ${budget} bytes (${percent}%)")
+    foreach(line IN LISTS sized_symbols)
+        if(line MATCHES "^([0-9a-fA-F]+) ([0-9a-fA-F]+) [A-Za-z] (.*)$")
+            set(name "${CMAKE_MATCH_3}")
+            set(size_hex "${CMAKE_MATCH_2}")
+            math(EXPR addr "0x${CMAKE_MATCH_1}")
+            if(addr GREATER_EQUAL begin AND addr LESS end)
+                math(EXPR size "0x${size_hex}")
+                message("  ${size}\t${name}")
+            endif()
+        endif()
+    endforeach()
+endfunction()
+
+report("ITCM hot code" _specify_itcmram_ram_start _specify_itcmram_ram_end _Itcm_Hot_Budget)
+report("DTCM hot data" _dtcm_hot_start _dtcm_hot_end _Dtcm_Hot_Budget)